@@ -14,7 +14,11 @@
 #include <initializer_list>
 #include <iterator>
 #include <algorithm>
+#include <atomic>
+#include <cstdint>
 #include <map>
+#include <mutex>
+#include <stdexcept>
 #include <type_traits>
 #include <unordered_map>
 #include <vector>
@@ -24,7 +28,9 @@
 #include "xtensor/xbuilder.hpp"
 
 #include "xaxis_base.hpp"
+#include "xflat_hash_map.hpp"
 #include "xframe_utils.hpp"
+#include "xsorted_vector_map.hpp"
 
 namespace xf
 {
@@ -34,12 +40,17 @@ namespace xf
     template <class L, class T>
     class xaxis_default;
 
+    template <class L, class T>
+    class xaxis_arange;
+
     /*********************
      * map container tag *
      *********************/
 
     struct map_tag {};
     struct hash_map_tag {};
+    struct sorted_vector_tag {};
+    struct flat_hash_map_tag {};
 
     template <class K, class T, class MT>
     struct map_container;
@@ -56,9 +67,164 @@ namespace xf
         using type = std::unordered_map<K, T>;
     };
 
+    template <class K, class T>
+    struct map_container<K, T, sorted_vector_tag>
+    {
+        using type = xsorted_vector_map<K, T>;
+    };
+
+    template <class K, class T>
+    struct map_container<K, T, flat_hash_map_tag>
+    {
+        using type = xflat_hash_map<K, T>;
+    };
+
     template <class K, class T, class MT>
     using map_container_t = typename map_container<K, T, MT>::type;
 
+    namespace detail
+    {
+        template <class M, class LL>
+        inline void fill_index(M& index, const LL& labels)
+        {
+            for (typename LL::size_type i = 0; i < labels.size(); ++i)
+            {
+                index[labels[i]] = typename M::mapped_type(i);
+            }
+        }
+
+        template <class K, class T, class LL>
+        inline void fill_index(xsorted_vector_map<K, T>& index, const LL& labels)
+        {
+            index.assign(labels);
+        }
+
+        template <class K, class T, class LL>
+        inline void fill_index(xflat_hash_map<K, T>& index, const LL& labels)
+        {
+            index.assign(labels);
+        }
+
+        template <class M, class It, class O>
+        inline void find_positions(const M& index, It first, It last, O out)
+        {
+            for (; first != last; ++first, ++out)
+            {
+                auto iter = index.find(*first);
+                if (iter == index.end())
+                {
+                    throw std::out_of_range("xaxis: label not found");
+                }
+                *out = iter->second;
+            }
+        }
+
+        // Hashes a batch of labels and prefetches their probe groups
+        // before probing any of them, so that the cache misses of the
+        // batch overlap.
+        template <class K, class T, class It, class O>
+        inline void find_positions(const xflat_hash_map<K, T>& index, It first, It last, O out)
+        {
+            constexpr std::size_t batch_size = 16;
+            std::uint64_t hashes[batch_size];
+            while (first != last)
+            {
+                std::size_t n = 0;
+                for (It iter = first; iter != last && n != batch_size; ++iter, ++n)
+                {
+                    hashes[n] = index.hash(*iter);
+                    index.prefetch(hashes[n]);
+                }
+                for (std::size_t i = 0; i != n; ++i, ++first, ++out)
+                {
+                    auto iter = index.find(*first, hashes[i]);
+                    if (iter == index.end())
+                    {
+                        throw std::out_of_range("xaxis: label not found");
+                    }
+                    *out = iter->second;
+                }
+            }
+        }
+
+        // Appends to added the labels of [first, last) missing from index,
+        // in the order they are first seen. Each new label is recorded in
+        // index with the position it gets when appended after offset labels;
+        // returns true since index stays valid for an append.
+        template <class M, class It, class LL>
+        inline bool find_new_labels(M& index, It first, It last, LL& added, std::size_t offset)
+        {
+            for (; first != last; ++first)
+            {
+                auto size = index.size();
+                auto& pos = index[*first];
+                if (index.size() != size)
+                {
+                    pos = static_cast<typename M::mapped_type>(offset + added.size());
+                    added.push_back(*first);
+                }
+            }
+            return true;
+        }
+
+        // Inserting in an xsorted_vector_map is linear, so the map is only
+        // probed; repeated new labels are removed with a sort of their
+        // positions, and the map must be rebuilt afterwards.
+        template <class K, class T, class It, class LL>
+        inline bool find_new_labels(xsorted_vector_map<K, T>& index, It first, It last, LL& added, std::size_t /*offset*/)
+        {
+            for (; first != last; ++first)
+            {
+                if (index.find(*first) == index.cend())
+                {
+                    added.push_back(*first);
+                }
+            }
+            std::vector<std::size_t> order(added.size());
+            for (std::size_t i = 0; i < order.size(); ++i)
+            {
+                order[i] = i;
+            }
+            std::stable_sort(order.begin(), order.end(), [&added](std::size_t lhs, std::size_t rhs) { return added[lhs] < added[rhs]; });
+            std::vector<bool> repeated(added.size(), false);
+            for (std::size_t i = 1; i < order.size(); ++i)
+            {
+                repeated[order[i]] = added[order[i]] == added[order[i - 1]];
+            }
+            std::size_t w = 0;
+            for (std::size_t i = 0; i < added.size(); ++i)
+            {
+                if (!repeated[i])
+                {
+                    if (w != i)
+                    {
+                        added[w] = std::move(added[i]);
+                    }
+                    ++w;
+                }
+            }
+            added.erase(added.begin() + static_cast<std::ptrdiff_t>(w), added.end());
+            return false;
+        }
+
+        // Returns the first element of [first, last) not less than key,
+        // probing positions at exponentially growing distances from first.
+        // The cost is logarithmic in the distance to the result, so a scan
+        // of sorted keys through sorted labels is linear in the worst case
+        // and much cheaper when the keys are sparse.
+        template <class It, class K>
+        inline It gallop_lower_bound(It first, It last, const K& key)
+        {
+            typename std::iterator_traits<It>::difference_type step = 1;
+            while (step < last - first && first[step] < key)
+            {
+                first += step;
+                step *= 2;
+            }
+            return std::lower_bound(first, step < last - first ? first + step : last, key);
+        }
+    }
+
     /*********
      * xaxis *
      *********/
@@ -75,8 +241,17 @@ namespace xf
      * @tparam T the integer type used to represent positions. Default value is
      *           \c std::size_t.
      * @tparam MT the tag used for choosing the map type which holds the label-
-     *            position pairs. Possible values are \c map_tag and \c hash_map_tag.
-     *            Default value is \c hash_map_tag.
+     *            position pairs. Possible values are \c map_tag, \c hash_map_tag,
+     *            \c sorted_vector_tag and \c flat_hash_map_tag. Default value is
+     *            \c hash_map_tag. \c sorted_vector_tag stores the pairs in a single
+     *            sorted array, which avoids a node allocation per label and is best
+     *            suited to axes whose labels are already sorted. \c flat_hash_map_tag
+     *            uses an open-addressing table, which suits large unsorted axes.
+     *
+     * The label - position map is built on the first lookup that needs it, and
+     * concurrent lookups on a const axis are safe. Sorted axes answer \c contains,
+     * \c operator[] and \c find with a binary search over the labels, and only
+     * build the map when their iterators are dereferenced.
      */
     template <class L, class T = std::size_t, class MT = hash_map_tag>
     class xaxis : public xaxis_base<xaxis<L, T, MT>>
@@ -109,14 +284,26 @@ namespace xf
         template <class L1>
         explicit xaxis(xaxis_default<L1, T> axis);
 
+        template <class L1>
+        explicit xaxis(const xaxis_arange<L1, T>& axis);
+
         template <class InputIt>
         xaxis(InputIt first, InputIt last);
 
+        xaxis(const self_type& rhs);
+        xaxis(self_type&& rhs) noexcept;
+
+        self_type& operator=(const self_type& rhs);
+        self_type& operator=(self_type&& rhs) noexcept;
+
         bool is_sorted() const noexcept;
 
         bool contains(const key_type& key) const;
         mapped_type operator[](const key_type& key) const;
 
+        template <class R, class O>
+        void index_of(const R& labels, O& positions) const;
+
         template <class F>
         self_type filter(const F& f) const noexcept;
 
@@ -136,7 +323,7 @@ namespace xf
 
     protected:
 
-        void populate_index();
+        void reset_index() noexcept;
         void set_labels(const label_list& labels);
 
         template <class Arg, class... Args>
@@ -152,7 +339,12 @@ namespace xf
         xaxis(const label_list& labels, bool is_sorted);
         xaxis(label_list&& labels, bool is_sorted);
 
+        const map_type& index() const;
         typename map_type::const_iterator find_index(const key_type& key) const;
+        bool find_sorted(const key_type& key, mapped_type& pos) const;
+
+        template <class It>
+        void merge_hashed(It first, It last, bool prepend);
 
         template <class... Args>
         bool merge_impl(const Args&... axes);
@@ -169,11 +361,14 @@ namespace xf
         template <class Arg>
         bool all_sorted(const Arg& a) const noexcept;
 
-        map_type m_index;
+        mutable map_type m_index;
+        mutable std::atomic<bool> m_index_built;
+        mutable std::mutex m_index_mutex;
         bool m_is_sorted;
 
         friend class xaxis_iterator<L, T, MT>;
         friend class xaxis_default<L, T>;
+        friend class xaxis_arange<L, T>;
     };
 
     template <class L, class T, class MT, class... Args>
@@ -276,7 +471,7 @@ namespace xf
      */
     template <class L, class T, class MT>
     inline xaxis<L, T, MT>::xaxis()
-        : base_type(), m_index(), m_is_sorted(true)
+        : base_type(), m_index(), m_index_built(false), m_is_sorted(true)
     {
     }
 
@@ -288,10 +483,9 @@ namespace xf
      */
     template <class L, class T, class MT>
     inline xaxis<L, T, MT>::xaxis(const label_list& labels)
-        : base_type(labels), m_index(), m_is_sorted()
+        : base_type(labels), m_index(), m_index_built(false), m_is_sorted()
     {
         m_is_sorted = init_is_sorted();
-        populate_index();
     }
 
     /**
@@ -303,10 +497,9 @@ namespace xf
      */
     template <class L, class T, class MT>
     inline xaxis<L, T, MT>::xaxis(label_list&& labels)
-        : base_type(std::move(labels)), m_index(), m_is_sorted()
+        : base_type(std::move(labels)), m_index(), m_index_built(false), m_is_sorted()
     {
         m_is_sorted = init_is_sorted();
-        populate_index();
     }
 
     /**
@@ -320,9 +513,8 @@ namespace xf
      */
     template <class L, class T, class MT>
     inline xaxis<L, T, MT>::xaxis(const label_list& labels, bool is_sorted)
-        : base_type(labels), m_index(), m_is_sorted(is_sorted)
+        : base_type(labels), m_index(), m_index_built(false), m_is_sorted(is_sorted)
     {
-        populate_index();
     }
     /**
      * Constructs an axis with the given list of labels, and a boolean
@@ -337,9 +529,8 @@ namespace xf
 
     template <class L, class T, class MT>
     inline xaxis<L, T, MT>::xaxis(label_list&& labels, bool is_sorted)
-        : base_type(labels), m_index(), m_is_sorted(is_sorted)
+        : base_type(std::move(labels)), m_index(), m_index_built(false), m_is_sorted(is_sorted)
     {
-        populate_index();
     }
 
     /**
@@ -348,10 +539,9 @@ namespace xf
      */
     template <class L, class T, class MT>
     inline xaxis<L, T, MT>::xaxis(std::initializer_list<key_type> init)
-        : base_type(init), m_index(), m_is_sorted()
+        : base_type(init), m_index(), m_index_built(false), m_is_sorted()
     {
         m_is_sorted = init_is_sorted();
-        populate_index();
     }
 
     /**
@@ -361,11 +551,21 @@ namespace xf
     template <class L, class T, class MT>
     template <class L1>
     inline xaxis<L, T, MT>::xaxis(xaxis_default<L1, T> axis)
-        : base_type(axis.labels()), m_index(), m_is_sorted(true)
+        : base_type(axis.labels()), m_index(), m_index_built(false), m_is_sorted(true)
     {
         static_assert(std::is_same<L, L1>::value, "key_type L and key_type L1 must be the same");
+    }
 
-        populate_index();
+    /**
+     * Constructs an axis from an \c arange_axis.
+     * @sa arange_axis
+     */
+    template <class L, class T, class MT>
+    template <class L1>
+    inline xaxis<L, T, MT>::xaxis(const xaxis_arange<L1, T>& axis)
+        : base_type(axis.labels()), m_index(), m_index_built(false), m_is_sorted(axis.is_sorted())
+    {
+        static_assert(std::is_same<L, L1>::value, "key_type L and key_type L1 must be the same");
     }
 
     /**
@@ -376,10 +576,77 @@ namespace xf
     template <class L, class T, class MT>
     template <class InputIt>
     inline xaxis<L, T, MT>::xaxis(InputIt first, InputIt last)
-        : base_type(first, last), m_index(), m_is_sorted()
+        : base_type(first, last), m_index(), m_index_built(false), m_is_sorted()
     {
         m_is_sorted = init_is_sorted();
-        populate_index();
+    }
+
+    /**
+     * Copy constructor. The label - position map is copied only if it
+     * has already been built.
+     */
+    template <class L, class T, class MT>
+    inline xaxis<L, T, MT>::xaxis(const self_type& rhs)
+        : base_type(rhs), m_index(), m_index_built(false), m_is_sorted(rhs.m_is_sorted)
+    {
+        if (rhs.m_index_built.load(std::memory_order_acquire))
+        {
+            m_index = rhs.m_index;
+            m_index_built.store(true, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * Move constructor.
+     */
+    template <class L, class T, class MT>
+    inline xaxis<L, T, MT>::xaxis(self_type&& rhs) noexcept
+        : base_type(std::move(rhs)), m_index(std::move(rhs.m_index)),
+          m_index_built(rhs.m_index_built.load(std::memory_order_acquire)), m_is_sorted(rhs.m_is_sorted)
+    {
+        rhs.m_index_built.store(false, std::memory_order_relaxed);
+    }
+
+    /**
+     * Copy assignment operator. The label - position map is copied only
+     * if it has already been built.
+     */
+    template <class L, class T, class MT>
+    inline auto xaxis<L, T, MT>::operator=(const self_type& rhs) -> self_type&
+    {
+        if (this != &rhs)
+        {
+            base_type::operator=(rhs);
+            m_is_sorted = rhs.m_is_sorted;
+            bool built = rhs.m_index_built.load(std::memory_order_acquire);
+            if (built)
+            {
+                m_index = rhs.m_index;
+            }
+            else
+            {
+                m_index.clear();
+            }
+            m_index_built.store(built, std::memory_order_relaxed);
+        }
+        return *this;
+    }
+
+    /**
+     * Move assignment operator.
+     */
+    template <class L, class T, class MT>
+    inline auto xaxis<L, T, MT>::operator=(self_type&& rhs) noexcept -> self_type&
+    {
+        if (this != &rhs)
+        {
+            base_type::operator=(std::move(rhs));
+            m_is_sorted = rhs.m_is_sorted;
+            m_index = std::move(rhs.m_index);
+            m_index_built.store(rhs.m_index_built.load(std::memory_order_acquire), std::memory_order_relaxed);
+            rhs.m_index_built.store(false, std::memory_order_relaxed);
+        }
+        return *this;
     }
     //@}
 
@@ -403,7 +670,8 @@ namespace xf
     template <class L, class T, class MT>
     inline bool xaxis<L, T, MT>::contains(const key_type& key) const
     {
-        return m_index.count(key) != typename map_type::size_type(0);
+        mapped_type pos;
+        return m_is_sorted ? find_sorted(key, pos) : index().count(key) != typename map_type::size_type(0);
     }
 
     /**
@@ -414,7 +682,70 @@ namespace xf
     template <class L, class T, class MT>
     inline auto xaxis<L, T, MT>::operator[](const key_type& key) const -> mapped_type
     {
-        return m_index.at(key);
+        if (m_is_sorted)
+        {
+            mapped_type pos;
+            if (!find_sorted(key, pos))
+            {
+                throw std::out_of_range("xaxis: label not found");
+            }
+            return pos;
+        }
+        return index().at(key);
+    }
+
+    /**
+     * Stores in \c positions the positions of the specified labels, as
+     * operator[] would for each of them. When the axis and the labels are
+     * both sorted, the positions are found in a single merge scan; otherwise
+     * the labels are looked up by batches in the label - position map. If a
+     * label is not found, an exception is thrown.
+     * @param labels the range of labels to search for.
+     * @param positions the container receiving the positions. It is resized
+     *        to the number of labels.
+     */
+    template <class L, class T, class MT>
+    template <class R, class O>
+    inline void xaxis<L, T, MT>::index_of(const R& labels, O& positions) const
+    {
+        positions.resize(labels.size());
+        auto first = labels.begin();
+        auto last = labels.end();
+        auto out = positions.begin();
+        if (!m_is_sorted)
+        {
+            detail::find_positions(index(), first, last, out);
+        }
+        else if (std::is_sorted(first, last))
+        {
+            const label_list& al = this->labels();
+            auto iter = al.cbegin();
+            for (; first != last; ++first, ++out)
+            {
+                iter = detail::gallop_lower_bound(iter, al.cend(), *first);
+                if (iter == al.cend() || !(*iter == *first))
+                {
+                    throw std::out_of_range("xaxis: label not found");
+                }
+                while (iter + 1 != al.cend() && *(iter + 1) == *first)
+                {
+                    ++iter;
+                }
+                *out = static_cast<mapped_type>(iter - al.cbegin());
+            }
+        }
+        else
+        {
+            for (; first != last; ++first, ++out)
+            {
+                mapped_type pos;
+                if (!find_sorted(*first, pos))
+                {
+                    throw std::out_of_range("xaxis: label not found");
+                }
+                *out = pos;
+            }
+        }
     }
     //@}
 
@@ -460,8 +791,14 @@ namespace xf
     template <class L, class T, class MT>
     inline auto xaxis<L, T, MT>::find(const key_type& key) const -> const_iterator
     {
-        auto map_iter = m_index.find(key);
-        return map_iter != m_index.end() ? cbegin() + map_iter->second : cend();
+        if (m_is_sorted)
+        {
+            mapped_type pos;
+            return find_sorted(key, pos) ? cbegin() + pos : cend();
+        }
+        const map_type& idx = index();
+        auto map_iter = idx.find(key);
+        return map_iter != idx.end() ? cbegin() + map_iter->second : cend();
     }
 
     /**
@@ -516,7 +853,7 @@ namespace xf
         if (all_sorted(*this, axes...))
         {
             res = intersect_to(this->mutable_labels(), axes.labels()...);
-            populate_index();
+            reset_index();
         }
         else
         {
@@ -526,26 +863,87 @@ namespace xf
     }
     //@}
 
+    // Marks the label - position map as outdated; it is rebuilt on
+    // the next lookup that needs it. Must not be called concurrently
+    // with lookups.
     template <class L, class T, class MT>
-    inline void xaxis<L, T, MT>::populate_index()
+    inline void xaxis<L, T, MT>::reset_index() noexcept
     {
-        for(size_type i = 0; i < this->labels().size(); ++i)
-        {
-            m_index[this->labels()[i]] = T(i);
-        }
+        m_index_built.store(false, std::memory_order_relaxed);
     }
 
     template <class L, class T, class MT>
     void xaxis<L, T, MT>::set_labels(const label_list& labels)
     {
         this->mutable_labels() = labels;
-        populate_index();
+        m_is_sorted = init_is_sorted();
+        reset_index();
+    }
+
+    // Builds the label - position map if needed. The double-checked
+    // flag keeps the common path, where the map is already built, free
+    // of locking.
+    template <class L, class T, class MT>
+    inline auto xaxis<L, T, MT>::index() const -> const map_type&
+    {
+        if (!m_index_built.load(std::memory_order_acquire))
+        {
+            std::lock_guard<std::mutex> lock(m_index_mutex);
+            if (!m_index_built.load(std::memory_order_relaxed))
+            {
+                m_index.clear();
+                detail::fill_index(m_index, this->labels());
+                m_index_built.store(true, std::memory_order_release);
+            }
+        }
+        return m_index;
     }
 
     template <class L, class T, class MT>
     inline auto xaxis<L, T, MT>::find_index(const key_type& key) const -> typename map_type::const_iterator
     {
-        return m_index.find(key);
+        return index().find(key);
+    }
+
+    // Binary search over sorted labels. When a label appears several
+    // times, its last position is returned, as the map would.
+    template <class L, class T, class MT>
+    inline bool xaxis<L, T, MT>::find_sorted(const key_type& key, mapped_type& pos) const
+    {
+        const label_list& labels = this->labels();
+        auto it = std::upper_bound(labels.cbegin(), labels.cend(), key);
+        if (it == labels.cbegin() || !(*(it - 1) == key))
+        {
+            return false;
+        }
+        pos = static_cast<mapped_type>(it - 1 - labels.cbegin());
+        return true;
+    }
+
+    // Adds the labels of [first, last) missing from this axis, in the
+    // order they are first seen, before or after the existing labels.
+    // Each label is looked up once in the label - position map, which
+    // is reused if it is already built. With hash maps, new labels are
+    // recorded in the map as they are found, so that the map stays valid
+    // after an append and can be reused by the next join.
+    template <class L, class T, class MT>
+    template <class It>
+    inline void xaxis<L, T, MT>::merge_hashed(It first, It last, bool prepend)
+    {
+        index();
+        auto& labels = this->mutable_labels();
+        label_list added;
+        bool valid = detail::find_new_labels(m_index, first, last, added, labels.size());
+        if (prepend || !valid)
+        {
+            labels.insert(prepend ? labels.begin() : labels.end(),
+                          std::make_move_iterator(added.begin()), std::make_move_iterator(added.end()));
+            reset_index();
+        }
+        else
+        {
+            labels.insert(labels.end(), std::make_move_iterator(added.begin()), std::make_move_iterator(added.end()));
+        }
     }
 
     template <class L, class T, class MT>
@@ -556,15 +954,11 @@ namespace xf
         if(all_sorted(*this, axes...))
         {
             res = merge_to(this->mutable_labels(), axes.labels()...);
-            populate_index();
+            reset_index();
         }
         else
         {
             m_is_sorted = false;
-            if (m_index.empty())
-            {
-                populate_index();
-            }
             res = merge_unsorted(false, axes.labels()...);
         }
         return res;
@@ -575,6 +969,8 @@ namespace xf
     inline bool xaxis<L, T, MT>::merge_empty(const Arg1& a, const Args&... axes)
     {
         this->mutable_labels() = a.labels();
+        m_is_sorted = a.is_sorted();
+        reset_index();
         return merge_impl(axes...);
     }
 
@@ -628,29 +1024,15 @@ namespace xf
         }
         else if(output_iter == output_end)
         {
-            std::copy(a.begin(), a.begin() + std::distance(input_iter, input_end),
-                      std::inserter(labels, labels.begin()));
-            populate_index();
+            labels.insert(labels.begin(), a.begin(), a.begin() + std::distance(input_iter, input_end));
+            m_is_sorted = m_is_sorted && init_is_sorted();
+            reset_index();
             res &= broadcasting;
         }
         else
         {
-            while(input_iter != input_end)
-            {
-                if(!contains(*input_iter))
-                {
-                    if(output_iter != labels.rbegin())
-                    {
-                        labels.insert(labels.begin(), *input_iter);
-                    }
-                    else
-                    {
-                        labels.push_back(*input_iter);
-                    }
-                }
-                ++input_iter;
-            }
-            populate_index();
+            merge_hashed(a.begin(), a.begin() + std::distance(input_iter, input_end), output_iter != labels.rbegin());
+            m_is_sorted = m_is_sorted && init_is_sorted();
             res = false;
         }
         return res;
@@ -662,37 +1044,52 @@ namespace xf
         return true;
     }
 
+    // Probes the label - position map of this axis with each label of
+    // the input, so that the intersection is linear in the size of both
+    // lists. The order of the labels of this axis is kept.
     template <class L, class T, class MT>
     template <class Arg, class... Args>
     inline bool xaxis<L, T, MT>::intersect_unsorted(const Arg& al, const Args&... axes_labels)
     {
         bool res = intersect_unsorted(axes_labels...);
+        const map_type& idx = index();
         auto& labels = this->mutable_labels();
-        auto iter = labels.begin();
-        auto iter_end = labels.end();
-        bool must_populate = false;
-        while (iter != iter_end)
+        const size_type npos = size_type(-1);
+        // Position in al of the first occurrence of each label of this axis.
+        std::vector<size_type> found(labels.size(), npos);
+        for (size_type j = 0; j < al.size(); ++j)
+        {
+            auto it = idx.find(al[j]);
+            if (it != idx.end() && found[static_cast<size_type>(it->second)] == npos)
+            {
+                found[static_cast<size_type>(it->second)] = j;
+            }
+        }
+        // The map holds the last position of a repeated label only.
+        bool unique = idx.size() == labels.size();
+        size_type w = 0;
+        for (size_type i = 0; i < labels.size(); ++i)
         {
-            auto it = std::find(al.begin(), al.end(), *iter);
-            if (it == al.end())
+            size_type pos = unique ? found[i] : found[static_cast<size_type>(idx.find(labels[i])->second)];
+            if (pos == npos)
             {
-                iter = labels.erase(iter, iter + 1);
-                iter_end = labels.end();
                 res = false;
-                must_populate = true;
+                continue;
             }
-            else
+            if (pos != w)
             {
-                if (it - al.begin() != iter - labels.begin())
-                {
-                    res = false;
-                }
-                ++iter;
+                res = false;
+            }
+            if (w != i)
+            {
+                labels[w] = std::move(labels[i]);
             }
+            ++w;
         }
-        if (must_populate)
+        if (w != labels.size())
         {
-            populate_index();
+            labels.erase(labels.begin() + static_cast<difference_type>(w), labels.end());
+            reset_index();
         }
         return res;
     }
@@ -0,0 +1,1043 @@
+/***************************************************************************
+* Copyright (c) Johan Mabille, Sylvain Corlay, Wolf Vollprecht and         *
+* Martin Renou                                                             *
+* Copyright (c) QuantStack                                                 *
+*                                                                          *
+* Distributed under the terms of the BSD 3-Clause License.                 *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#ifndef XFRAME_XAXIS_ARANGE_HPP
+#define XFRAME_XAXIS_ARANGE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <iterator>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "xtl/xiterator_base.hpp"
+
+#include "xaxis_base.hpp"
+#include "xaxis.hpp"
+
+namespace xf
+{
+    template <class L, class T>
+    class xaxis_arange_iterator;
+
+    /****************
+     * xaxis_arange *
+     ****************/
+
+    /**
+     * @class xaxis_arange
+     * @brief Axis holding an arithmetic progression of labels.
+     *
+     * The xaxis_arange class is used for modeling an axis whose labels
+     * are start, start + step, start + 2 * step, ... Unlike xaxis, it
+     * does not hold any label - position map: positions are computed
+     * from the labels in constant time. The list of labels is only
+     * built when labels() is called. Merging or intersecting ranges
+     * with the same step and aligned starts gives a range again.
+     *
+     * @tparam L the type of labels. This must be an arithmetic type.
+     * @tparam T the integer type used to represent positions. Default value is
+     *           \c std::size_t.
+     */
+    template <class L, class T = std::size_t>
+    class xaxis_arange : public xaxis_base<xaxis_arange<L, T>>
+    {
+    public:
+
+        using base_type = xaxis_base<xaxis_arange>;
+        using self_type = xaxis_arange<L, T>;
+        using axis_type = xaxis<L, T>;
+        using key_type = typename base_type::key_type;
+        using label_list = typename base_type::label_list;
+        using mapped_type = typename base_type::mapped_type;
+        using value_type = std::pair<key_type, mapped_type>;
+        using reference = value_type&;
+        using const_reference = const value_type&;
+        using pointer = value_type*;
+        using const_pointer = const value_type*;
+        using size_type = typename base_type::size_type;
+        using difference_type = typename base_type::difference_type;
+        using iterator = typename base_type::iterator;
+        using const_iterator = typename base_type::const_iterator;
+        using reverse_iterator = typename base_type::reverse_iterator;
+        using const_reverse_iterator = typename base_type::const_reverse_iterator;
+
+        static_assert(std::is_arithmetic<key_type>::value, "key_type L must be an arithmetic type");
+
+        explicit xaxis_arange(key_type start = key_type(0), key_type step = key_type(1), size_type size = 0);
+
+        xaxis_arange(const self_type& rhs);
+        xaxis_arange(self_type&& rhs) noexcept;
+
+        self_type& operator=(const self_type& rhs);
+        self_type& operator=(self_type&& rhs) noexcept;
+
+        const label_list& labels() const;
+        key_type label(size_type i) const noexcept;
+
+        bool empty() const noexcept;
+        size_type size() const noexcept;
+
+        key_type start() const noexcept;
+        key_type step() const noexcept;
+
+        bool is_sorted() const noexcept;
+
+        bool contains(const key_type& key) const;
+        mapped_type operator[](const key_type& key) const;
+
+        template <class R, class O>
+        void index_of(const R& labels, O& positions) const;
+
+        template <class F>
+        axis_type filter(const F& f) const noexcept;
+
+        template <class F>
+        axis_type filter(const F& f, size_type size) const noexcept;
+
+        const_iterator find(const key_type& key) const;
+
+        const_iterator cbegin() const noexcept;
+        const_iterator cend() const noexcept;
+
+        template <class... Args>
+        bool can_merge(const Args&... axes) const;
+
+        template <class... Args>
+        bool can_intersect(const Args&... axes) const noexcept;
+
+        template <class... Args>
+        bool merge(const Args&... axes);
+
+        template <class... Args>
+        bool intersect(const Args&... axes);
+
+    private:
+
+        using interval_type = std::pair<difference_type, difference_type>;
+
+        template <class... Args>
+        bool merge_impl(std::true_type, const Args&... axes);
+
+        template <class... Args>
+        bool merge_impl(std::false_type, const Args&... axes);
+
+        template <class... Args>
+        bool intersect_impl(std::true_type, const Args&... axes);
+
+        template <class... Args>
+        bool intersect_impl(std::false_type, const Args&... axes);
+
+        void reset_labels(size_type size) noexcept;
+        bool find_position(const key_type& key, size_type& pos) const;
+
+        static bool join_frame(const self_type* const* axes, std::size_t n, key_type& start, key_type& step) noexcept;
+        static bool offset_in(key_type start, key_type step, const self_type& axis, difference_type& k) noexcept;
+        static bool merge_bounds(const self_type* const* axes, std::size_t n,
+                                 key_type& start, key_type& step, interval_type& bounds);
+        static bool intersect_bounds(const self_type* const* axes, std::size_t n,
+                                     key_type& start, key_type& step, interval_type& bounds) noexcept;
+
+        key_type m_start;
+        key_type m_step;
+        size_type m_size;
+        mutable label_list m_label_cache;
+        mutable std::atomic<bool> m_labels_built;
+        mutable std::mutex m_labels_mutex;
+    };
+
+    template <class L, class T>
+    bool operator==(const xaxis_arange<L, T>& lhs, const xaxis_arange<L, T>& rhs) noexcept;
+
+    template <class L, class T>
+    bool operator!=(const xaxis_arange<L, T>& lhs, const xaxis_arange<L, T>& rhs) noexcept;
+
+    /************************
+     * xaxis_arange builder *
+     ************************/
+
+    template <class T = std::size_t, class L>
+    xaxis_arange<L, T> arange_axis(L start, L stop, L step = L(1)) noexcept;
+
+    /********************
+    * xaxis_inner_types *
+    *********************/
+
+    template <class L, class T>
+    struct xaxis_inner_types<xaxis_arange<L, T>>
+    {
+        using key_type = L;
+        using mapped_type = T;
+        using iterator = xaxis_arange_iterator<L, T>;
+    };
+
+    /*************************
+     * xaxis_arange_iterator *
+     *************************/
+
+    template <class L, class T>
+    class xaxis_arange_iterator : public xtl::xrandom_access_iterator_base<xaxis_arange_iterator<L, T>,
+                                                                           typename xaxis_arange<L, T>::value_type,
+                                                                           typename xaxis_arange<L, T>::difference_type,
+                                                                           typename xaxis_arange<L, T>::const_pointer,
+                                                                           typename xaxis_arange<L, T>::const_reference>
+    {
+
+    public:
+
+        using self_type = xaxis_arange_iterator<L, T>;
+        using container_type = xaxis_arange<L, T>;
+        using key_type = typename container_type::key_type;
+        using mapped_type = typename container_type::mapped_type;
+        using value_type = typename container_type::value_type;
+        using reference = typename container_type::const_reference;
+        using pointer = typename container_type::const_pointer;
+        using difference_type = typename container_type::difference_type;
+        using iterator_category = std::random_access_iterator_tag;
+
+        xaxis_arange_iterator() = default;
+        xaxis_arange_iterator(key_type start, key_type step, mapped_type position);
+
+        self_type& operator++();
+        self_type& operator--();
+
+        self_type& operator+=(difference_type n);
+        self_type& operator-=(difference_type n);
+
+        difference_type operator-(const self_type& rhs) const;
+
+        reference operator*() const;
+        pointer operator->() const;
+
+        bool equal(const self_type& rhs) const noexcept;
+        bool less_than(const self_type& rhs) const noexcept;
+
+    private:
+
+        void update_label() noexcept;
+
+        key_type m_start;
+        key_type m_step;
+        value_type m_value;
+    };
+
+    template <class L, class T>
+    typename xaxis_arange_iterator<L, T>::difference_type operator-(const xaxis_arange_iterator<L, T>& lhs, const xaxis_arange_iterator<L, T>& rhs);
+
+    template <class L, class T>
+    bool operator==(const xaxis_arange_iterator<L, T>& lhs, const xaxis_arange_iterator<L, T>& rhs) noexcept;
+
+    template <class L, class T>
+    bool operator<(const xaxis_arange_iterator<L, T>& lhs, const xaxis_arange_iterator<L, T>& rhs) noexcept;
+
+    /**********************************
+     * arithmetic helpers for aranges *
+     **********************************/
+
+    namespace detail
+    {
+        // Returns start + k * step without going through a negative
+        // intermediate value, so that unsigned labels are supported.
+        template <class L, class D>
+        inline L arange_label(L start, L step, D k) noexcept
+        {
+            return k < D(0) ? static_cast<L>(start - static_cast<L>(-k) * step)
+                            : static_cast<L>(start + static_cast<L>(k) * step);
+        }
+
+        template <class L, class S>
+        inline bool arange_candidate(L start, L step, L key, S& pos, std::true_type /*is_integral*/) noexcept
+        {
+            if (step > L(0))
+            {
+                if (key < start || (key - start) % step != L(0))
+                {
+                    return false;
+                }
+                pos = static_cast<S>((key - start) / step);
+            }
+            else
+            {
+                if (start < key || (start - key) % (L(0) - step) != L(0))
+                {
+                    return false;
+                }
+                pos = static_cast<S>((start - key) / (L(0) - step));
+            }
+            return true;
+        }
+
+        template <class L, class S>
+        inline bool arange_candidate(L start, L step, L key, S& pos, std::false_type /*is_integral*/) noexcept
+        {
+            L q = (key - start) / step;
+            if (!(q > L(-0.5)) || !(q < static_cast<L>(std::numeric_limits<S>::max() / 2)))
+            {
+                return false;
+            }
+            pos = static_cast<S>(std::floor(q + L(0.5)));
+            return true;
+        }
+
+        template <class L, class D>
+        inline bool arange_offset(L start, L step, L rhs_start, D& k, std::true_type /*is_integral*/) noexcept
+        {
+            L d = rhs_start < start ? L(start - rhs_start) : L(rhs_start - start);
+            if (d % step != L(0))
+            {
+                return false;
+            }
+            k = rhs_start < start ? -static_cast<D>(d / step) : static_cast<D>(d / step);
+            return true;
+        }
+
+        // Floating point ranges are aligned only when they start at
+        // the same label, so that all the labels compare equal.
+        template <class L, class D>
+        inline bool arange_offset(L start, L /*step*/, L rhs_start, D& k, std::false_type /*is_integral*/) noexcept
+        {
+            k = D(0);
+            return start == rhs_start;
+        }
+
+        template <class L, class... Args>
+        struct all_same_as : std::true_type
+        {
+        };
+
+        template <class L, class A, class... Args>
+        struct all_same_as<L, A, Args...>
+            : std::integral_constant<bool, std::is_same<L, A>::value && all_same_as<L, Args...>::value>
+        {
+        };
+    }
+
+    /*******************************
+     * xaxis_arange implementation *
+     *******************************/
+
+    /**
+     * Constructs an axis holding \c size labels, starting at \c start
+     * and separated by \c step.
+     */
+    template <class L, class T>
+    inline xaxis_arange<L, T>::xaxis_arange(key_type start, key_type step, size_type size)
+        : base_type(), m_start(start), m_step(step), m_size(size), m_label_cache(), m_labels_built(false)
+    {
+    }
+
+    /**
+     * Copy constructor. The list of labels is copied only if it has
+     * already been built.
+     */
+    template <class L, class T>
+    inline xaxis_arange<L, T>::xaxis_arange(const self_type& rhs)
+        : base_type(rhs), m_start(rhs.m_start), m_step(rhs.m_step), m_size(rhs.m_size), m_label_cache(), m_labels_built(false)
+    {
+        if (rhs.m_labels_built.load(std::memory_order_acquire))
+        {
+            m_label_cache = rhs.m_label_cache;
+            m_labels_built.store(true, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * Move constructor.
+     */
+    template <class L, class T>
+    inline xaxis_arange<L, T>::xaxis_arange(self_type&& rhs) noexcept
+        : base_type(std::move(rhs)), m_start(rhs.m_start), m_step(rhs.m_step), m_size(rhs.m_size),
+          m_label_cache(std::move(rhs.m_label_cache)), m_labels_built(rhs.m_labels_built.load(std::memory_order_acquire))
+    {
+        rhs.m_labels_built.store(false, std::memory_order_relaxed);
+    }
+
+    /**
+     * Copy assignment operator. The list of labels is copied only if it
+     * has already been built.
+     */
+    template <class L, class T>
+    inline auto xaxis_arange<L, T>::operator=(const self_type& rhs) -> self_type&
+    {
+        if (this != &rhs)
+        {
+            base_type::operator=(rhs);
+            m_start = rhs.m_start;
+            m_step = rhs.m_step;
+            m_size = rhs.m_size;
+            bool built = rhs.m_labels_built.load(std::memory_order_acquire);
+            if (built)
+            {
+                m_label_cache = rhs.m_label_cache;
+            }
+            else
+            {
+                m_label_cache.clear();
+            }
+            m_labels_built.store(built, std::memory_order_relaxed);
+        }
+        return *this;
+    }
+
+    /**
+     * Move assignment operator.
+     */
+    template <class L, class T>
+    inline auto xaxis_arange<L, T>::operator=(self_type&& rhs) noexcept -> self_type&
+    {
+        if (this != &rhs)
+        {
+            base_type::operator=(std::move(rhs));
+            m_start = rhs.m_start;
+            m_step = rhs.m_step;
+            m_size = rhs.m_size;
+            m_label_cache = std::move(rhs.m_label_cache);
+            m_labels_built.store(rhs.m_labels_built.load(std::memory_order_acquire), std::memory_order_relaxed);
+            rhs.m_labels_built.store(false, std::memory_order_relaxed);
+        }
+        return *this;
+    }
+
+    /**
+     * Returns the list of labels contained in the axis. The list is
+     * built on the first call.
+     */
+    template <class L, class T>
+    inline auto xaxis_arange<L, T>::labels() const -> const label_list&
+    {
+        if (!m_labels_built.load(std::memory_order_acquire))
+        {
+            std::lock_guard<std::mutex> lock(m_labels_mutex);
+            if (!m_labels_built.load(std::memory_order_relaxed))
+            {
+                m_label_cache.clear();
+                m_label_cache.reserve(m_size);
+                for (size_type i = 0; i < m_size; ++i)
+                {
+                    m_label_cache.push_back(detail::arange_label(m_start, m_step, i));
+                }
+                m_labels_built.store(true, std::memory_order_release);
+            }
+        }
+        return m_label_cache;
+    }
+
+    /**
+     * Return the i-th label of the axis, without building the list of
+     * labels.
+     * @param i the position of the label.
+     */
+    template <class L, class T>
+    inline auto xaxis_arange<L, T>::label(size_type i) const noexcept -> key_type
+    {
+        return detail::arange_label(m_start, m_step, i);
+    }
+
+    /**
+     * Checks if the axis has no labels.
+     */
+    template <class L, class T>
+    inline bool xaxis_arange<L, T>::empty() const noexcept
+    {
+        return m_size == size_type(0);
+    }
+
+    /**
+     * Returns the number of labels in the axis.
+     */
+    template <class L, class T>
+    inline auto xaxis_arange<L, T>::size() const noexcept -> size_type
+    {
+        return m_size;
+    }
+
+    /**
+     * Returns the first label of the range.
+     */
+    template <class L, class T>
+    inline auto xaxis_arange<L, T>::start() const noexcept -> key_type
+    {
+        return m_start;
+    }
+
+    /**
+     * Returns the difference between two consecutive labels.
+     */
+    template <class L, class T>
+    inline auto xaxis_arange<L, T>::step() const noexcept -> key_type
+    {
+        return m_step;
+    }
+
+    /**
+     * Returns true if the labels list is sorted.
+     */
+    template <class L, class T>
+    inline bool xaxis_arange<L, T>::is_sorted() const noexcept
+    {
+        return m_step > key_type(0) || this->size() < size_type(2);
+    }
+
+    /**
+     * Returns true if the axis contains the speficied label.
+     * @param key the label to search for.
+     */
+    template <class L, class T>
+    inline bool xaxis_arange<L, T>::contains(const key_type& key) const
+    {
+        size_type pos;
+        return find_position(key, pos);
+    }
+
+    /**
+     * Returns the position of the specified label. If this last one is
+     * not found, an exception is thrown.
+     * @param key the label to search for.
+     */
+    template <class L, class T>
+    inline auto xaxis_arange<L, T>::operator[](const key_type& key) const -> mapped_type
+    {
+        size_type pos;
+        if (!find_position(key, pos))
+        {
+            throw std::out_of_range("xaxis_arange: label not found");
+        }
+        return mapped_type(pos);
+    }
+
+    /**
+     * Stores in \c positions the positions of the specified labels. If a
+     * label is not found, an exception is thrown.
+     * @param labels the range of labels to search for.
+     * @param positions the container receiving the positions. It is resized
+     *        to the number of labels.
+     */
+    template <class L, class T>
+    template <class R, class O>
+    inline void xaxis_arange<L, T>::index_of(const R& labels, O& positions) const
+    {
+        positions.resize(labels.size());
+        auto out = positions.begin();
+        for (auto iter = labels.begin(); iter != labels.end(); ++iter, ++out)
+        {
+            size_type pos;
+            if (!find_position(*iter, pos))
+            {
+                throw std::out_of_range("xaxis_arange: label not found");
+            }
+            *out = mapped_type(pos);
+        }
+    }
+
+    /**
+     * Builds an return a new axis by applying the given filter to the axis.
+     * @param f the filter used to select the labels to keep in the new axis.
+     */
+    template <class L, class T>
+    template <class F>
+    inline auto xaxis_arange<L, T>::filter(const F& f) const noexcept -> axis_type
+    {
+        label_list l;
+        for (size_type i = 0; i < m_size; ++i)
+        {
+            key_type key = label(i);
+            if (f(key))
+            {
+                l.push_back(key);
+            }
+        }
+        return axis_type(std::move(l), is_sorted());
+    }
+
+    /**
+     * Builds an return a new axis by applying the given filter to the axis. When
+     * the size of the new list of labels is known, this method allows some
+     * optimizations compared to the previous one.
+     * @param f the filter used to select the labels to keep in the new axis.
+     * @param size the size of the new label list.
+     */
+    template <class L, class T>
+    template <class F>
+    inline auto xaxis_arange<L, T>::filter(const F& f, size_type size) const noexcept -> axis_type
+    {
+        label_list l;
+        l.reserve(size);
+        for (size_type i = 0; i < m_size; ++i)
+        {
+            key_type key = label(i);
+            if (f(key))
+            {
+                l.push_back(key);
+            }
+        }
+        return axis_type(std::move(l), is_sorted());
+    }
+
+    /**
+     * Returns a constant iterator to the element with label equivalent to \c key. If
+     * no such element is found, past-the-end iterator is returned.
+     * @param key the label to search for.
+     */
+    template <class L, class T>
+    inline auto xaxis_arange<L, T>::find(const key_type& key) const -> const_iterator
+    {
+        size_type pos;
+        return find_position(key, pos) ? const_iterator(m_start, m_step, mapped_type(pos)) : cend();
+    }
+
+    /**
+     * Returns a constant iterator to the first element of the axis.
+     * This element is a pair label - position.
+     */
+    template <class L, class T>
+    inline auto xaxis_arange<L, T>::cbegin() const noexcept -> const_iterator
+    {
+        return const_iterator(m_start, m_step, mapped_type(0));
+    }
+
+    /**
+     * Returns a constant iterator to the element following the last element
+     * of the axis.
+     */
+    template <class L, class T>
+    inline auto xaxis_arange<L, T>::cend() const noexcept -> const_iterator
+    {
+        return const_iterator(m_start, m_step, mapped_type(this->size()));
+    }
+
+    /**
+     * Returns true if the union of this axis and the specified axes
+     * is a range, i.e. if the non empty axes are sorted, have the same
+     * step, aligned starts, and cover contiguous intervals.
+     */
+    template <class L, class T>
+    template <class... Args>
+    inline bool xaxis_arange<L, T>::can_merge(const Args&... axes) const
+    {
+        static_assert(detail::all_same_as<self_type, Args...>::value, "arguments must be xaxis_arange");
+        const self_type* all[] = { this, &axes... };
+        key_type start, step;
+        interval_type bounds;
+        return merge_bounds(all, sizeof...(Args) + 1, start, step, bounds);
+    }
+
+    /**
+     * Returns true if the intersection of this axis and the specified
+     * axes is a range, i.e. if one of the axes is empty, or if all of
+     * them are sorted, have the same step and aligned starts.
+     */
+    template <class L, class T>
+    template <class... Args>
+    inline bool xaxis_arange<L, T>::can_intersect(const Args&... axes) const noexcept
+    {
+        static_assert(detail::all_same_as<self_type, Args...>::value, "arguments must be xaxis_arange");
+        const self_type* all[] = { this, &axes... };
+        key_type start, step;
+        interval_type bounds;
+        return intersect_bounds(all, sizeof...(Args) + 1, start, step, bounds);
+    }
+
+    /**
+     * Replaces this axis with the union of this axis and the specified
+     * axes. The result is computed without comparing labels.
+     * @param axes the axes to merge.
+     * @return true if all the non empty axes hold the labels of the result.
+     * @throws std::runtime_error if an argument is not an xaxis_arange,
+     * or if the union is not a range.
+     * @sa can_merge
+     */
+    template <class L, class T>
+    template <class... Args>
+    inline bool xaxis_arange<L, T>::merge(const Args&... axes)
+    {
+        return merge_impl(detail::all_same_as<self_type, Args...>(), axes...);
+    }
+
+    /**
+     * Replaces this axis with the intersection of this axis and the
+     * specified axes. The result is computed without comparing labels.
+     * @param axes the axes to intersect.
+     * @return true if the intersection is equivalent to this axis.
+     * @throws std::runtime_error if an argument is not an xaxis_arange,
+     * or if the intersection is not a range.
+     * @sa can_intersect
+     */
+    template <class L, class T>
+    template <class... Args>
+    inline bool xaxis_arange<L, T>::intersect(const Args&... axes)
+    {
+        return intersect_impl(detail::all_same_as<self_type, Args...>(), axes...);
+    }
+
+    template <class L, class T>
+    template <class... Args>
+    inline bool xaxis_arange<L, T>::merge_impl(std::true_type, const Args&... axes)
+    {
+        const std::size_t n = sizeof...(Args) + 1;
+        const self_type* all[] = { this, &axes... };
+        key_type start, step;
+        interval_type bounds;
+        if (!merge_bounds(all, n, start, step, bounds))
+        {
+            throw std::runtime_error("xaxis_arange::merge: the union of the axes is not a range");
+        }
+        if (bounds.first == bounds.second)
+        {
+            return true;
+        }
+
+        bool res = true;
+        bool started = false;
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            if (all[i]->empty())
+            {
+                res = res && !started;
+                continue;
+            }
+            started = true;
+            difference_type k;
+            offset_in(start, step, *all[i], k);
+            res = res && k == bounds.first && difference_type(all[i]->size()) == bounds.second - bounds.first;
+        }
+
+        key_type new_start = detail::arange_label(start, step, bounds.first);
+        size_type size = size_type(bounds.second - bounds.first);
+        if (new_start != m_start || size != this->size() || (size > 1 && step != m_step))
+        {
+            m_start = new_start;
+            m_step = step;
+            reset_labels(size);
+        }
+        return res;
+    }
+
+    template <class L, class T>
+    template <class... Args>
+    inline bool xaxis_arange<L, T>::merge_impl(std::false_type, const Args&... /*axes*/)
+    {
+        throw std::runtime_error("xaxis_arange::merge: arguments must be xaxis_arange");
+    }
+
+    template <class L, class T>
+    template <class... Args>
+    inline bool xaxis_arange<L, T>::intersect_impl(std::true_type, const Args&... axes)
+    {
+        const self_type* all[] = { this, &axes... };
+        key_type start, step;
+        interval_type bounds;
+        if (!intersect_bounds(all, sizeof...(Args) + 1, start, step, bounds))
+        {
+            throw std::runtime_error("xaxis_arange::intersect: the intersection of the axes is not a range");
+        }
+        bool res = bounds.first == 0 && bounds.second == difference_type(this->size());
+        if (!res)
+        {
+            m_start = detail::arange_label(start, step, bounds.first);
+            m_step = step;
+            reset_labels(size_type(bounds.second - bounds.first));
+        }
+        return res;
+    }
+
+    template <class L, class T>
+    template <class... Args>
+    inline bool xaxis_arange<L, T>::intersect_impl(std::false_type, const Args&... /*axes*/)
+    {
+        throw std::runtime_error("xaxis_arange::intersect: arguments must be xaxis_arange");
+    }
+
+    // Sets the size of the range once its start or its step has changed;
+    // the list of labels is rebuilt on the next call to labels(). Must not
+    // be called concurrently with lookups.
+    template <class L, class T>
+    inline void xaxis_arange<L, T>::reset_labels(size_type size) noexcept
+    {
+        m_size = size;
+        m_labels_built.store(false, std::memory_order_relaxed);
+    }
+
+    // The candidate position of a floating point label is rounded, the
+    // label computed at this position must be the key itself.
+    template <class L, class T>
+    inline bool xaxis_arange<L, T>::find_position(const key_type& key, size_type& pos) const
+    {
+        if (m_size == size_type(0))
+        {
+            return false;
+        }
+        if (m_step == key_type(0))
+        {
+            pos = 0;
+            return key == m_start;
+        }
+        return detail::arange_candidate(m_start, m_step, key, pos, std::is_integral<key_type>())
+            && pos < m_size && label(pos) == key;
+    }
+
+    // Returns the start of the first non empty axis, and the step of the
+    // first axis holding more than one label, which define the frame in
+    // which the bounds of a join are expressed. Returns false if all the
+    // axes are empty.
+    template <class L, class T>
+    inline bool xaxis_arange<L, T>::join_frame(const self_type* const* axes, std::size_t n,
+                                               key_type& start, key_type& step) noexcept
+    {
+        auto first = std::find_if(axes, axes + n, [](const self_type* a) { return !a->empty(); });
+        if (first == axes + n)
+        {
+            return false;
+        }
+        auto multi = std::find_if(first, axes + n, [](const self_type* a) { return a->size() > 1; });
+        start = (*first)->m_start;
+        step = multi != axes + n ? (*multi)->m_step : (*first)->m_step;
+        return true;
+    }
+
+    // Computes the position of the first label of a non empty axis in
+    // the frame (start, step). Axes holding a single label are compatible
+    // with any step.
+    template <class L, class T>
+    inline bool xaxis_arange<L, T>::offset_in(key_type start, key_type step, const self_type& axis, difference_type& k) noexcept
+    {
+        return step > key_type(0) && (axis.size() < 2 || axis.m_step == step) &&
+            detail::arange_offset(start, step, axis.m_start, k, std::is_integral<key_type>());
+    }
+
+    template <class L, class T>
+    inline bool xaxis_arange<L, T>::merge_bounds(const self_type* const* axes, std::size_t n,
+                                                 key_type& start, key_type& step, interval_type& bounds)
+    {
+        bounds = interval_type(0, 0);
+        if (!join_frame(axes, n, start, step))
+        {
+            return true;
+        }
+        std::vector<interval_type> intervals;
+        intervals.reserve(n);
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            if (!axes[i]->empty())
+            {
+                difference_type k;
+                if (!offset_in(start, step, *axes[i], k))
+                {
+                    return false;
+                }
+                intervals.emplace_back(k, k + difference_type(axes[i]->size()));
+            }
+        }
+        std::sort(intervals.begin(), intervals.end());
+        bounds = intervals.front();
+        for (const auto& interval : intervals)
+        {
+            if (interval.first > bounds.second)
+            {
+                return false;
+            }
+            bounds.second = std::max(bounds.second, interval.second);
+        }
+        return true;
+    }
+
+    template <class L, class T>
+    inline bool xaxis_arange<L, T>::intersect_bounds(const self_type* const* axes, std::size_t n,
+                                                     key_type& start, key_type& step, interval_type& bounds) noexcept
+    {
+        bounds = interval_type(0, 0);
+        bool has_empty = std::any_of(axes, axes + n, [](const self_type* a) { return a->empty(); });
+        if (has_empty || !join_frame(axes, n, start, step))
+        {
+            start = axes[0]->m_start;
+            step = axes[0]->m_step;
+            return true;
+        }
+        bounds.second = difference_type(axes[0]->size());
+        for (std::size_t i = 1; i < n; ++i)
+        {
+            difference_type k;
+            if (!offset_in(start, step, *axes[i], k))
+            {
+                return false;
+            }
+            bounds.first = std::max(bounds.first, k);
+            bounds.second = std::min(bounds.second, k + difference_type(axes[i]->size()));
+        }
+        bounds.second = std::max(bounds.first, bounds.second);
+        return true;
+    }
+
+    /**
+     * Returns true is \c lhs and \c rhs hold the same labels, without
+     * building their lists of labels.
+     * @param lhs an axis.
+     * @param rhs an axis.
+     */
+    template <class L, class T>
+    inline bool operator==(const xaxis_arange<L, T>& lhs, const xaxis_arange<L, T>& rhs) noexcept
+    {
+        const std::size_t size = lhs.size();
+        return size == rhs.size() && (size == 0 || (lhs.start() == rhs.start() && (size == 1 || lhs.step() == rhs.step())));
+    }
+
+    /**
+     * Returns true is \c lhs and \c rhs hold different labels.
+     * @param lhs an axis.
+     * @param rhs an axis.
+     */
+    template <class L, class T>
+    inline bool operator!=(const xaxis_arange<L, T>& lhs, const xaxis_arange<L, T>& rhs) noexcept
+    {
+        return !(lhs == rhs);
+    }
+
+    /***************************************
+     * xaxis_arange builder implementation *
+     ***************************************/
+
+    /**
+     * Returns an axis holding the labels of the half-open interval
+     * [start, stop) with spacing \c step. No label - position map is
+     * built.
+     * @param start the first label.
+     * @param stop the end of the range. The range does not contain
+     *             this value.
+     * @param step spacing between labels. Default step is \c 1.
+     * @tparam T the integral type used for positions. Default value
+     *           is \c std::size_t.
+     * @tparam L the type of the labels.
+     */
+    template <class T, class L>
+    inline xaxis_arange<L, T> arange_axis(L start, L stop, L step) noexcept
+    {
+        std::size_t size = 0;
+        if (std::is_integral<L>::value)
+        {
+            if (step > L(0) && start < stop)
+            {
+                size = static_cast<std::size_t>((stop - start + step - L(1)) / step);
+            }
+            else if (step < L(0) && stop < start)
+            {
+                size = static_cast<std::size_t>((start - stop - step - L(1)) / (L(0) - step));
+            }
+        }
+        else if (step != L(0))
+        {
+            auto n = std::ceil(static_cast<double>(stop - start) / static_cast<double>(step));
+            size = n > 0. ? static_cast<std::size_t>(n) : std::size_t(0);
+        }
+        return xaxis_arange<L, T>(start, step, size);
+    }
+
+    /****************************************
+     * xaxis_arange_iterator implementation *
+     ****************************************/
+
+    template <class L, class T>
+    inline xaxis_arange_iterator<L, T>::xaxis_arange_iterator(key_type start, key_type step, mapped_type position)
+        : m_start(start), m_step(step), m_value(key_type(), position)
+    {
+        update_label();
+    }
+
+    template <class L, class T>
+    inline auto xaxis_arange_iterator<L, T>::operator++() -> self_type&
+    {
+        ++m_value.second;
+        update_label();
+        return *this;
+    }
+
+    template <class L, class T>
+    inline auto xaxis_arange_iterator<L, T>::operator--() -> self_type&
+    {
+        --m_value.second;
+        update_label();
+        return *this;
+    }
+
+    template <class L, class T>
+    inline auto xaxis_arange_iterator<L, T>::operator+=(difference_type n) -> self_type&
+    {
+        m_value.second = static_cast<mapped_type>(static_cast<difference_type>(m_value.second) + n);
+        update_label();
+        return *this;
+    }
+
+    template <class L, class T>
+    inline auto xaxis_arange_iterator<L, T>::operator-=(difference_type n) -> self_type&
+    {
+        m_value.second = static_cast<mapped_type>(static_cast<difference_type>(m_value.second) - n);
+        update_label();
+        return *this;
+    }
+
+    template <class L, class T>
+    inline auto xaxis_arange_iterator<L, T>::operator-(const self_type& rhs) const -> difference_type
+    {
+        return static_cast<difference_type>(m_value.second) - static_cast<difference_type>(rhs.m_value.second);
+    }
+
+    template <class L, class T>
+    inline auto xaxis_arange_iterator<L, T>::operator*() const -> reference
+    {
+        return m_value;
+    }
+
+    template <class L, class T>
+    inline auto xaxis_arange_iterator<L, T>::operator->() const -> pointer
+    {
+        return &m_value;
+    }
+
+    template <class L, class T>
+    inline bool xaxis_arange_iterator<L, T>::equal(const self_type& rhs) const noexcept
+    {
+        return m_value.second == rhs.m_value.second;
+    }
+
+    template <class L, class T>
+    inline bool xaxis_arange_iterator<L, T>::less_than(const self_type& rhs) const noexcept
+    {
+        return m_value.second < rhs.m_value.second;
+    }
+
+    template <class L, class T>
+    inline void xaxis_arange_iterator<L, T>::update_label() noexcept
+    {
+        m_value.first = detail::arange_label(m_start, m_step, m_value.second);
+    }
+
+    template <class L, class T>
+    inline typename xaxis_arange_iterator<L, T>::difference_type operator-(const xaxis_arange_iterator<L, T>& lhs, const xaxis_arange_iterator<L, T>& rhs)
+    {
+        return lhs.operator-(rhs);
+    }
+
+    template <class L, class T>
+    inline bool operator==(const xaxis_arange_iterator<L, T>& lhs, const xaxis_arange_iterator<L, T>& rhs) noexcept
+    {
+        return lhs.equal(rhs);
+    }
+
+    template <class L, class T>
+    inline bool operator<(const xaxis_arange_iterator<L, T>& lhs, const xaxis_arange_iterator<L, T>& rhs) noexcept
+    {
+        return lhs.less_than(rhs);
+    }
+}
+
+#endif
@@ -309,8 +309,9 @@ namespace xf
     template <class F>
     inline auto xaxis_base<D>::filter_labels(const F& f) const noexcept -> label_list
     {
+        const label_list& all_labels = derived_cast().labels();
         label_list l;
-        std::copy_if(m_labels.cbegin(), m_labels.cend(), std::back_inserter(l), f);
+        std::copy_if(all_labels.cbegin(), all_labels.cend(), std::back_inserter(l), f);
         return l;
     }
 
@@ -318,8 +319,9 @@ namespace xf
     template <class F>
     inline auto xaxis_base<D>::filter_labels(const F& f, size_type size) const noexcept -> label_list
     {
+        const label_list& all_labels = derived_cast().labels();
         label_list l(size);
-        std::copy_if(m_labels.cbegin(), m_labels.cend(), l.begin(), f);
+        std::copy_if(all_labels.cbegin(), all_labels.cend(), l.begin(), f);
         return l;
     }
 
@@ -332,7 +334,8 @@ namespace xf
     template <class D1, class D2>
     inline bool operator==(const xaxis_base<D1>& lhs, const xaxis_base<D2>& rhs) noexcept
     {
-        return lhs.labels() == rhs.labels();
+        // the labels of the derived types may not be stored in m_labels
+        return lhs.derived_cast().labels() == rhs.derived_cast().labels();
     }
 
     /**
@@ -352,7 +355,8 @@ namespace xf
     {
         using iterator = std::ostream_iterator<typename xaxis_base<D>::key_type, typename OS::char_type, typename OS::traits_type>;
         out << '(';
-        std::copy(axis.labels().begin(), axis.labels().end(), iterator(out, ", "));
+        const auto& labels = axis.derived_cast().labels();
+        std::copy(labels.begin(), labels.end(), iterator(out, ", "));
         out << ')';
         return out;
     }
@@ -11,6 +11,9 @@
 #ifndef XFRAME_XAXIS_DEFAULT_HPP
 #define XFRAME_XAXIS_DEFAULT_HPP
 
+#include <algorithm>
+#include <array>
+#include <stdexcept>
 #include <utility>
 #include <vector>
 #include <ostream>
@@ -29,6 +32,25 @@ namespace xf
     template <class L1, class T1, class MT1>
     class xaxis_variant;
 
+    namespace detail
+    {
+        template <class A>
+        struct xaxis_fast_join;
+
+        /**
+         * Describes an operand of a join involving a default axis. p_labels
+         * is null when the label type of the operand differs from the one
+         * of the default axis.
+         */
+        template <class K>
+        struct xaxis_default_operand
+        {
+            const std::vector<K>* p_labels = nullptr;
+            bool is_default = false;
+            bool is_sorted = false;
+        };
+    }
+
     /*****************
      * xaxis_default *
      *****************/
@@ -39,6 +61,8 @@ namespace xf
      *
      * The xaxis_default class is used for modeling a default axis
      * that holds a contiguous sequence of integral labels starting at 0.
+     * When joined through an xaxis_variant, a default axis stays a default
+     * axis as long as the result is a contiguous sequence starting at 0.
      *
      * @tparam L the type of labels. This must be an integral type.
      * @tparam T the integer type used to represent positions. Default value is
@@ -76,6 +100,9 @@ namespace xf
         bool contains(const key_type& key) const;
         mapped_type operator[](const key_type& key) const;
 
+        template <class R, class O>
+        void index_of(const R& labels, O& positions) const;
+
         template <class F>
         axis_type filter(const F& f) const noexcept;
 
@@ -93,14 +120,27 @@ namespace xf
 
     private:
 
+        using operand_type = detail::xaxis_default_operand<key_type>;
+
         template <class... Args>
         bool merge(const Args&... /*axes*/);
 
         template <class... Args>
         bool intersect(const Args&... /*axes*/);
 
+        template <std::size_t N>
+        bool merge_operands(const std::array<operand_type, N>& operands, bool& res);
+
+        template <std::size_t N>
+        bool intersect_operands(const std::array<operand_type, N>& operands, bool& res, label_list& labels);
+
+        bool in_range(const label_list& labels, size_type size) const noexcept;
+        void resize(size_type size);
+
         template <class L1, class T1, class MT1>
         friend class xaxis_variant;
+
+        friend struct detail::xaxis_fast_join<xaxis_default<L, T>>;
     };
 
     /*************************
@@ -223,6 +263,29 @@ namespace xf
         return mapped_type(this->labels().at(key));
     }
 
+    /**
+     * Stores in \c positions the positions of the specified labels. If a
+     * label is not found, an exception is thrown.
+     * @param labels the range of labels to search for.
+     * @param positions the container receiving the positions. It is resized
+     *        to the number of labels.
+     */
+    template <class L, class T>
+    template <class R, class O>
+    inline void xaxis_default<L, T>::index_of(const R& labels, O& positions) const
+    {
+        positions.resize(labels.size());
+        auto out = positions.begin();
+        for (auto iter = labels.begin(); iter != labels.end(); ++iter, ++out)
+        {
+            if (!contains(*iter))
+            {
+                throw std::out_of_range("xaxis_default: label not found");
+            }
+            *out = static_cast<mapped_type>(*iter);
+        }
+    }
+
     /**
      * Builds an return a new axis by applying the given filter to the axis.
      * @param f the filter used to select the labels to keep in the new axis.
@@ -303,6 +366,136 @@ namespace xf
         throw std::runtime_error("intersect forbidden for xaxis_default");
     }
 
+    // The union of default axes is the longest of them. Sorted explicit
+    // operands without repeated labels do not change it as long as their
+    // labels lie in its range, which is checked on the first and last
+    // labels only. Returns false when the union is not a default axis.
+    template <class L, class T>
+    template <std::size_t N>
+    inline bool xaxis_default<L, T>::merge_operands(const std::array<operand_type, N>& operands, bool& res)
+    {
+        size_type size = this->size();
+        for (const auto& op : operands)
+        {
+            if (op.p_labels == nullptr)
+            {
+                return false;
+            }
+            if (op.is_default)
+            {
+                size = std::max(size, op.p_labels->size());
+            }
+        }
+        for (const auto& op : operands)
+        {
+            if (!op.is_default && !(op.is_sorted && in_range(*op.p_labels, size) &&
+                                    std::adjacent_find(op.p_labels->cbegin(), op.p_labels->cend()) == op.p_labels->cend()))
+            {
+                return false;
+            }
+        }
+
+        bool started = !this->empty();
+        res = !started || this->size() == size;
+        for (const auto& op : operands)
+        {
+            if (op.p_labels->empty())
+            {
+                res = res && !started;
+            }
+            else
+            {
+                started = true;
+                res = res && op.p_labels->size() == size;
+            }
+        }
+        resize(size);
+        return true;
+    }
+
+    // The intersection of default axes is the shortest of them. Sorted
+    // explicit operands are first restricted to its range by binary
+    // search and then intersected. Returns false when the intersection
+    // cannot be computed this way, e.g. when the first explicit operand
+    // repeats a label in that range. Otherwise, if the result is not a
+    // default axis, its labels are moved into \c labels.
+    template <class L, class T>
+    template <std::size_t N>
+    inline bool xaxis_default<L, T>::intersect_operands(const std::array<operand_type, N>& operands, bool& res, label_list& labels)
+    {
+        size_type size = this->size();
+        const label_list* first_explicit = nullptr;
+        for (const auto& op : operands)
+        {
+            if (op.p_labels == nullptr || !(op.is_default || op.is_sorted))
+            {
+                return false;
+            }
+            if (op.is_default)
+            {
+                size = std::min(size, op.p_labels->size());
+            }
+            else if (first_explicit == nullptr)
+            {
+                first_explicit = op.p_labels;
+            }
+        }
+
+        if (first_explicit != nullptr)
+        {
+            auto first = std::lower_bound(first_explicit->cbegin(), first_explicit->cend(), key_type(0));
+            auto last = std::lower_bound(first, first_explicit->cend(), key_type(size));
+            if (std::adjacent_find(first, last) != last)
+            {
+                return false;
+            }
+            label_list tmp(first, last);
+            for (const auto& op : operands)
+            {
+                if (!op.is_default && op.p_labels != first_explicit)
+                {
+                    intersect_to(tmp, *op.p_labels);
+                }
+            }
+            size = tmp.size();
+            if (!tmp.empty() && !(tmp.front() == key_type(0) && tmp.back() == key_type(size - 1)))
+            {
+                res = false;
+                labels = std::move(tmp);
+                return true;
+            }
+        }
+
+        res = size == this->size();
+        resize(size);
+        return true;
+    }
+
+    template <class L, class T>
+    inline bool xaxis_default<L, T>::in_range(const label_list& labels, size_type size) const noexcept
+    {
+        return labels.empty() || (key_type(0) <= labels.front() && labels.back() < key_type(size));
+    }
+
+    template <class L, class T>
+    inline void xaxis_default<L, T>::resize(size_type size)
+    {
+        if (size < this->size())
+        {
+            this->mutable_labels().resize(size);
+        }
+        else
+        {
+            size_type old_size = this->size();
+            auto& labels = this->mutable_labels();
+            labels.reserve(size);
+            for (size_type i = old_size; i < size; ++i)
+            {
+                labels.push_back(key_type(i));
+            }
+        }
+    }
+
     /****************************************
      * xaxis_default builder implementation *
      ****************************************/
@@ -360,8 +360,8 @@ namespace xf
     inline auto xaxis_keep_slice<L>::build_index_slice(const A& axis) const -> index_slice_type<A>
     {
         using index_container_type = typename index_slice_type<A>::container_type;
-        index_container_type c(m_labels.size());
-        std::transform(m_labels.cbegin(), m_labels.cend(), c.begin(), [&axis](const auto& arg) { return axis[arg]; });
+        index_container_type c;
+        axis.index_of(m_labels, c);
         index_slice_type<A> res(std::move(c));
         res.normalize(axis.size());
         return res;
@@ -389,8 +389,8 @@ namespace xf
     inline auto xaxis_drop_slice<L>::build_index_slice(const A& axis) const -> index_slice_type<A>
     {
         using index_container_type = typename index_slice_type<A>::container_type;
-        index_container_type c(m_labels.size());
-        std::transform(m_labels.cbegin(), m_labels.cend(), c.begin(), [&axis](const auto& arg) { return axis[arg]; });
+        index_container_type c;
+        axis.index_of(m_labels, c);
         index_slice_type<A> res(std::move(c));
         res.normalize(axis.size());
         return res;
@@ -11,11 +11,16 @@
 #ifndef XFRAME_XAXIS_VARIANT_HPP
 #define XFRAME_XAXIS_VARIANT_HPP
 
+#include <algorithm>
+#include <array>
 #include <functional>
+#include <iterator>
+#include <utility>
 #include "xtl/xclosure.hpp"
 #include "xtl/xmeta_utils.hpp"
 #include "xtl/xvariant.hpp"
 #include "xaxis.hpp"
+#include "xaxis_arange.hpp"
 #include "xaxis_default.hpp"
 #include "xvector_variant.hpp"
 
@@ -44,6 +49,163 @@ namespace xf
         template <class V, class S, class... L>
         using add_default_axis_t = typename add_default_axis<V, S, L...>::type;
 
+        template <class V, class S, class... L>
+        struct add_arange_axis;
+
+        template <class... A, class S>
+        struct add_arange_axis<xtl::variant<A...>, S>
+        {
+            using type = xtl::variant<A...>;
+        };
+
+        template <class... A, class S, class L1, class... L>
+        struct add_arange_axis<xtl::variant<A...>, S, L1, L...>
+        {
+            using type = typename xtl::mpl::if_t<std::integral_constant<bool, std::is_arithmetic<L1>::value && !std::is_same<L1, bool>::value>,
+                add_arange_axis<xtl::variant<A..., xaxis_arange<L1, S>>, S, L...>,
+                add_arange_axis<xtl::variant<A...>, S, L...>>::type;
+        };
+
+        template <class V, class S, class... L>
+        using add_arange_axis_t = typename add_arange_axis<V, S, L...>::type;
+
+        /**
+         * Joins axes stored in variants without building a label - position
+         * map, when the axis held by the output is an arange or a default
+         * axis. merge and intersect return 0 when the fast path does not
+         * apply to the axis type, 1 when it does not apply to the operands,
+         * 2 when the result has been computed in place and 3 when the
+         * result has been stored in \c result.
+         */
+        template <class A>
+        struct xaxis_fast_join
+        {
+            template <class MT, class R, class... V>
+            static int merge(A&, bool&, R&, const V&...)
+            {
+                return 0;
+            }
+
+            template <class MT, class R, class... V>
+            static int intersect(A&, bool&, R&, const V&...)
+            {
+                return 0;
+            }
+        };
+
+        template <class L, class S>
+        struct xaxis_fast_join<xaxis_arange<L, S>>
+        {
+            using axis_type = xaxis_arange<L, S>;
+
+            template <class MT, class R, class... V>
+            static int merge(axis_type& a, bool& res, R&, const V&... axes)
+            {
+                if (!all_aranges(axes...) || !a.can_merge(*xtl::get_if<axis_type>(&axes)...))
+                {
+                    return 1;
+                }
+                res = a.merge(*xtl::get_if<axis_type>(&axes)...);
+                return 2;
+            }
+
+            template <class MT, class R, class... V>
+            static int intersect(axis_type& a, bool& res, R&, const V&... axes)
+            {
+                if (!all_aranges(axes...) || !a.can_intersect(*xtl::get_if<axis_type>(&axes)...))
+                {
+                    return 1;
+                }
+                res = a.intersect(*xtl::get_if<axis_type>(&axes)...);
+                return 2;
+            }
+
+        private:
+
+            template <class... V>
+            static bool all_aranges(const V&... axes)
+            {
+                bool is_arange[] = { true, (xtl::get_if<axis_type>(&axes) != nullptr)... };
+                return std::all_of(std::begin(is_arange), std::end(is_arange), [](bool b) { return b; });
+            }
+        };
+
+        template <class K, class D, class A>
+        inline xaxis_default_operand<K> make_default_operand(const A& a, std::true_type)
+        {
+            xaxis_default_operand<K> res;
+            res.p_labels = &(a.labels());
+            res.is_default = std::is_same<A, D>::value;
+            res.is_sorted = a.is_sorted();
+            return res;
+        }
+
+        template <class K, class D, class A>
+        inline xaxis_default_operand<K> make_default_operand(const A&, std::false_type)
+        {
+            return xaxis_default_operand<K>();
+        }
+
+        template <class D, class V>
+        inline xaxis_default_operand<typename D::key_type> make_default_operand(const V& v)
+        {
+            using key_type = typename D::key_type;
+            return xtl::visit([](const auto& arg)
+            {
+                using axis_type = std::decay_t<decltype(arg)>;
+                return make_default_operand<key_type, D>(arg, std::is_same<typename axis_type::key_type, key_type>());
+            }, v);
+        }
+
+        template <class L, class S>
+        struct xaxis_fast_join<xaxis_default<L, S>>
+        {
+            using axis_type = xaxis_default<L, S>;
+            using operand_type = xaxis_default_operand<L>;
+
+            template <class MT, class R, class... V>
+            static int merge(axis_type& a, bool& res, R&, const V&... axes)
+            {
+                std::array<operand_type, sizeof...(V)> operands = {{ make_default_operand<axis_type>(axes)... }};
+                return a.merge_operands(operands, res) ? 2 : 1;
+            }
+
+            template <class MT, class R, class... V>
+            static int intersect(axis_type& a, bool& res, R& result, const V&... axes)
+            {
+                std::array<operand_type, sizeof...(V)> operands = {{ make_default_operand<axis_type>(axes)... }};
+                typename axis_type::label_list labels;
+                if (!a.intersect_operands(operands, res, labels))
+                {
+                    return 1;
+                }
+                if (labels.empty())
+                {
+                    return 2;
+                }
+                result = xaxis<L, S, MT>(std::move(labels));
+                return 3;
+            }
+        };
+
+        struct xaxis_fast_merge
+        {
+            template <class MT, class A, class R, class... V>
+            static int apply(A& a, bool& res, R& result, const V&... axes)
+            {
+                return xaxis_fast_join<A>::template merge<MT>(a, res, result, axes...);
+            }
+        };
+
+        struct xaxis_fast_intersect
+        {
+            template <class MT, class A, class R, class... V>
+            static int apply(A& a, bool& res, R& result, const V&... axes)
+            {
+                return xaxis_fast_join<A>::template intersect<MT>(a, res, result, axes...);
+            }
+        };
+
         template <class V>
         struct get_axis_variant_iterator;
 
@@ -56,6 +218,101 @@ namespace xf
         template <class V>
         using get_axis_variant_iterator_t = typename get_axis_variant_iterator<V>::type;
 
+        /**
+         * Forward iterator over a range of variant labels, giving access
+         * to the alternative of type \c K of each label. Used to forward
+         * a batch of labels to the axis held by an xaxis_variant without
+         * copying them.
+         */
+        template <class K, class It>
+        class xlabel_get_iterator
+        {
+        public:
+
+            using self_type = xlabel_get_iterator<K, It>;
+            using value_type = K;
+            using reference = const K&;
+            using pointer = const K*;
+            using difference_type = typename std::iterator_traits<It>::difference_type;
+            using iterator_category = std::forward_iterator_tag;
+
+            xlabel_get_iterator() = default;
+            explicit xlabel_get_iterator(It it)
+                : m_it(it)
+            {
+            }
+
+            reference operator*() const
+            {
+                return xtl::get<K>(*m_it);
+            }
+
+            pointer operator->() const
+            {
+                return &(operator*());
+            }
+
+            self_type& operator++()
+            {
+                ++m_it;
+                return *this;
+            }
+
+            self_type operator++(int)
+            {
+                self_type tmp(*this);
+                ++m_it;
+                return tmp;
+            }
+
+            bool operator==(const self_type& rhs) const
+            {
+                return m_it == rhs.m_it;
+            }
+
+            bool operator!=(const self_type& rhs) const
+            {
+                return m_it != rhs.m_it;
+            }
+
+        private:
+
+            It m_it;
+        };
+
+        template <class K, class R>
+        class xlabel_get_range
+        {
+        public:
+
+            using iterator = xlabel_get_iterator<K, decltype(std::declval<const R&>().begin())>;
+            using size_type = decltype(std::declval<const R&>().size());
+
+            explicit xlabel_get_range(const R& labels)
+                : m_labels(labels)
+            {
+            }
+
+            size_type size() const
+            {
+                return m_labels.size();
+            }
+
+            iterator begin() const
+            {
+                return iterator(m_labels.begin());
+            }
+
+            iterator end() const
+            {
+                return iterator(m_labels.end());
+            }
+
+        private:
+
+            const R& m_labels;
+        };
+
         template <class S, class MT, class TL>
         struct xaxis_variant_traits;
 
@@ -63,7 +320,8 @@ namespace xf
         struct xaxis_variant_traits<S, MT, TL<L...>>
         {
             using tmp_storage_type = xtl::variant<xaxis<L, S, MT>...>;
-            using storage_type = add_default_axis_t<tmp_storage_type, S, L...>;
+            using default_storage_type = add_default_axis_t<tmp_storage_type, S, L...>;
+            using storage_type = add_arange_axis_t<default_storage_type, S, L...>;
             using label_list = xvector_variant_cref<std::vector<L>...>;
             using key_type = xtl::variant<typename xaxis<L, S, MT>::key_type...>;
             using key_reference = xtl::variant<xtl::xclosure_wrapper<const typename xaxis<L, S, MT>::key_type&>...>;
@@ -138,6 +396,10 @@ namespace xf
         xaxis_variant(const xaxis_default<LB, T>& axis);
         template <class LB>
         xaxis_variant(xaxis_default<LB, T>&& axis);
+        template <class LB>
+        xaxis_variant(const xaxis_arange<LB, T>& axis);
+        template <class LB>
+        xaxis_variant(xaxis_arange<LB, T>&& axis);
 
         label_list labels() const;
         key_type label(size_type i) const;
@@ -147,9 +409,14 @@ namespace xf
 
         bool is_sorted() const noexcept;
 
+        const storage_type& storage() const noexcept;
+
         bool contains(const key_type& key) const;
         mapped_type operator[](const key_type& key) const;
 
+        template <class R, class O>
+        void index_of(const R& labels, O& positions) const;
+
         template <class F>
         self_type filter(const F& f) const;
 
@@ -183,6 +450,9 @@ namespace xf
 
     private:
 
+        template <class Join, class... Args>
+        int fast_join(bool& res, const Args&... axes);
+
         storage_type m_data;
 
         template <class OS, class L1, class T1, class MT1>
@@ -307,6 +577,32 @@ namespace xf
     {
     }
 
+    /**
+     * Constructs an xaxis_variant from the specified xaxis_arange. This latter is
+     * copied in the variant.
+     * @tparam LB the label type of the axis argument.
+     * @param axis the axis to copy in the variant.
+     */
+    template <class L, class T, class MT>
+    template <class LB>
+    inline xaxis_variant<L, T, MT>::xaxis_variant(const xaxis_arange<LB, T>& axis)
+        : m_data(axis)
+    {
+    }
+
+    /**
+     * Constructs an xaxis_variant from the specified xaxis_arange. This latter
+     * is moved in the variant.
+     * @tparam LB the label type of the axis argument.
+     * @param axis the axis to move in the variant.
+     */
+    template <class L, class T, class MT>
+    template <class LB>
+    inline xaxis_variant<L, T, MT>::xaxis_variant(xaxis_arange<LB, T>&& axis)
+        : m_data(std::move(axis))
+    {
+    }
+
     //@}
 
     /**
@@ -329,7 +625,7 @@ namespace xf
     template <class L, class T, class MT>
     inline auto xaxis_variant<L, T, MT>::label(size_type i) const -> key_type
     {
-        return xtl::visit([i](auto&& arg) -> key_type { return arg.labels()[i]; }, m_data);
+        return xtl::visit([i](auto&& arg) -> key_type { return arg.label(i); }, m_data);
     }
 
     /**
@@ -358,6 +654,15 @@ namespace xf
     {
         return xtl::visit([](auto&& arg) { return arg.is_sorted(); }, m_data);
     }
+
+    /**
+     * Returns the variant holding the underlying axis.
+     */
+    template <class L, class T, class MT>
+    inline auto xaxis_variant<L, T, MT>::storage() const noexcept -> const storage_type&
+    {
+        return m_data;
+    }
     //@}
 
     /**
@@ -394,6 +699,26 @@ namespace xf
         };
         return xtl::visit(lambda, m_data);
     }
+
+    /**
+     * Stores in \c positions the positions of the specified labels. The
+     * underlying axis is visited once for the whole batch. If a label is
+     * not found, an exception is thrown.
+     * @param labels the range of labels to search for.
+     * @param positions the container receiving the positions. It is resized
+     *        to the number of labels.
+     */
+    template <class L, class T, class MT>
+    template <class R, class O>
+    inline void xaxis_variant<L, T, MT>::index_of(const R& labels, O& positions) const
+    {
+        auto lambda = [&labels, &positions](auto&& arg)
+        {
+            using type = typename std::decay_t<decltype(arg)>::key_type;
+            arg.index_of(detail::xlabel_get_range<type, R>(labels), positions);
+        };
+        xtl::visit(lambda, m_data);
+    }
     //@}
 
     /**
@@ -569,6 +894,11 @@ namespace xf
     template <class... Args>
     inline bool xaxis_variant<L, T, MT>::merge(const Args&... axes)
     {
+        bool res = true;
+        if (fast_join<detail::xaxis_fast_merge>(res, axes...) > 1)
+        {
+            return res;
+        }
         auto lambda = [&axes...](auto&& arg) -> bool
         {
             using key_type = typename std::decay_t<decltype(arg)>::key_type;
@@ -587,6 +917,11 @@ namespace xf
     template <class... Args>
     inline bool xaxis_variant<L, T, MT>::intersect(const Args&... axes)
     {
+        bool res = true;
+        if (fast_join<detail::xaxis_fast_intersect>(res, axes...) > 1)
+        {
+            return res;
+        }
         auto lambda = [&axes...](auto&& arg) -> bool
         {
             using key_type = typename std::decay_t<decltype(arg)>::key_type;
@@ -596,6 +931,30 @@ namespace xf
     }
     //@}
 
+    // When this axis is an arange or a default axis and the operands
+    // allow it, the join is computed arithmetically. Otherwise this axis
+    // is turned into an xaxis so that the generic join applies.
+    template <class L, class T, class MT>
+    template <class Join, class... Args>
+    inline int xaxis_variant<L, T, MT>::fast_join(bool& res, const Args&... axes)
+    {
+        storage_type result;
+        auto lambda = [&res, &result, &axes...](auto& arg) -> int
+        {
+            return Join::template apply<MT>(arg, res, result, axes.m_data...);
+        };
+        int state = xtl::visit(lambda, m_data);
+        if (state == 1)
+        {
+            *this = as_xaxis();
+        }
+        else if (state == 3)
+        {
+            m_data = std::move(result);
+        }
+        return state;
+    }
+
     template <class L, class T, class MT>
     inline auto xaxis_variant<L, T, MT>::as_xaxis() const -> self_type
     {
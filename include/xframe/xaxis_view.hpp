@@ -83,6 +83,9 @@ namespace xf
         mapped_type operator[](const key_type& key) const;
         mapped_type index(size_type label_index) const;
 
+        template <class R, class O>
+        void index_of(const R& labels, O& positions) const;
+
         template <class F>
         axis_type filter(const F& f) const;
 
@@ -303,6 +306,28 @@ namespace xf
         return this->operator[](label(label_index));
     }
 
+    /**
+     * Stores in \c positions the positions in the underlying axis of the
+     * specified labels. If a label is not found in the view, an exception
+     * is thrown.
+     * @param labels the range of labels to search for.
+     * @param positions the container receiving the positions. It is resized
+     *        to the number of labels.
+     */
+    template <class L, class T, class MT>
+    template <class R, class O>
+    inline void xaxis_view<L, T, MT>::index_of(const R& labels, O& positions) const
+    {
+        m_axis.index_of(labels, positions);
+        for (const auto& idx : positions)
+        {
+            if (!m_slice.contains(static_cast<size_type>(idx)))
+            {
+                throw std::out_of_range("invalid xaxis_view key");
+            }
+        }
+    }
+
     /**
      * Builds an return a new axis by applying the given filter to the view.
      * @param f the filter used to select the labels to keep in the new axis.
@@ -408,7 +408,7 @@ namespace xf
         map_type& m = this->coordinate();
         for (auto iter = c.data().cbegin(); iter != c.data().cend(); ++iter)
         {
-            m.insert(std::make_pair(iter->first, mapped_type(iter->second.as_xaxis())));
+            m.insert(*iter);
         }
         return broadcast_impl<Join>(coordinates...);
     }
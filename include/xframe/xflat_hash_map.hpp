@@ -0,0 +1,456 @@
+/***************************************************************************
+* Copyright (c) Johan Mabille, Sylvain Corlay, Wolf Vollprecht and         *
+* Martin Renou                                                             *
+* Copyright (c) QuantStack                                                 *
+*                                                                          *
+* Distributed under the terms of the BSD 3-Clause License.                 *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#ifndef XFRAME_XFLAT_HASH_MAP_HPP
+#define XFRAME_XFLAT_HASH_MAP_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define XFRAME_FLAT_HASH_SSE2 1
+#else
+#define XFRAME_FLAT_HASH_SSE2 0
+#endif
+
+namespace xf
+{
+    namespace detail
+    {
+        /***************
+         * xflat_group *
+         ***************/
+
+        /**
+         * A group of consecutive control bytes of an xflat_hash_map. A
+         * control byte is either empty (high bit set) or holds the 7 low
+         * bits of the hash of the key stored in the corresponding slot.
+         * The bits of the masks returned by match and match_empty are
+         * mapped to positions in the group with a right shift of
+         * \c shift after counting trailing zeros.
+         */
+        struct xflat_group
+        {
+#if XFRAME_FLAT_HASH_SSE2
+            static constexpr std::size_t width = 16;
+            static constexpr std::size_t shift = 0;
+
+            explicit xflat_group(const std::int8_t* ctrl) noexcept
+                : m_ctrl(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl)))
+            {
+            }
+
+            std::uint64_t match(std::int8_t h2) const noexcept
+            {
+                return static_cast<std::uint64_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), m_ctrl)));
+            }
+
+            std::uint64_t match_empty() const noexcept
+            {
+                return static_cast<std::uint64_t>(_mm_movemask_epi8(m_ctrl));
+            }
+
+            __m128i m_ctrl;
+#else
+            static constexpr std::size_t width = 8;
+            static constexpr std::size_t shift = 3;
+            static constexpr std::uint64_t lsbs = 0x0101010101010101ULL;
+            static constexpr std::uint64_t msbs = 0x8080808080808080ULL;
+
+            explicit xflat_group(const std::int8_t* ctrl) noexcept
+            {
+                std::memcpy(&m_ctrl, ctrl, sizeof(m_ctrl));
+            }
+
+            // May report false positives, which are discarded by the key comparison.
+            std::uint64_t match(std::int8_t h2) const noexcept
+            {
+                std::uint64_t x = m_ctrl ^ (lsbs * static_cast<std::uint8_t>(h2));
+                return (x - lsbs) & ~x & msbs;
+            }
+
+            std::uint64_t match_empty() const noexcept
+            {
+                return m_ctrl & msbs;
+            }
+
+            std::uint64_t m_ctrl;
+#endif
+        };
+
+        inline std::size_t count_trailing_zeros(std::uint64_t m) noexcept
+        {
+#if defined(__GNUC__) || defined(__clang__)
+            return static_cast<std::size_t>(__builtin_ctzll(m));
+#else
+            std::size_t n = 0;
+            while ((m & 1u) == 0)
+            {
+                m >>= 1;
+                ++n;
+            }
+            return n;
+#endif
+        }
+    }
+
+    /******************
+     * xflat_hash_map *
+     ******************/
+
+    /**
+     * @class xflat_hash_map
+     * @brief Open-addressing hash map with dense storage.
+     *
+     * The xflat_hash_map class provides the subset of the std::unordered_map
+     * interface required by xaxis. The pairs key - value are stored in a
+     * dense vector in insertion order, and an open-addressing table of
+     * indices into this vector is probed one group of control bytes at a
+     * time, in the style of Swiss tables. The map does not support
+     * erasure of single elements.
+     *
+     * @tparam K the type of keys.
+     * @tparam T the type of mapped values.
+     * @tparam H the hash function used for keys.
+     */
+    template <class K, class T, class H = std::hash<K>>
+    class xflat_hash_map
+    {
+    public:
+
+        using key_type = K;
+        using mapped_type = T;
+        using hasher = H;
+        using value_type = std::pair<key_type, mapped_type>;
+        using container_type = std::vector<value_type>;
+        using reference = const value_type&;
+        using const_reference = const value_type&;
+        using pointer = const value_type*;
+        using const_pointer = const value_type*;
+        using size_type = typename container_type::size_type;
+        using difference_type = typename container_type::difference_type;
+        using iterator = typename container_type::const_iterator;
+        using const_iterator = typename container_type::const_iterator;
+
+        xflat_hash_map();
+
+        bool empty() const noexcept;
+        size_type size() const noexcept;
+
+        void reserve(size_type n);
+        template <class LL>
+        void assign(const LL& labels);
+        void clear() noexcept;
+
+        size_type count(const key_type& key) const;
+        const mapped_type& at(const key_type& key) const;
+        mapped_type& operator[](const key_type& key);
+
+        const_iterator find(const key_type& key) const;
+
+        static std::uint64_t hash(const key_type& key);
+        const_iterator find(const key_type& key, std::uint64_t h) const;
+        void prefetch(std::uint64_t h) const noexcept;
+
+        const_iterator begin() const noexcept;
+        const_iterator end() const noexcept;
+        const_iterator cbegin() const noexcept;
+        const_iterator cend() const noexcept;
+
+    private:
+
+        using group_type = detail::xflat_group;
+        static constexpr std::int8_t empty_ctrl = std::int8_t(-128);
+
+        static std::size_t capacity_for(size_type n) noexcept;
+
+        // Returns the slot holding the key, or the empty slot where it
+        // should be inserted, and whether the key was found.
+        std::pair<std::size_t, bool> probe(const key_type& key, std::uint64_t h) const;
+        void set_ctrl(std::size_t slot, std::int8_t h2) noexcept;
+        void rehash(std::size_t capacity);
+
+        container_type m_values;
+        std::vector<std::int8_t> m_ctrl;
+        std::vector<size_type> m_slots;
+        std::size_t m_capacity;
+    };
+
+    /*********************************
+     * xflat_hash_map implementation *
+     *********************************/
+
+    template <class K, class T, class H>
+    constexpr std::int8_t xflat_hash_map<K, T, H>::empty_ctrl;
+
+    template <class K, class T, class H>
+    inline xflat_hash_map<K, T, H>::xflat_hash_map()
+        : m_values(), m_ctrl(), m_slots(), m_capacity(0)
+    {
+    }
+
+    template <class K, class T, class H>
+    inline bool xflat_hash_map<K, T, H>::empty() const noexcept
+    {
+        return m_values.empty();
+    }
+
+    template <class K, class T, class H>
+    inline auto xflat_hash_map<K, T, H>::size() const noexcept -> size_type
+    {
+        return m_values.size();
+    }
+
+    /**
+     * Sizes the table so that \c n elements can be inserted
+     * without rehashing.
+     */
+    template <class K, class T, class H>
+    inline void xflat_hash_map<K, T, H>::reserve(size_type n)
+    {
+        m_values.reserve(n);
+        std::size_t capacity = capacity_for(n);
+        if (capacity > m_capacity)
+        {
+            rehash(capacity);
+        }
+    }
+
+    /**
+     * Replaces the content of the map with the pairs label - position
+     * of the specified list. The table is sized once for the whole list.
+     * When a label appears several times, its last position is kept.
+     * @param labels the list of labels.
+     */
+    template <class K, class T, class H>
+    template <class LL>
+    inline void xflat_hash_map<K, T, H>::assign(const LL& labels)
+    {
+        clear();
+        reserve(labels.size());
+        for (size_type i = 0; i < labels.size(); ++i)
+        {
+            (*this)[labels[i]] = T(i);
+        }
+    }
+
+    template <class K, class T, class H>
+    inline void xflat_hash_map<K, T, H>::clear() noexcept
+    {
+        m_values.clear();
+        std::fill(m_ctrl.begin(), m_ctrl.end(), empty_ctrl);
+    }
+
+    template <class K, class T, class H>
+    inline auto xflat_hash_map<K, T, H>::count(const key_type& key) const -> size_type
+    {
+        return find(key) != cend() ? size_type(1) : size_type(0);
+    }
+
+    /**
+     * Returns the value mapped to the specified key.
+     * @throws std::out_of_range if the key is not found.
+     */
+    template <class K, class T, class H>
+    inline auto xflat_hash_map<K, T, H>::at(const key_type& key) const -> const mapped_type&
+    {
+        auto it = find(key);
+        if (it == cend())
+        {
+            throw std::out_of_range("xflat_hash_map::at");
+        }
+        return it->second;
+    }
+
+    /**
+     * Returns the value mapped to the specified key, inserting a default
+     * constructed value if the key is not found.
+     */
+    template <class K, class T, class H>
+    inline auto xflat_hash_map<K, T, H>::operator[](const key_type& key) -> mapped_type&
+    {
+        std::uint64_t h = hash(key);
+        if (m_capacity != 0)
+        {
+            auto res = probe(key, h);
+            if (res.second)
+            {
+                return m_values[m_slots[res.first]].second;
+            }
+        }
+        if (capacity_for(m_values.size() + 1) > m_capacity)
+        {
+            rehash(capacity_for(m_values.size() + 1));
+        }
+        std::size_t slot = probe(key, h).first;
+        set_ctrl(slot, static_cast<std::int8_t>(h & 0x7F));
+        m_slots[slot] = m_values.size();
+        m_values.emplace_back(key, mapped_type());
+        return m_values.back().second;
+    }
+
+    template <class K, class T, class H>
+    inline auto xflat_hash_map<K, T, H>::find(const key_type& key) const -> const_iterator
+    {
+        return find(key, hash(key));
+    }
+
+    /**
+     * Returns the hash of the specified key, as used by the map. Batched
+     * lookups compute it once and pass it to prefetch and find.
+     */
+    template <class K, class T, class H>
+    inline std::uint64_t xflat_hash_map<K, T, H>::hash(const key_type& key)
+    {
+        // std::hash is the identity for integers on common implementations,
+        // the bits are mixed so that both the probe position and the 7-bit
+        // tag depend on the whole key.
+        std::uint64_t h = static_cast<std::uint64_t>(hasher()(key));
+        h = (h ^ (h >> 32)) * 0x9E3779B97F4A7C15ULL;
+        return h ^ (h >> 29);
+    }
+
+    /**
+     * Finds the specified key, whose hash has already been computed.
+     * @param key the key to search for.
+     * @param h the hash of the key, as returned by hash.
+     */
+    template <class K, class T, class H>
+    inline auto xflat_hash_map<K, T, H>::find(const key_type& key, std::uint64_t h) const -> const_iterator
+    {
+        if (m_values.empty())
+        {
+            return cend();
+        }
+        auto res = probe(key, h);
+        return res.second ? cbegin() + static_cast<difference_type>(m_slots[res.first]) : cend();
+    }
+
+    /**
+     * Hints the processor to load the first group of control bytes
+     * probed for the given hash, so that the probes of a batch of keys
+     * overlap their cache misses.
+     */
+    template <class K, class T, class H>
+    inline void xflat_hash_map<K, T, H>::prefetch(std::uint64_t h) const noexcept
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        if (m_capacity != 0)
+        {
+            std::size_t pos = static_cast<std::size_t>(h >> 7) & (m_capacity - 1);
+            __builtin_prefetch(m_ctrl.data() + pos);
+            __builtin_prefetch(m_slots.data() + pos);
+        }
+#else
+        (void)h;
+#endif
+    }
+
+    template <class K, class T, class H>
+    inline auto xflat_hash_map<K, T, H>::begin() const noexcept -> const_iterator
+    {
+        return cbegin();
+    }
+
+    template <class K, class T, class H>
+    inline auto xflat_hash_map<K, T, H>::end() const noexcept -> const_iterator
+    {
+        return cend();
+    }
+
+    template <class K, class T, class H>
+    inline auto xflat_hash_map<K, T, H>::cbegin() const noexcept -> const_iterator
+    {
+        return m_values.cbegin();
+    }
+
+    template <class K, class T, class H>
+    inline auto xflat_hash_map<K, T, H>::cend() const noexcept -> const_iterator
+    {
+        return m_values.cend();
+    }
+
+    // Smallest power of two holding n elements with a load factor below 7/8.
+    template <class K, class T, class H>
+    inline std::size_t xflat_hash_map<K, T, H>::capacity_for(size_type n) noexcept
+    {
+        std::size_t capacity = group_type::width;
+        while (capacity - capacity / 8 < n)
+        {
+            capacity *= 2;
+        }
+        return capacity;
+    }
+
+    template <class K, class T, class H>
+    inline std::pair<std::size_t, bool> xflat_hash_map<K, T, H>::probe(const key_type& key, std::uint64_t h) const
+    {
+        const std::size_t mask = m_capacity - 1;
+        const std::int8_t h2 = static_cast<std::int8_t>(h & 0x7F);
+        std::size_t pos = static_cast<std::size_t>(h >> 7) & mask;
+        std::size_t step = 0;
+        while (true)
+        {
+            group_type group(m_ctrl.data() + pos);
+            for (std::uint64_t m = group.match(h2); m != 0; m &= m - 1)
+            {
+                std::size_t slot = (pos + (detail::count_trailing_zeros(m) >> group_type::shift)) & mask;
+                if (m_ctrl[slot] == h2 && m_values[m_slots[slot]].first == key)
+                {
+                    return std::make_pair(slot, true);
+                }
+            }
+            std::uint64_t e = group.match_empty();
+            if (e != 0)
+            {
+                return std::make_pair((pos + (detail::count_trailing_zeros(e) >> group_type::shift)) & mask, false);
+            }
+            // Triangular probing visits every group of a power of two table.
+            step += group_type::width;
+            pos = (pos + step) & mask;
+        }
+    }
+
+    // The first group is mirrored after the last control byte so that
+    // groups starting near the end of the table can be loaded at once.
+    template <class K, class T, class H>
+    inline void xflat_hash_map<K, T, H>::set_ctrl(std::size_t slot, std::int8_t h2) noexcept
+    {
+        m_ctrl[slot] = h2;
+        if (slot < group_type::width)
+        {
+            m_ctrl[m_capacity + slot] = h2;
+        }
+    }
+
+    template <class K, class T, class H>
+    inline void xflat_hash_map<K, T, H>::rehash(std::size_t capacity)
+    {
+        m_capacity = capacity;
+        m_ctrl.assign(capacity + group_type::width, empty_ctrl);
+        m_slots.assign(capacity, size_type(0));
+        for (size_type i = 0; i < m_values.size(); ++i)
+        {
+            std::uint64_t h = hash(m_values[i].first);
+            std::size_t slot = probe(m_values[i].first, h).first;
+            set_ctrl(slot, static_cast<std::int8_t>(h & 0x7F));
+            m_slots[slot] = i;
+        }
+    }
+}
+
+#endif
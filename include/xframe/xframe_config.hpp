@@ -35,11 +35,21 @@ namespace xf
 #define XFRAME_DEFAULT_JOIN join::inner
 #endif
 
+// Tracks missing values with a bitmap instead of an array of bool
+#ifndef XFRAME_USE_BITMASK
+#define XFRAME_USE_BITMASK 0
+#endif
+
 #ifndef XFRAME_DEFAULT_DATA_CONTAINER
+#if XFRAME_USE_BITMASK
+#include "xoptional_bitmask.hpp"
+#define XFRAME_DEFAULT_DATA_CONTAINER(T) xf::xbitmask_optional<T>
+#else
 #include "xtensor/xarray.hpp"
 #include "xtensor/xoptional_assembly.hpp"
 #define XFRAME_DEFAULT_DATA_CONTAINER(T) xt::xoptional_assembly<xt::xarray<T>, xt::xarray<bool>>
 #endif
+#endif
 
 // A higher number leads to an ICE on VS 2015
 #ifndef XFRAME_STATIC_DIMENSION_LIMIT
@@ -11,9 +11,14 @@
 #ifndef XFRAME_XFRAME_UTILS_HPP
 #define XFRAME_XFRAME_UTILS_HPP
 
+#include <algorithm>
+#include <cstddef>
 #include <iterator>
 #include <ostream>
 #include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
 
 #include "xtensor/xio.hpp"
 
@@ -39,45 +44,95 @@ namespace xf
 
     namespace detail
     {
-        template <class C0, class C1>
-        inline bool merge_containers(C0& output, const C1& input)
+        template <class C>
+        using xsorted_cursor = std::pair<typename C::const_iterator, typename C::const_iterator>;
+
+        template <class C>
+        inline xsorted_cursor<C> make_sorted_cursor(const C& c)
+        {
+            return xsorted_cursor<C>(c.begin(), c.end());
+        }
+
+        template <class V, class It>
+        inline void merge_min(const V*& min, const std::pair<It, It>& c)
         {
-            bool res = !(input.size() < output.size());
-            auto output_iter = output.begin();
-            auto output_end = output.end();
-            auto first = input.begin();
-            auto last = input.end();
-            while(first != last && output_iter != output_end)
+            if (c.first != c.second && (min == nullptr || *(c.first) < *min))
             {
-                if(*first < *output_iter)
-                {
-                    output_iter = output.insert(output_iter, *first++);
-                    output_end = output.end();
-                    res = false;
-                }
-                else if(*first == *output_iter)
-                {
-                    ++first;
-                }
-                ++output_iter;
+                min = &(*(c.first));
             }
-            res &= output.empty() || (first == last);
-            std::copy(first, last, std::back_inserter(output));
-            return res;
         }
 
-        template <class C0>
-        inline bool merge_to_impl(C0&)
+        // Moves the cursor past the copies of value it points to, and
+        // returns their number.
+        template <class V, class It>
+        inline std::size_t merge_advance(const V& value, std::pair<It, It>& c)
         {
-            return true;
+            std::size_t count = 0;
+            while (c.first != c.second && *(c.first) == value)
+            {
+                ++(c.first);
+                ++count;
+            }
+            return count;
         }
 
-        template <class C0, class C1, class... C>
-        inline bool merge_to_impl(C0& out, C1& in, const C&... input)
+        // A container has the same labels as the merge result if it is
+        // equal to it, or if it is empty and precedes all the non empty
+        // containers.
+        template <class CO, class C>
+        inline bool merge_same_labels(const CO& result, const C& c, bool& started)
         {
-            bool res = merge_containers(out, in);
-            res &= merge_to_impl(out, input...);
-            return res;
+            if (c.empty())
+            {
+                return !started;
+            }
+            started = true;
+            return c.size() == result.size() && std::equal(c.begin(), c.end(), result.begin());
+        }
+
+        template <class V, class Tuple, std::size_t... I>
+        inline const V* merge_min_all(const Tuple& cursors, std::index_sequence<I...>)
+        {
+            const V* min = nullptr;
+            bool dummy[] = { (merge_min(min, std::get<I>(cursors)), true)... };
+            (void)dummy;
+            return min;
+        }
+
+        template <class V, class Tuple, std::size_t... I>
+        inline std::size_t merge_advance_all(const V& value, Tuple& cursors, std::index_sequence<I...>)
+        {
+            std::size_t counts[] = { merge_advance(value, std::get<I>(cursors))... };
+            return *std::max_element(std::begin(counts), std::end(counts));
+        }
+
+        template <class CO, class... CI>
+        inline bool merge_to_impl(CO& output, const CI&... input)
+        {
+            using value_type = typename CO::value_type;
+            auto cursors = std::make_tuple(make_sorted_cursor(output), make_sorted_cursor(input)...);
+            auto seq = std::make_index_sequence<sizeof...(CI) + 1>();
+
+            std::size_t sizes[] = { output.size(), std::size_t(input.size())... };
+            CO res;
+            res.reserve(*std::max_element(std::begin(sizes), std::end(sizes)));
+
+            // A value repeated in some containers is repeated as many times
+            // in the result as in the container holding most copies of it.
+            // The containers are not modified until the end, so min stays
+            // valid while the cursors advance.
+            const value_type* min = merge_min_all<value_type>(cursors, seq);
+            while (min != nullptr)
+            {
+                std::size_t count = merge_advance_all(*min, cursors, seq);
+                res.insert(res.end(), count, *min);
+                min = merge_min_all<value_type>(cursors, seq);
+            }
+
+            bool started = false;
+            bool same[] = { merge_same_labels(res, output, started), merge_same_labels(res, input, started)... };
+            output.swap(res);
+            return std::all_of(std::begin(same), std::end(same), [](bool b) { return b; });
         }
 
         template <class S, std::size_t N>
@@ -90,6 +145,11 @@ namespace xf
         using xselector_sequence_t = typename xselector_sequence<S, N>::type;
     }
 
+    /**
+     * Merges the sorted containers \c input into the sorted container
+     * \c output, in a single pass over all the containers.
+     * @return true if all the containers hold the same elements as the result.
+     */
     template <class CO, class... CI>
     inline bool merge_to(CO& output, const CI&... input)
     {
@@ -102,52 +162,67 @@ namespace xf
 
     namespace detail
     {
-        template <class C0, class C1>
-        inline bool intersect_containers(C0& output, const C1& input)
+        // Moves the cursor past the elements less than value and the
+        // copies of value, and returns the number of these copies.
+        template <class V, class It>
+        inline std::size_t intersect_count(const V& value, std::pair<It, It>& c)
         {
-            bool res = !(input.size() < output.size());
-            auto output_iter = output.begin();
-            auto output_end = output.end();
-            auto first = input.begin();
-            auto last = input.end();
-            while(first != last && output_iter != output_end)
+            while (c.first != c.second && *(c.first) < value)
             {
-                if(*first < *output_iter)
-                {
-                    ++first;
-                }
-                else if(*first == *output_iter)
-                {
-                    ++first;
-                    ++output_iter;
-                }
-                else // *first > *output_iter
-                {
-                    output_iter = output.erase(output_iter);
-                    output_end = output.end();
-                    res = false;
-                }
+                ++(c.first);
             }
-            res &= (output_iter == output_end);
-            output.erase(output_iter, output_end);
-            return res;
+            return merge_advance(value, c);
         }
 
-        template <class C0>
-        inline bool intersect_to_impl(C0&)
+        template <class V, class Tuple, std::size_t... I>
+        inline std::size_t intersect_count_all(const V& value, std::size_t count, Tuple& cursors, std::index_sequence<I...>)
         {
-            return true;
+            std::size_t counts[] = { count, intersect_count(value, std::get<I>(cursors))... };
+            return *std::min_element(std::begin(counts), std::end(counts));
         }
 
-        template <class C0, class C1, class... C>
-        inline bool intersect_to_impl(C0& out, const C1& in, const C&... input)
+        template <class CO, class... CI>
+        inline bool intersect_to_impl(CO& output, const CI&... input)
         {
-            bool res = intersect_containers(out, in);
-            res &= intersect_to_impl(out, input...);
+            auto cursors = std::make_tuple(make_sorted_cursor(input)...);
+            auto seq = std::make_index_sequence<sizeof...(CI)>();
+
+            // A value repeated in some containers is kept as many times as
+            // in the container holding fewest copies of it. Elements are
+            // copied rather than moved since an input may alias the output;
+            // the cursors of such an input only read past the run being
+            // processed, which is never written to.
+            std::size_t w = 0;
+            std::size_t r = 0;
+            while (r < output.size())
+            {
+                std::size_t e = r + 1;
+                while (e < output.size() && output[e] == output[r])
+                {
+                    ++e;
+                }
+                std::size_t count = intersect_count_all(output[r], e - r, cursors, seq);
+                for (std::size_t i = r; i < r + count; ++i, ++w)
+                {
+                    if (w != i)
+                    {
+                        output[w] = output[i];
+                    }
+                }
+                r = e;
+            }
+            bool res = w == output.size();
+            output.erase(output.begin() + static_cast<std::ptrdiff_t>(w), output.end());
             return res;
         }
     }
 
+    /**
+     * Replaces the sorted container \c output with its intersection with
+     * the sorted containers \c input, in a single pass over all the
+     * containers and without allocation.
+     * @return true if \c output is left unchanged.
+     */
     template <class CO, class... CI>
     inline bool intersect_to(CO& output, const CI&... input)
     {
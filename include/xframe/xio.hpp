@@ -11,18 +11,167 @@
 #ifndef XFRAME_IO_HPP
 #define XFRAME_IO_HPP
 
+#include <algorithm>
+#include <numeric>
 #include <sstream>
+#include <string>
+#include <vector>
 
 #include "xtensor/xio.hpp"
 
-#ifdef __CLING__
-
-#include <nlohmann/json.hpp>
-
-namespace nl = nlohmann;
+#include "xframe_utils.hpp"
 
 namespace xf
 {
+    namespace detail
+    {
+        /**
+         * Positions displayed along an axis of the specified size: all of
+         * them, or the edge_items first and last ones.
+         */
+        inline std::vector<std::size_t> repr_positions(std::size_t size, std::size_t edge_items)
+        {
+            std::vector<std::size_t> res;
+            if (edge_items == 0 || 2 * edge_items >= size)
+            {
+                res.resize(size);
+                std::iota(res.begin(), res.end(), std::size_t(0));
+            }
+            else
+            {
+                for (std::size_t i = 0; i < edge_items; ++i)
+                {
+                    res.push_back(i);
+                }
+                for (std::size_t i = size - edge_items; i < size; ++i)
+                {
+                    res.push_back(i);
+                }
+            }
+            return res;
+        }
+
+        /**
+         * Feeds the printer with the displayed elements only, in the order
+         * the tables print them, so that an expression is evaluated at these
+         * elements and nowhere else.
+         */
+        template <class P, class T>
+        void update_repr_printer(P& printer, const T& expr, const std::size_t& edge_items)
+        {
+            const std::size_t dim = expr.dimension();
+            std::vector<std::vector<std::size_t>> positions(dim);
+            for (std::size_t d = 0; d < dim; ++d)
+            {
+                positions[d] = repr_positions(expr.shape()[d], edge_items);
+                if (positions[d].empty())
+                {
+                    return;
+                }
+            }
+
+            typename T::template index_type<> index(dim);
+            std::vector<std::size_t> counter(dim, 0);
+            std::size_t d = dim;
+            do
+            {
+                for (std::size_t i = 0; i < dim; ++i)
+                {
+                    index[i] = positions[i][counter[i]];
+                }
+                printer.update(expr.element(index));
+                for (d = dim; d != 0; --d)
+                {
+                    if (++counter[d - 1] != positions[d - 1].size())
+                    {
+                        break;
+                    }
+                    counter[d - 1] = 0;
+                }
+            } while (d != 0);
+        }
+
+        /**
+         * Element access through labels for expressions without element
+         * method, such as xvariable_function whose operands may have to be
+         * reindexed. The shape is the one of the coordinates.
+         */
+        template <class E>
+        class xselect_repr
+        {
+        public:
+
+            using data_type = typename E::data_type;
+            using value_type = typename E::value_type;
+            using const_reference = typename E::const_reference;
+            using shape_type = std::vector<std::size_t>;
+            template <std::size_t N = dynamic()>
+            using index_type = std::vector<std::size_t>;
+
+            explicit xselect_repr(const E& e);
+
+            std::size_t dimension() const;
+            decltype(auto) dimension_mapping() const;
+            decltype(auto) coordinates() const;
+            const shape_type& shape() const;
+
+            const_reference element(const index_type<>& index) const;
+
+        private:
+
+            const E& m_e;
+            shape_type m_shape;
+        };
+
+        template <class E>
+        inline xselect_repr<E>::xselect_repr(const E& e)
+            : m_e(e), m_shape()
+        {
+            for (const auto& dim_name : m_e.dimension_mapping().labels())
+            {
+                m_shape.push_back(m_e.coordinates()[dim_name].size());
+            }
+        }
+
+        template <class E>
+        inline std::size_t xselect_repr<E>::dimension() const
+        {
+            return m_shape.size();
+        }
+
+        template <class E>
+        inline decltype(auto) xselect_repr<E>::dimension_mapping() const
+        {
+            return m_e.dimension_mapping();
+        }
+
+        template <class E>
+        inline decltype(auto) xselect_repr<E>::coordinates() const
+        {
+            return m_e.coordinates();
+        }
+
+        template <class E>
+        inline auto xselect_repr<E>::shape() const -> const shape_type&
+        {
+            return m_shape;
+        }
+
+        template <class E>
+        inline auto xselect_repr<E>::element(const index_type<>& index) const -> const_reference
+        {
+            using selector_sequence_type = typename E::template selector_sequence_type<>;
+            const auto& dim_names = m_e.dimension_mapping().labels();
+            selector_sequence_type selector;
+            selector.reserve(index.size());
+            for (std::size_t i = 0; i < index.size(); ++i)
+            {
+                selector.emplace_back(dim_names[i], m_e.coordinates()[dim_names[i]].label(index[i]));
+            }
+            return m_e.select(std::move(selector));
+        }
+    }
+
     template <class P, class T>
     void compute_1d_row(std::stringstream& out, P& printer, const T& expr,
                         const std::size_t& row_idx)
@@ -120,7 +269,7 @@ namespace xf
             std::size_t current_dim = 0;
             for (auto it = idx.cbegin(); it != idx.cend(); ++it)
             {
-                if (*(it + 1) == 0 || it + 1 == idx.cend())
+                if (it + 1 == idx.cend() || *(it + 1) == 0)
                 {
                     const auto& current_dim_name = expr.dimension_mapping().label(current_dim);
 
@@ -360,7 +509,16 @@ namespace xf
             xf::compute_nd_table_impl(out, printer, expr, edge_items);
         }
     }
+}
 
+#ifdef __CLING__
+
+#include <nlohmann/json.hpp>
+
+namespace nl = nlohmann;
+
+namespace xf
+{
     template <class T>
     nl::json mime_bundle_repr_impl(const T& expr)
     {
@@ -379,9 +537,7 @@ namespace xf
         }
 
         xt::detail::printer<typename T::data_type> printer(out.precision());
-
-        xt::xstrided_slice_vector slice_vector;
-        xt::detail::recurser_run(printer, expr.data(), slice_vector, edge_items);
+        detail::update_repr_printer(printer, expr, edge_items);
         printer.init();
 
         xf::compute_nd_table(out, printer, expr, edge_items);
@@ -406,9 +562,7 @@ namespace xf
     template <class F, class R, class... CT>
     nl::json mime_bundle_repr(const xvariable_function<F, R, CT...>& expr)
     {
-        using temporary_type = typename xvariable_function<F, R, CT...>::temporary_type;
-        temporary_type tmp(expr);
-        return xf::mime_bundle_repr_impl(tmp);
+        return xf::mime_bundle_repr_impl(detail::xselect_repr<xvariable_function<F, R, CT...>>(expr));
     }
 
     template <class CT>
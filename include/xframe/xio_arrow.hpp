@@ -0,0 +1,1213 @@
+/***************************************************************************
+* Copyright (c) Johan Mabille, Sylvain Corlay, Wolf Vollprecht and         *
+* Martin Renou                                                             *
+* Copyright (c) QuantStack                                                 *
+*                                                                          *
+* Distributed under the terms of the BSD 3-Clause License.                 *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#ifndef XFRAME_IO_ARROW_HPP
+#define XFRAME_IO_ARROW_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "xdynamic_variable.hpp"
+#include "xio_binary.hpp"
+#include "xio_mmap.hpp"
+#include "xvariable.hpp"
+
+namespace xf
+{
+    /**
+     * @class arrow_options
+     * @brief Mapping between a 2-D variable and an Arrow table.
+     *
+     * Each label of the column dimension is an Arrow column, named after
+     * the label; the labels of the row dimension are stored in the index
+     * column. When index_column is empty, no index column is written, and
+     * the row axis of a variable read from a file is a default axis.
+     */
+    struct arrow_options
+    {
+        std::string index_column = "index";
+        std::string column_dimension = "column";
+        std::string row_dimension = "row";
+    };
+
+    /******************
+     * arrow_variable *
+     ******************/
+
+    /**
+     * @class arrow_variable
+     * @brief Variable read from an Arrow IPC file.
+     *
+     * The file is mapped copy-on-write. When the file holds a single record
+     * batch whose value buffers have the value type of the variable and are
+     * stored one after the other, the data of the variable is an adaptor on
+     * the mapping, nothing is copied; otherwise the values are gathered in a
+     * buffer owned by this object. Arrow validity bitmaps hold one bit per
+     * value, they are always expanded into the missing mask.
+     *
+     * The variable refers to buffers owned by this object; a dynamic variable
+     * can be built on it with make_dynamic(v.variable()).
+     */
+    template <class T, class K = fstring, class L = XFRAME_DEFAULT_LABEL_LIST, class S = std::size_t, class MT = hash_map_tag>
+    class arrow_variable
+    {
+    public:
+
+        using value_type = T;
+        using variable_type = typename xmapped_variable<T, K, L, S, MT>::variable_type;
+        using coordinate_type = typename xmapped_variable<T, K, L, S, MT>::coordinate_type;
+        using dimension_type = typename xmapped_variable<T, K, L, S, MT>::dimension_type;
+        using data_type = typename xmapped_variable<T, K, L, S, MT>::data_type;
+
+        explicit arrow_variable(const std::string& filename, const arrow_options& options = arrow_options());
+
+        arrow_variable(const arrow_variable&) = delete;
+        arrow_variable& operator=(const arrow_variable&) = delete;
+
+        arrow_variable(arrow_variable&&) = default;
+        arrow_variable& operator=(arrow_variable&&) = delete;
+
+        variable_type& variable() noexcept;
+        const variable_type& variable() const noexcept;
+
+        bool is_mapped() const noexcept;
+
+    private:
+
+        variable_type load(const std::string& filename, const arrow_options& options);
+
+        detail::xmapped_file m_file;
+        std::vector<char> m_buffer;
+        std::vector<T> m_values;
+        std::unique_ptr<bool[]> m_mask;
+        bool m_mapped;
+        variable_type m_variable;
+    };
+
+    template <class V>
+    void write_arrow(const std::string& filename, const V& v, const arrow_options& options = arrow_options());
+
+    template <class T, class K = fstring, class L = XFRAME_DEFAULT_LABEL_LIST, class S = std::size_t, class MT = hash_map_tag>
+    arrow_variable<T, K, L, S, MT> read_arrow(const std::string& filename, const arrow_options& options = arrow_options());
+
+    namespace detail
+    {
+        /**
+         * Identifiers of the Arrow flatbuffer schema.
+         */
+        struct xarrow
+        {
+            enum : int16_t
+            {
+                metadata_v5 = 4
+            };
+
+            enum : uint8_t
+            {
+                header_schema = 1,
+                header_record_batch = 3
+            };
+
+            enum : uint8_t
+            {
+                type_int = 2,
+                type_floating_point = 3,
+                type_utf8 = 5
+            };
+
+            enum : int16_t
+            {
+                precision_single = 1,
+                precision_double = 2
+            };
+        };
+
+        /**
+         * Type of an Arrow column: type_int with a bit width and a sign,
+         * type_floating_point with a precision, or type_utf8.
+         */
+        struct xarrow_type
+        {
+            uint8_t id;
+            int32_t bit_width;
+            bool is_signed;
+        };
+
+        template <class T>
+        inline xarrow_type arrow_type_of()
+        {
+            static_assert(std::is_arithmetic<T>::value && !std::is_same<T, bool>::value,
+                          "only integer and floating point values are supported");
+            return std::is_floating_point<T>::value
+                ? xarrow_type{xarrow::type_floating_point, static_cast<int32_t>(8 * sizeof(T)), true}
+                : xarrow_type{xarrow::type_int, static_cast<int32_t>(8 * sizeof(T)), std::is_signed<T>::value};
+        }
+
+        inline bool operator==(const xarrow_type& lhs, const xarrow_type& rhs)
+        {
+            return lhs.id == rhs.id && (lhs.id == xarrow::type_utf8
+                || (lhs.bit_width == rhs.bit_width && (lhs.id != xarrow::type_int || lhs.is_signed == rhs.is_signed)));
+        }
+
+        /**********************
+         * xflatbuffer_writer *
+         **********************/
+
+        /**
+         * @class xflatbuffer_writer
+         * @brief Minimal flatbuffer builder.
+         *
+         * Objects are written front to back: a table is written before the
+         * objects it refers to, its offset fields are set once they are
+         * written, since offsets always point forward. The vtable of a table
+         * is written just before it.
+         */
+        class xflatbuffer_writer
+        {
+        public:
+
+            xflatbuffer_writer();
+
+            std::size_t add_table(std::initializer_list<std::size_t> field_sizes);
+            std::size_t add_string(const std::string& str);
+            std::size_t add_offset_vector(std::size_t count);
+            template <class T>
+            std::size_t add_struct_vector(const std::vector<T>& elements);
+
+            template <class T>
+            void set(std::size_t table, std::size_t field, T value);
+            void set_offset(std::size_t table, std::size_t field, std::size_t target);
+            void set_element(std::size_t vector, std::size_t index, std::size_t target);
+            void set_root(std::size_t table);
+
+            const std::vector<char>& buffer();
+
+        private:
+
+            void align(std::size_t alignment);
+            std::size_t field_position(std::size_t table, std::size_t field) const;
+            void write_offset(std::size_t position, std::size_t target);
+
+            std::vector<char> m_buffer;
+        };
+
+        /**********************
+         * xflatbuffer_reader *
+         **********************/
+
+        /**
+         * @class xflatbuffer_reader
+         * @brief Bounds-checked access to the tables of a flatbuffer.
+         */
+        class xflatbuffer_reader
+        {
+        public:
+
+            xflatbuffer_reader(const char* data, std::size_t size);
+
+            std::size_t root() const;
+
+            template <class T>
+            T get(std::size_t table, std::size_t field, T default_value) const;
+            std::size_t table(std::size_t table, std::size_t field) const;
+            std::size_t vector(std::size_t table, std::size_t field, std::size_t& count, std::size_t element_size) const;
+            std::string string(std::size_t table, std::size_t field) const;
+            std::size_t element(std::size_t vector, std::size_t index) const;
+            template <class T>
+            T read(std::size_t position) const;
+
+        private:
+
+            std::size_t field_position(std::size_t table, std::size_t field) const;
+            std::size_t follow(std::size_t position) const;
+            void check(std::size_t position, std::size_t length) const;
+
+            const char* p_data;
+            std::size_t m_size;
+        };
+
+        /*************************************
+         * xflatbuffer_writer implementation *
+         *************************************/
+
+        inline xflatbuffer_writer::xflatbuffer_writer()
+            : m_buffer(4, '\0')
+        {
+        }
+
+        /**
+         * Adds a table whose fields have the specified sizes, a size of 0
+         * meaning the field is absent, and returns its position.
+         */
+        inline std::size_t xflatbuffer_writer::add_table(std::initializer_list<std::size_t> field_sizes)
+        {
+            std::vector<uint16_t> vtable(2 + field_sizes.size(), 0);
+            uint16_t offset = 4;
+            std::size_t index = 2;
+            for (auto size : field_sizes)
+            {
+                if (size != 0)
+                {
+                    offset = static_cast<uint16_t>((offset + size - 1) / size * size);
+                    vtable[index] = offset;
+                    offset = static_cast<uint16_t>(offset + size);
+                }
+                ++index;
+            }
+            vtable[0] = static_cast<uint16_t>(2 * vtable.size());
+            vtable[1] = offset;
+
+            align(2);
+            const std::size_t vtable_position = m_buffer.size();
+            m_buffer.resize(m_buffer.size() + 2 * vtable.size());
+            std::memcpy(m_buffer.data() + vtable_position, vtable.data(), 2 * vtable.size());
+            align(8);
+            const std::size_t table_position = m_buffer.size();
+            m_buffer.resize(m_buffer.size() + offset, '\0');
+            const int32_t soffset = static_cast<int32_t>(table_position - vtable_position);
+            std::memcpy(m_buffer.data() + table_position, &soffset, sizeof(soffset));
+            return table_position;
+        }
+
+        inline std::size_t xflatbuffer_writer::add_string(const std::string& str)
+        {
+            align(4);
+            const std::size_t position = m_buffer.size();
+            const uint32_t length = static_cast<uint32_t>(str.size());
+            m_buffer.resize(position + 4 + str.size() + 1, '\0');
+            std::memcpy(m_buffer.data() + position, &length, sizeof(length));
+            std::memcpy(m_buffer.data() + position + 4, str.data(), str.size());
+            return position;
+        }
+
+        inline std::size_t xflatbuffer_writer::add_offset_vector(std::size_t count)
+        {
+            align(4);
+            const std::size_t position = m_buffer.size();
+            const uint32_t length = static_cast<uint32_t>(count);
+            m_buffer.resize(position + 4 + 4 * count, '\0');
+            std::memcpy(m_buffer.data() + position, &length, sizeof(length));
+            return position;
+        }
+
+        template <class T>
+        inline std::size_t xflatbuffer_writer::add_struct_vector(const std::vector<T>& elements)
+        {
+            // the elements, not the length, are aligned on 8 bytes
+            align(8);
+            m_buffer.resize(m_buffer.size() + 4, '\0');
+            const std::size_t position = m_buffer.size();
+            const uint32_t length = static_cast<uint32_t>(elements.size());
+            m_buffer.resize(position + 4 + sizeof(T) * elements.size(), '\0');
+            std::memcpy(m_buffer.data() + position, &length, sizeof(length));
+            std::memcpy(m_buffer.data() + position + 4, elements.data(), sizeof(T) * elements.size());
+            return position;
+        }
+
+        template <class T>
+        inline void xflatbuffer_writer::set(std::size_t table, std::size_t field, T value)
+        {
+            std::memcpy(m_buffer.data() + field_position(table, field), &value, sizeof(T));
+        }
+
+        inline void xflatbuffer_writer::set_offset(std::size_t table, std::size_t field, std::size_t target)
+        {
+            write_offset(field_position(table, field), target);
+        }
+
+        inline void xflatbuffer_writer::set_element(std::size_t vector, std::size_t index, std::size_t target)
+        {
+            write_offset(vector + 4 + 4 * index, target);
+        }
+
+        inline void xflatbuffer_writer::set_root(std::size_t table)
+        {
+            write_offset(0, table);
+        }
+
+        inline const std::vector<char>& xflatbuffer_writer::buffer()
+        {
+            align(8);
+            return m_buffer;
+        }
+
+        inline void xflatbuffer_writer::align(std::size_t alignment)
+        {
+            m_buffer.resize((m_buffer.size() + alignment - 1) / alignment * alignment, '\0');
+        }
+
+        inline std::size_t xflatbuffer_writer::field_position(std::size_t table, std::size_t field) const
+        {
+            int32_t soffset;
+            std::memcpy(&soffset, m_buffer.data() + table, sizeof(soffset));
+            uint16_t offset;
+            std::memcpy(&offset, m_buffer.data() + table - static_cast<std::size_t>(soffset) + 4 + 2 * field, sizeof(offset));
+            return table + offset;
+        }
+
+        inline void xflatbuffer_writer::write_offset(std::size_t position, std::size_t target)
+        {
+            const uint32_t offset = static_cast<uint32_t>(target - position);
+            std::memcpy(m_buffer.data() + position, &offset, sizeof(offset));
+        }
+
+        /*************************************
+         * xflatbuffer_reader implementation *
+         *************************************/
+
+        inline xflatbuffer_reader::xflatbuffer_reader(const char* data, std::size_t size)
+            : p_data(data), m_size(size)
+        {
+        }
+
+        inline std::size_t xflatbuffer_reader::root() const
+        {
+            return follow(0);
+        }
+
+        template <class T>
+        inline T xflatbuffer_reader::get(std::size_t table, std::size_t field, T default_value) const
+        {
+            const std::size_t position = field_position(table, field);
+            return position == 0 ? default_value : read<T>(position);
+        }
+
+        inline std::size_t xflatbuffer_reader::table(std::size_t table, std::size_t field) const
+        {
+            const std::size_t position = field_position(table, field);
+            return position == 0 ? 0 : follow(position);
+        }
+
+        /**
+         * Returns the position of the first element of a vector field, and
+         * its number of elements in count; count is 0 if the field is absent.
+         */
+        inline std::size_t xflatbuffer_reader::vector(std::size_t table, std::size_t field, std::size_t& count, std::size_t element_size) const
+        {
+            count = 0;
+            const std::size_t position = field_position(table, field);
+            if (position == 0)
+                return 0;
+            const std::size_t vector = follow(position);
+            count = read<uint32_t>(vector);
+            if (count > (m_size - vector - 4) / element_size)
+                throw std::runtime_error("invalid arrow metadata");
+            return vector + 4;
+        }
+
+        inline std::string xflatbuffer_reader::string(std::size_t table, std::size_t field) const
+        {
+            std::size_t length = 0;
+            const std::size_t position = vector(table, field, length, 1);
+            return std::string(p_data + position, length);
+        }
+
+        inline std::size_t xflatbuffer_reader::element(std::size_t vector, std::size_t index) const
+        {
+            return follow(vector + 4 * index);
+        }
+
+        template <class T>
+        inline T xflatbuffer_reader::read(std::size_t position) const
+        {
+            check(position, sizeof(T));
+            T res;
+            std::memcpy(&res, p_data + position, sizeof(T));
+            return res;
+        }
+
+        // 0 when the field is absent; a table never starts at 0
+        inline std::size_t xflatbuffer_reader::field_position(std::size_t table, std::size_t field) const
+        {
+            const int64_t vtable = static_cast<int64_t>(table) - read<int32_t>(table);
+            if (vtable < 0)
+                throw std::runtime_error("invalid arrow metadata");
+            const std::size_t vtable_position = static_cast<std::size_t>(vtable);
+            const uint16_t vtable_size = read<uint16_t>(vtable_position);
+            if (4 + 2 * field >= vtable_size)
+                return 0;
+            const uint16_t offset = read<uint16_t>(vtable_position + 4 + 2 * field);
+            return offset == 0 ? 0 : table + offset;
+        }
+
+        inline std::size_t xflatbuffer_reader::follow(std::size_t position) const
+        {
+            const std::size_t target = position + read<uint32_t>(position);
+            check(target, 4);
+            return target;
+        }
+
+        inline void xflatbuffer_reader::check(std::size_t position, std::size_t length) const
+        {
+            if (position > m_size || length > m_size - position)
+                throw std::runtime_error("invalid arrow metadata");
+        }
+
+        /***********************
+         * Arrow file encoding *
+         ***********************/
+
+        struct xarrow_block
+        {
+            int64_t offset;
+            int32_t metadata_length;
+            int32_t padding;
+            int64_t body_length;
+        };
+
+        struct xarrow_buffer
+        {
+            int64_t offset;
+            int64_t length;
+        };
+
+        struct xarrow_node
+        {
+            int64_t length;
+            int64_t null_count;
+        };
+
+        constexpr char arrow_magic[6] = {'A', 'R', 'R', 'O', 'W', '1'};
+
+        inline std::size_t arrow_padding(std::size_t length)
+        {
+            return (8 - length % 8) % 8;
+        }
+
+        /**
+         * Adds a field to a schema being built and returns its position.
+         */
+        inline std::size_t add_arrow_field(xflatbuffer_writer& fb, const std::string& name, const xarrow_type& type)
+        {
+            // name, nullable, type_type, type, dictionary, children
+            const std::size_t field = fb.add_table({4, 1, 1, 4, 0, 4});
+            fb.set(field, 1, uint8_t(1));
+            fb.set(field, 2, type.id);
+            fb.set_offset(field, 0, fb.add_string(name));
+            std::size_t type_table = 0;
+            if (type.id == xarrow::type_int)
+            {
+                type_table = fb.add_table({4, 1});
+                fb.set(type_table, 0, type.bit_width);
+                fb.set(type_table, 1, uint8_t(type.is_signed));
+            }
+            else if (type.id == xarrow::type_floating_point)
+            {
+                type_table = fb.add_table({2});
+                fb.set(type_table, 0, type.bit_width == 32 ? int16_t(xarrow::precision_single) : int16_t(xarrow::precision_double));
+            }
+            else
+            {
+                type_table = fb.add_table({});
+            }
+            fb.set_offset(field, 3, type_table);
+            fb.set_offset(field, 5, fb.add_offset_vector(0));
+            return field;
+        }
+
+        /**
+         * Adds a schema table to a flatbuffer and returns its position.
+         */
+        inline std::size_t add_arrow_schema(xflatbuffer_writer& fb, const std::vector<std::string>& names,
+                                            const std::vector<xarrow_type>& types)
+        {
+            // endianness, fields
+            const std::size_t schema = fb.add_table({2, 4});
+            const std::size_t fields = fb.add_offset_vector(names.size());
+            fb.set_offset(schema, 1, fields);
+            for (std::size_t i = 0; i < names.size(); ++i)
+                fb.set_element(fields, i, add_arrow_field(fb, names[i], types[i]));
+            return schema;
+        }
+
+        /**
+         * Builds a message whose header is set by f, and returns the
+         * encapsulated message: continuation marker, length, flatbuffer.
+         */
+        template <class F>
+        inline std::vector<char> make_arrow_message(uint8_t header_type, int64_t body_length, F&& f)
+        {
+            xflatbuffer_writer fb;
+            // version, header_type, header, bodyLength
+            const std::size_t message = fb.add_table({2, 1, 4, 8});
+            fb.set_root(message);
+            fb.set(message, 0, int16_t(xarrow::metadata_v5));
+            fb.set(message, 1, header_type);
+            fb.set(message, 3, body_length);
+            fb.set_offset(message, 2, f(fb));
+            const std::vector<char>& buffer = fb.buffer();
+            std::vector<char> res(8);
+            const uint32_t continuation = 0xFFFFFFFF;
+            const int32_t length = static_cast<int32_t>(buffer.size());
+            std::memcpy(res.data(), &continuation, 4);
+            std::memcpy(res.data() + 4, &length, 4);
+            res.insert(res.end(), buffer.begin(), buffer.end());
+            return res;
+        }
+
+        template <class LB>
+        inline xarrow_type arrow_label_type(std::true_type)
+        {
+            return arrow_type_of<LB>();
+        }
+
+        template <class LB>
+        inline xarrow_type arrow_label_type(std::false_type)
+        {
+            return xarrow_type{xarrow::type_utf8, 0, false};
+        }
+
+        template <class LB>
+        inline std::string arrow_label_name(const LB& label, std::true_type)
+        {
+            return std::to_string(label);
+        }
+
+        template <class LB>
+        inline std::string arrow_label_name(const LB& label, std::false_type)
+        {
+            return std::string(label.data(), label.size());
+        }
+
+        template <class LB>
+        inline void append_arrow_labels(std::vector<char>& body, const std::vector<LB>& labels, std::vector<xarrow_buffer>& buffers, std::true_type)
+        {
+            buffers.push_back({static_cast<int64_t>(body.size()), 0});
+            buffers.push_back({static_cast<int64_t>(body.size()), static_cast<int64_t>(labels.size() * sizeof(LB))});
+            body.insert(body.end(), reinterpret_cast<const char*>(labels.data()),
+                        reinterpret_cast<const char*>(labels.data() + labels.size()));
+            body.resize(body.size() + arrow_padding(body.size()), '\0');
+        }
+
+        template <class LB>
+        inline void append_arrow_labels(std::vector<char>& body, const std::vector<LB>& labels, std::vector<xarrow_buffer>& buffers, std::false_type)
+        {
+            std::vector<int32_t> offsets(1, 0);
+            offsets.reserve(labels.size() + 1);
+            std::size_t length = 0;
+            for (const auto& label : labels)
+            {
+                length += label.size();
+                if (length > static_cast<std::size_t>(std::numeric_limits<int32_t>::max()))
+                    throw std::runtime_error("arrow index column too large");
+                offsets.push_back(static_cast<int32_t>(length));
+            }
+            buffers.push_back({static_cast<int64_t>(body.size()), 0});
+            buffers.push_back({static_cast<int64_t>(body.size()), static_cast<int64_t>(offsets.size() * sizeof(int32_t))});
+            body.insert(body.end(), reinterpret_cast<const char*>(offsets.data()),
+                        reinterpret_cast<const char*>(offsets.data() + offsets.size()));
+            body.resize(body.size() + arrow_padding(body.size()), '\0');
+            buffers.push_back({static_cast<int64_t>(body.size()), static_cast<int64_t>(length)});
+            for (const auto& label : labels)
+                body.insert(body.end(), label.data(), label.data() + label.size());
+            body.resize(body.size() + arrow_padding(body.size()), '\0');
+        }
+
+        /**
+         * Access to the values of the variables that can be written.
+         */
+        template <class V>
+        struct xarrow_value_type;
+
+        template <class CCT, class ECT>
+        struct xarrow_value_type<xvariable_container<CCT, ECT>>
+        {
+            using type = typename std::decay_t<decltype(std::declval<ECT>().value())>::value_type;
+        };
+
+        template <class C, class DM, class T>
+        struct xarrow_value_type<xdynamic_variable<C, DM, T>>
+        {
+            static_assert(std::is_arithmetic<T>::value, "only dynamic variables of a simple value type can be written");
+            using type = T;
+        };
+
+        template <class CCT, class ECT, class T>
+        inline bool arrow_cell(const xvariable_container<CCT, ECT>& v, std::size_t i, std::size_t j, T& value)
+        {
+            const bool has_value = v.data().has_value()(i, j);
+            value = has_value ? static_cast<T>(v.data().value()(i, j)) : T(0);
+            return has_value;
+        }
+
+        // the const call operator of xdynamic_variable cannot build its index
+        template <class C, class DM, class T, class U>
+        inline bool arrow_cell(const xdynamic_variable<C, DM, T>& v, std::size_t i, std::size_t j, U& value)
+        {
+            using index_type = typename xdynamic_variable<C, DM, T>::template index_type<>;
+            using size_type = typename xdynamic_variable<C, DM, T>::size_type;
+            const auto cell = v.element(index_type({ static_cast<size_type>(i), static_cast<size_type>(j) }));
+            value = cell.has_value() ? static_cast<U>(cell.value()) : U(0);
+            return cell.has_value();
+        }
+
+        /**
+         * Builds an axis of the variant type A from a list of labels.
+         */
+        template <class A, class LB>
+        inline A make_arrow_axis(std::vector<LB>&& labels)
+        {
+            return A(xaxis<LB, typename A::mapped_type, typename A::map_container_tag>(std::move(labels)));
+        }
+    }
+
+    /******************************
+     * write_arrow implementation *
+     ******************************/
+
+    /**
+     * Writes a 2-D variable to an Arrow IPC file, as a single record batch.
+     * The values of each column are stored one after the other, each column
+     * padded to 8 bytes; read_arrow maps them without copying when no
+     * padding is needed.
+     * @param filename the name of the file.
+     * @param v the variable to write, an xvariable or an xdynamic_variable
+     *          of a simple value type.
+     * @param options the dimensions of the variable mapped to Arrow columns
+     *                and rows, and the name of the index column.
+     */
+    template <class V>
+    inline void write_arrow(const std::string& filename, const V& v, const arrow_options& options)
+    {
+        using value_type = typename detail::xarrow_value_type<V>::type;
+        using key_type = typename V::dimension_type::key_type;
+        if (v.dimension() != 2)
+            throw std::runtime_error("only 2-D variables can be written to arrow files");
+        const key_type column_key(options.column_dimension.data(), options.column_dimension.size());
+        const key_type row_key(options.row_dimension.data(), options.row_dimension.size());
+        const auto& dims = v.dimension_mapping();
+        if (!dims.contains(column_key) || !dims.contains(row_key))
+            throw std::runtime_error("unknown arrow column or row dimension");
+        const std::size_t column_position = dims[column_key];
+        const auto& column_axis = v.coordinates()[column_key];
+        const auto& row_axis = v.coordinates()[row_key];
+        const std::size_t column_count = column_axis.size();
+        const std::size_t row_count = row_axis.size();
+        const bool has_index = !options.index_column.empty();
+
+        std::vector<std::string> names;
+        std::vector<detail::xarrow_type> types;
+        std::vector<char> body;
+        std::vector<detail::xarrow_buffer> buffers;
+        std::vector<detail::xarrow_node> nodes;
+
+        if (has_index)
+        {
+            auto labels = row_axis.labels();
+            xtl::visit([&](const auto& arg)
+            {
+                const auto& vec = detail::unwrap(arg);
+                using label_type = typename std::decay_t<decltype(vec)>::value_type;
+                using is_number = std::integral_constant<bool, std::is_arithmetic<label_type>::value>;
+                names.push_back(options.index_column);
+                types.push_back(detail::arrow_label_type<label_type>(is_number()));
+                detail::append_arrow_labels(body, vec, buffers, is_number());
+            }, labels.storage());
+            nodes.push_back({static_cast<int64_t>(row_count), 0});
+        }
+
+        auto column_labels = column_axis.labels();
+        xtl::visit([&names](const auto& arg)
+        {
+            const auto& vec = detail::unwrap(arg);
+            using label_type = typename std::decay_t<decltype(vec)>::value_type;
+            for (const auto& label : vec)
+                names.push_back(detail::arrow_label_name(label, std::is_arithmetic<label_type>()));
+        }, column_labels.storage());
+
+        // values of all the columns, each padded to 8 bytes, then their validity bitmaps
+        const std::size_t bitmap_length = (row_count + 7) / 8;
+        const std::size_t column_length = row_count * sizeof(value_type);
+        const std::size_t column_stride = column_length + detail::arrow_padding(column_length);
+        std::vector<uint8_t> bitmaps(column_count * bitmap_length, 0);
+        std::vector<int64_t> null_counts(column_count, 0);
+        const std::size_t value_offset = body.size();
+        body.resize(body.size() + column_count * column_stride, '\0');
+        for (std::size_t col = 0; col < column_count; ++col)
+        {
+            char* column = body.data() + value_offset + col * column_stride;
+            uint8_t* bitmap = bitmaps.data() + col * bitmap_length;
+            for (std::size_t row = 0; row < row_count; ++row)
+            {
+                value_type value;
+                const bool has_value = column_position == 0 ? detail::arrow_cell(v, col, row, value) : detail::arrow_cell(v, row, col, value);
+                std::memcpy(column + row * sizeof(value_type), &value, sizeof(value_type));
+                if (has_value)
+                    bitmap[row / 8] = static_cast<uint8_t>(bitmap[row / 8] | (1u << (row % 8)));
+                else
+                    ++null_counts[col];
+            }
+        }
+
+        for (std::size_t col = 0; col < column_count; ++col)
+        {
+            types.push_back(detail::arrow_type_of<value_type>());
+            nodes.push_back({static_cast<int64_t>(row_count), null_counts[col]});
+            std::size_t validity_offset = body.size();
+            std::size_t validity_length = 0;
+            if (null_counts[col] != 0)
+            {
+                validity_length = bitmap_length;
+                body.insert(body.end(), bitmaps.data() + col * bitmap_length, bitmaps.data() + (col + 1) * bitmap_length);
+                body.resize(body.size() + detail::arrow_padding(body.size()), '\0');
+            }
+            buffers.push_back({static_cast<int64_t>(validity_offset), static_cast<int64_t>(validity_length)});
+            buffers.push_back({static_cast<int64_t>(value_offset + col * column_stride),
+                               static_cast<int64_t>(column_length)});
+        }
+
+        std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+        if (!out)
+            throw std::runtime_error("cannot open file " + filename);
+        const char header[8] = {'A', 'R', 'R', 'O', 'W', '1', '\0', '\0'};
+        out.write(header, sizeof(header));
+        std::size_t offset = sizeof(header);
+
+        const auto schema_message = detail::make_arrow_message(detail::xarrow::header_schema, 0,
+            [&](detail::xflatbuffer_writer& fb) { return detail::add_arrow_schema(fb, names, types); });
+        out.write(schema_message.data(), static_cast<std::streamsize>(schema_message.size()));
+        offset += schema_message.size();
+
+        const auto batch_message = detail::make_arrow_message(detail::xarrow::header_record_batch, static_cast<int64_t>(body.size()),
+            [&](detail::xflatbuffer_writer& fb)
+            {
+                // length, nodes, buffers
+                const std::size_t batch = fb.add_table({8, 4, 4});
+                fb.set(batch, 0, static_cast<int64_t>(row_count));
+                fb.set_offset(batch, 1, fb.add_struct_vector(nodes));
+                fb.set_offset(batch, 2, fb.add_struct_vector(buffers));
+                return batch;
+            });
+        detail::xarrow_block block = {static_cast<int64_t>(offset), static_cast<int32_t>(batch_message.size()), 0,
+                                      static_cast<int64_t>(body.size())};
+        out.write(batch_message.data(), static_cast<std::streamsize>(batch_message.size()));
+        out.write(body.data(), static_cast<std::streamsize>(body.size()));
+
+        const char end_of_stream[8] = {'\xFF', '\xFF', '\xFF', '\xFF', '\0', '\0', '\0', '\0'};
+        out.write(end_of_stream, sizeof(end_of_stream));
+
+        detail::xflatbuffer_writer fb;
+        // version, schema, dictionaries, recordBatches
+        const std::size_t footer = fb.add_table({2, 4, 0, 4});
+        fb.set_root(footer);
+        fb.set(footer, 0, int16_t(detail::xarrow::metadata_v5));
+        fb.set_offset(footer, 1, detail::add_arrow_schema(fb, names, types));
+        fb.set_offset(footer, 3, fb.add_struct_vector(std::vector<detail::xarrow_block>(1, block)));
+        const std::vector<char>& footer_buffer = fb.buffer();
+        const int32_t footer_length = static_cast<int32_t>(footer_buffer.size());
+        out.write(footer_buffer.data(), static_cast<std::streamsize>(footer_buffer.size()));
+        out.write(reinterpret_cast<const char*>(&footer_length), sizeof(footer_length));
+        out.write(detail::arrow_magic, sizeof(detail::arrow_magic));
+        out.close();
+        if (!out)
+            throw std::runtime_error("cannot write arrow file " + filename);
+    }
+
+    /**
+     * Reads a 2-D variable from an Arrow IPC file. All the columns but the
+     * index column must be numeric; their values are converted to T if
+     * they have another type.
+     * @param filename the name of the file.
+     * @param options the name of the index column and of the dimensions.
+     * @tparam T the value type of the variable.
+     */
+    template <class T, class K, class L, class S, class MT>
+    inline arrow_variable<T, K, L, S, MT> read_arrow(const std::string& filename, const arrow_options& options)
+    {
+        return arrow_variable<T, K, L, S, MT>(filename, options);
+    }
+
+    /*********************************
+     * arrow_variable implementation *
+     *********************************/
+
+    template <class T, class K, class L, class S, class MT>
+    inline arrow_variable<T, K, L, S, MT>::arrow_variable(const std::string& filename, const arrow_options& options)
+        : m_file(filename, false, true), m_buffer(), m_values(), m_mask(), m_mapped(false), m_variable(load(filename, options))
+    {
+    }
+
+    template <class T, class K, class L, class S, class MT>
+    inline auto arrow_variable<T, K, L, S, MT>::variable() noexcept -> variable_type&
+    {
+        return m_variable;
+    }
+
+    template <class T, class K, class L, class S, class MT>
+    inline auto arrow_variable<T, K, L, S, MT>::variable() const noexcept -> const variable_type&
+    {
+        return m_variable;
+    }
+
+    /**
+     * Returns true if the values of the variable are read from the mapping
+     * of the file, without having been copied.
+     */
+    template <class T, class K, class L, class S, class MT>
+    inline bool arrow_variable<T, K, L, S, MT>::is_mapped() const noexcept
+    {
+        return m_mapped;
+    }
+
+    template <class T, class K, class L, class S, class MT>
+    inline auto arrow_variable<T, K, L, S, MT>::load(const std::string& filename, const arrow_options& options) -> variable_type
+    {
+        using detail::xarrow;
+        char* data = const_cast<char*>(m_file.data());
+        std::size_t size = m_file.size();
+        if (!m_file.is_open())
+        {
+            std::ifstream in(filename, std::ios::binary);
+            if (!in)
+                throw std::runtime_error("cannot open file " + filename);
+            m_buffer.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+            data = m_buffer.data();
+            size = m_buffer.size();
+        }
+        if (size < 16 || std::memcmp(data, detail::arrow_magic, 6) != 0
+            || std::memcmp(data + size - 6, detail::arrow_magic, 6) != 0)
+        {
+            throw std::runtime_error("not an arrow file");
+        }
+
+        int32_t footer_length;
+        std::memcpy(&footer_length, data + size - 10, sizeof(footer_length));
+        if (footer_length <= 0 || static_cast<std::size_t>(footer_length) > size - 18)
+            throw std::runtime_error("invalid arrow footer");
+        detail::xflatbuffer_reader footer(data + size - 10 - footer_length, static_cast<std::size_t>(footer_length));
+        const std::size_t footer_table = footer.root();
+
+        // schema
+        const std::size_t schema = footer.table(footer_table, 1);
+        if (schema == 0 || footer.get<int16_t>(schema, 0, 0) != 0)
+            throw std::runtime_error("unsupported arrow schema");
+        std::size_t field_count = 0;
+        const std::size_t fields = footer.vector(schema, 1, field_count, 4);
+        std::vector<std::string> names;
+        std::vector<detail::xarrow_type> types;
+        std::size_t index_field = field_count;
+        for (std::size_t i = 0; i < field_count; ++i)
+        {
+            const std::size_t field = footer.element(fields, i);
+            names.push_back(footer.string(field, 0));
+            detail::xarrow_type type = {footer.get<uint8_t>(field, 2, 0), 0, false};
+            const std::size_t type_table = footer.table(field, 3);
+            if (type.id == xarrow::type_int && type_table != 0)
+            {
+                type.bit_width = footer.get<int32_t>(type_table, 0, 0);
+                type.is_signed = footer.get<uint8_t>(type_table, 1, 0) != 0;
+            }
+            else if (type.id == xarrow::type_floating_point && type_table != 0)
+            {
+                const int16_t precision = footer.get<int16_t>(type_table, 0, 0);
+                type.bit_width = precision == xarrow::precision_single ? 32 : precision == xarrow::precision_double ? 64 : 16;
+            }
+            if (footer.table(field, 4) != 0)
+                throw std::runtime_error("dictionary-encoded arrow columns are not supported");
+            if (!options.index_column.empty() && names.back() == options.index_column)
+                index_field = i;
+            types.push_back(type);
+        }
+        if (!options.index_column.empty() && index_field == field_count)
+            throw std::runtime_error("unknown arrow index column " + options.index_column);
+
+        // the record batches
+        std::size_t block_count = 0;
+        const std::size_t blocks = footer.vector(footer_table, 3, block_count, sizeof(detail::xarrow_block));
+        const std::size_t column_count = field_count - (index_field < field_count ? 1 : 0);
+        struct batch_info
+        {
+            const char* body;
+            std::size_t body_length;
+            std::size_t row_count;
+            std::vector<detail::xarrow_buffer> buffers;
+        };
+        std::vector<batch_info> batches;
+        std::size_t row_count = 0;
+        for (std::size_t b = 0; b < block_count; ++b)
+        {
+            const int64_t offset = footer.read<int64_t>(blocks + b * sizeof(detail::xarrow_block));
+            const int32_t metadata_length = footer.read<int32_t>(blocks + b * sizeof(detail::xarrow_block) + 8);
+            const int64_t body_length = footer.read<int64_t>(blocks + b * sizeof(detail::xarrow_block) + 16);
+            if (offset < 8 || metadata_length < 8 || body_length < 0
+                || static_cast<uint64_t>(offset) + static_cast<uint64_t>(metadata_length) + static_cast<uint64_t>(body_length) > size)
+            {
+                throw std::runtime_error("invalid arrow record batch block");
+            }
+            const char* message_data = data + offset;
+            uint32_t prefix;
+            std::memcpy(&prefix, message_data, 4);
+            // messages written before the continuation marker only have a length
+            const std::size_t prefix_length = prefix == 0xFFFFFFFF ? 8 : 4;
+            detail::xflatbuffer_reader message(message_data + prefix_length, static_cast<std::size_t>(metadata_length) - prefix_length);
+            const std::size_t message_table = message.root();
+            if (message.get<uint8_t>(message_table, 1, 0) != xarrow::header_record_batch)
+                throw std::runtime_error("arrow record batch expected");
+            const std::size_t batch = message.table(message_table, 2);
+            if (batch == 0)
+                throw std::runtime_error("invalid arrow record batch");
+            if (message.table(batch, 3) != 0)
+                throw std::runtime_error("compressed arrow record batches are not supported");
+            batch_info info;
+            info.body = message_data + metadata_length;
+            info.body_length = static_cast<std::size_t>(body_length);
+            info.row_count = static_cast<std::size_t>(message.get<int64_t>(batch, 0, 0));
+            std::size_t buffer_count = 0;
+            const std::size_t buffer_vector = message.vector(batch, 2, buffer_count, sizeof(detail::xarrow_buffer));
+            for (std::size_t i = 0; i < buffer_count; ++i)
+            {
+                detail::xarrow_buffer buffer = {message.read<int64_t>(buffer_vector + 16 * i), message.read<int64_t>(buffer_vector + 16 * i + 8)};
+                if (buffer.offset < 0 || buffer.length < 0
+                    || static_cast<uint64_t>(buffer.offset) + static_cast<uint64_t>(buffer.length) > info.body_length)
+                {
+                    throw std::runtime_error("invalid arrow buffer");
+                }
+                info.buffers.push_back(buffer);
+            }
+            row_count += info.row_count;
+            batches.push_back(std::move(info));
+        }
+
+        // buffers of each field: validity and values, plus offsets for strings
+        std::vector<std::size_t> first_buffer(field_count + 1, 0);
+        for (std::size_t i = 0; i < field_count; ++i)
+        {
+            if (i != index_field && types[i].id != xarrow::type_int && types[i].id != xarrow::type_floating_point)
+                throw std::runtime_error("arrow column " + names[i] + " is not numeric");
+            if (types[i].id == xarrow::type_floating_point && types[i].bit_width == 16)
+                throw std::runtime_error("half precision arrow columns are not supported");
+            first_buffer[i + 1] = first_buffer[i] + (types[i].id == xarrow::type_utf8 ? 3 : 2);
+        }
+        for (const auto& batch : batches)
+        {
+            if (batch.buffers.size() != first_buffer[field_count])
+                throw std::runtime_error("unexpected number of arrow buffers");
+            for (std::size_t i = 0; i < field_count; ++i)
+            {
+                const auto& values = batch.buffers[first_buffer[i] + 1];
+                const std::size_t width = types[i].id == xarrow::type_utf8 ? 4 : static_cast<std::size_t>(types[i].bit_width / 8);
+                const std::size_t expected = types[i].id == xarrow::type_utf8 ? batch.row_count + 1 : batch.row_count;
+                if (width == 0 || static_cast<std::size_t>(values.length) < expected * width)
+                    throw std::runtime_error("arrow buffer too short");
+                const auto& validity = batch.buffers[first_buffer[i]];
+                if (validity.length != 0 && static_cast<std::size_t>(validity.length) < (batch.row_count + 7) / 8)
+                    throw std::runtime_error("arrow buffer too short");
+            }
+        }
+
+        // values: mapped when a single batch stores them with type T and no
+        // padding between the columns, copied otherwise
+        const std::size_t count = column_count * row_count;
+        T* values = nullptr;
+        const detail::xarrow_type value_type = detail::arrow_type_of<T>();
+        if (batches.size() == 1 && column_count != 0)
+        {
+            const auto& batch = batches.front();
+            bool contiguous = true;
+            int64_t expected_offset = -1;
+            for (std::size_t i = 0; i < field_count && contiguous; ++i)
+            {
+                if (i == index_field)
+                    continue;
+                const int64_t offset = batch.buffers[first_buffer[i] + 1].offset;
+                contiguous = types[i] == value_type && (expected_offset < 0 || offset == expected_offset);
+                expected_offset = offset + static_cast<int64_t>(row_count * sizeof(T));
+            }
+            if (contiguous)
+            {
+                std::size_t first = 0;
+                while (first == index_field)
+                    ++first;
+                char* address = const_cast<char*>(batch.body) + batch.buffers[first_buffer[first] + 1].offset;
+                if (reinterpret_cast<std::uintptr_t>(address) % alignof(T) == 0)
+                {
+                    values = reinterpret_cast<T*>(address);
+                    m_mapped = true;
+                }
+            }
+        }
+        if (values == nullptr)
+        {
+            m_values.resize(count);
+            values = m_values.data();
+            std::size_t row_offset = 0;
+            for (const auto& batch : batches)
+            {
+                std::size_t col = 0;
+                for (std::size_t i = 0; i < field_count; ++i)
+                {
+                    if (i == index_field)
+                        continue;
+                    const char* src = batch.body + batch.buffers[first_buffer[i] + 1].offset;
+                    T* dst = values + col * row_count + row_offset;
+                    const auto& type = types[i];
+                    auto convert = [&](auto tag)
+                    {
+                        using source_type = decltype(tag);
+                        for (std::size_t row = 0; row < batch.row_count; ++row)
+                        {
+                            source_type value;
+                            std::memcpy(&value, src + row * sizeof(source_type), sizeof(source_type));
+                            dst[row] = static_cast<T>(value);
+                        }
+                    };
+                    if (type.id == xarrow::type_floating_point)
+                        type.bit_width == 32 ? convert(float()) : convert(double());
+                    else if (type.bit_width == 8)
+                        type.is_signed ? convert(int8_t()) : convert(uint8_t());
+                    else if (type.bit_width == 16)
+                        type.is_signed ? convert(int16_t()) : convert(uint16_t());
+                    else if (type.bit_width == 32)
+                        type.is_signed ? convert(int32_t()) : convert(uint32_t());
+                    else if (type.bit_width == 64)
+                        type.is_signed ? convert(int64_t()) : convert(uint64_t());
+                    else
+                        throw std::runtime_error("unsupported arrow integer width");
+                    ++col;
+                }
+                row_offset += batch.row_count;
+            }
+        }
+
+        // missing mask, expanded from the validity bitmaps
+        m_mask.reset(new bool[count > 0 ? count : 1]);
+        {
+            std::size_t row_offset = 0;
+            for (const auto& batch : batches)
+            {
+                std::size_t col = 0;
+                for (std::size_t i = 0; i < field_count; ++i)
+                {
+                    if (i == index_field)
+                        continue;
+                    const auto& validity = batch.buffers[first_buffer[i]];
+                    bool* dst = m_mask.get() + col * row_count + row_offset;
+                    if (validity.length == 0)
+                    {
+                        std::fill(dst, dst + batch.row_count, true);
+                    }
+                    else
+                    {
+                        const uint8_t* bitmap = reinterpret_cast<const uint8_t*>(batch.body + validity.offset);
+                        for (std::size_t row = 0; row < batch.row_count; ++row)
+                            dst[row] = ((bitmap[row / 8] >> (row % 8)) & 1) != 0;
+                    }
+                    ++col;
+                }
+                row_offset += batch.row_count;
+            }
+        }
+
+        // axes
+        using axis_type = typename coordinate_type::axis_type;
+        std::vector<fstring> column_labels;
+        for (std::size_t i = 0; i < field_count; ++i)
+        {
+            if (i != index_field)
+                column_labels.push_back(fstring(names[i].data(), names[i].size()));
+        }
+        axis_type row_axis = axis_type(xaxis_default<std::size_t, typename axis_type::mapped_type>(row_count));
+        if (index_field < field_count)
+        {
+            const auto& type = types[index_field];
+            if (type.id == xarrow::type_utf8)
+            {
+                std::vector<fstring> labels;
+                labels.reserve(row_count);
+                for (const auto& batch : batches)
+                {
+                    const char* offsets = batch.body + batch.buffers[first_buffer[index_field] + 1].offset;
+                    const auto& chars = batch.buffers[first_buffer[index_field] + 2];
+                    for (std::size_t row = 0; row < batch.row_count; ++row)
+                    {
+                        int32_t begin, end;
+                        std::memcpy(&begin, offsets + 4 * row, 4);
+                        std::memcpy(&end, offsets + 4 * row + 4, 4);
+                        if (begin < 0 || end < begin || end > chars.length)
+                            throw std::runtime_error("invalid arrow string offsets");
+                        labels.push_back(fstring(batch.body + chars.offset + begin, static_cast<std::size_t>(end - begin)));
+                    }
+                }
+                row_axis = detail::make_arrow_axis<axis_type>(std::move(labels));
+            }
+            else if (type.id == xarrow::type_int && !type.is_signed && type.bit_width == 64)
+            {
+                std::vector<std::size_t> labels(row_count);
+                std::size_t row_offset = 0;
+                for (const auto& batch : batches)
+                {
+                    std::memcpy(labels.data() + row_offset, batch.body + batch.buffers[first_buffer[index_field] + 1].offset,
+                                batch.row_count * sizeof(uint64_t));
+                    row_offset += batch.row_count;
+                }
+                row_axis = detail::make_arrow_axis<axis_type>(std::move(labels));
+            }
+            else if (type.id == xarrow::type_int && (type.bit_width <= 32 || (type.is_signed && type.bit_width == 64)))
+            {
+                // signed 64-bit labels, the default of pandas, must fit in an int
+                std::vector<int> labels;
+                labels.reserve(row_count);
+                for (const auto& batch : batches)
+                {
+                    const char* src = batch.body + batch.buffers[first_buffer[index_field] + 1].offset;
+                    const std::size_t width = static_cast<std::size_t>(type.bit_width / 8);
+                    for (std::size_t row = 0; row < batch.row_count; ++row)
+                    {
+                        int64_t label = 0;
+                        if (type.is_signed)
+                        {
+                            int8_t v8; int16_t v16; int32_t v32;
+                            if (width == 1) { std::memcpy(&v8, src + row, 1); label = v8; }
+                            else if (width == 2) { std::memcpy(&v16, src + 2 * row, 2); label = v16; }
+                            else if (width == 4) { std::memcpy(&v32, src + 4 * row, 4); label = v32; }
+                            else { std::memcpy(&label, src + 8 * row, 8); }
+                        }
+                        else
+                        {
+                            uint8_t v8; uint16_t v16; uint32_t v32;
+                            if (width == 1) { std::memcpy(&v8, src + row, 1); label = v8; }
+                            else if (width == 2) { std::memcpy(&v16, src + 2 * row, 2); label = v16; }
+                            else { std::memcpy(&v32, src + 4 * row, 4); label = v32; }
+                        }
+                        if (label < std::numeric_limits<int>::min() || label > std::numeric_limits<int>::max())
+                            throw std::runtime_error("arrow index label out of range");
+                        labels.push_back(static_cast<int>(label));
+                    }
+                }
+                row_axis = detail::make_arrow_axis<axis_type>(std::move(labels));
+            }
+            else
+            {
+                throw std::runtime_error("unsupported type of arrow index column");
+            }
+        }
+
+        typename coordinate_type::map_type axes;
+        const K column_key(options.column_dimension.data(), options.column_dimension.size());
+        const K row_key(options.row_dimension.data(), options.row_dimension.size());
+        axes.emplace(column_key, detail::make_arrow_axis<axis_type>(std::move(column_labels)));
+        axes.emplace(row_key, std::move(row_axis));
+        const std::vector<std::size_t> shape = {column_count, row_count};
+        data_type var_data(xt::adapt(values, count, xt::no_ownership(), shape),
+                           xt::adapt(m_mask.get(), count, xt::no_ownership(), shape));
+        return variable_type(std::move(var_data), coordinate_type(std::move(axes)), dimension_type({column_key, row_key}));
+    }
+}
+
+#endif
@@ -0,0 +1,557 @@
+/***************************************************************************
+* Copyright (c) Johan Mabille, Sylvain Corlay, Wolf Vollprecht and         *
+* Martin Renou                                                             *
+* Copyright (c) QuantStack                                                 *
+*                                                                          *
+* Distributed under the terms of the BSD 3-Clause License.                 *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#ifndef XFRAME_IO_BINARY_HPP
+#define XFRAME_IO_BINARY_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "xtensor/xadapt.hpp"
+
+#include "xio_mmap.hpp"
+#include "xvariable.hpp"
+
+namespace xf
+{
+    /**
+     * Layout of the files written by save and read by load_mmap. All the
+     * integers are in the byte order of the writer, which is checked when
+     * the file is loaded.
+     *
+     * - header: magic "XFRAMEVC", version (uint32), byte order mark (uint32),
+     *   value type code (uint32), dimension count (uint32), value count (uint64)
+     * - dimension list: for each dimension, the length of its name (uint64)
+     *   and its characters
+     * - axes, in the order of the dimensions: label type index in the label
+     *   list (uint32), label type code (uint32), default axis flag (uint32),
+     *   padding (uint32), size (uint64), then the labels; arithmetic labels
+     *   are stored as a raw array, string labels as a length (uint64) followed
+     *   by the characters
+     * - value buffer, in row-major order, aligned on xbinary_alignment bytes
+     * - missing mask, one byte per value, aligned on xbinary_alignment bytes
+     */
+    constexpr uint32_t xbinary_version = 1;
+    constexpr std::size_t xbinary_alignment = 64;
+
+    /********************
+     * xmapped_variable *
+     ********************/
+
+    /**
+     * @class xmapped_variable
+     * @brief Variable loaded from a file written by save.
+     *
+     * The value buffer and the missing mask of the variable are adaptors on
+     * a copy-on-write mapping of the file: nothing is copied when loading,
+     * pages are read when they are first accessed. Modifying the variable
+     * never changes the file. Only the axes are rebuilt in memory. When the
+     * file cannot be mapped, it is read into a buffer owned by this object.
+     *
+     * @tparam T the value type of the variable.
+     * @tparam K the type of dimension names.
+     * @tparam L the type list of axes labels.
+     * @tparam S the integer type used to represent positions in axes.
+     * @tparam MT the tag used for choosing the map type of the axes.
+     */
+    template <class T, class K = fstring, class L = XFRAME_DEFAULT_LABEL_LIST, class S = std::size_t, class MT = hash_map_tag>
+    class xmapped_variable
+    {
+    public:
+
+        using value_type = T;
+        using coordinate_type = xcoordinate<K, L, S, MT>;
+        using dimension_type = xdimension<K, S>;
+        using shape_type = std::vector<std::size_t>;
+        using value_container = decltype(xt::adapt(std::declval<T*>(), std::size_t(0), xt::no_ownership(), std::declval<shape_type>()));
+        using mask_container = decltype(xt::adapt(std::declval<bool*>(), std::size_t(0), xt::no_ownership(), std::declval<shape_type>()));
+        using data_type = xt::xoptional_assembly<value_container, mask_container>;
+        using variable_type = xvariable_container<coordinate_type, data_type>;
+
+        explicit xmapped_variable(const std::string& filename);
+
+        xmapped_variable(const xmapped_variable&) = delete;
+        xmapped_variable& operator=(const xmapped_variable&) = delete;
+
+        // assigning adaptors would copy the values instead of rebinding them
+        xmapped_variable(xmapped_variable&&) = default;
+        xmapped_variable& operator=(xmapped_variable&&) = delete;
+
+        variable_type& variable() noexcept;
+        const variable_type& variable() const noexcept;
+
+    private:
+
+        variable_type load(const std::string& filename);
+
+        detail::xmapped_file m_file;
+        std::vector<char> m_buffer;
+        variable_type m_variable;
+    };
+
+    template <class CCT, class ECT>
+    void save(const std::string& filename, const xvariable_container<CCT, ECT>& v);
+
+    template <class T, class K = fstring, class L = XFRAME_DEFAULT_LABEL_LIST, class S = std::size_t, class MT = hash_map_tag>
+    xmapped_variable<T, K, L, S, MT> load_mmap(const std::string& filename);
+
+    namespace detail
+    {
+        constexpr char xbinary_magic[8] = {'X', 'F', 'R', 'A', 'M', 'E', 'V', 'C'};
+        constexpr uint32_t xbinary_byte_order = 0x01020304;
+
+        // kind of the type in the second byte, size in the first one
+        template <class T>
+        constexpr uint32_t xbinary_type_code()
+        {
+            return std::is_same<T, bool>::value ? 0x0400u + 1u
+                : std::is_floating_point<T>::value ? 0x0300u + static_cast<uint32_t>(sizeof(T))
+                : std::is_signed<T>::value ? 0x0100u + static_cast<uint32_t>(sizeof(T))
+                : std::is_arithmetic<T>::value ? 0x0200u + static_cast<uint32_t>(sizeof(T))
+                : 0x0500u;
+        }
+
+        inline std::size_t xbinary_padding(std::size_t offset)
+        {
+            return (xbinary_alignment - offset % xbinary_alignment) % xbinary_alignment;
+        }
+
+        /**
+         * Sequential writer keeping track of the offset, so that buffers
+         * can be aligned.
+         */
+        class xbinary_writer
+        {
+        public:
+
+            explicit xbinary_writer(const std::string& filename);
+
+            template <class T>
+            void write(const T& value);
+            void write(const char* data, std::size_t length);
+            void write_string(const char* data, std::size_t length);
+            void align();
+            void close();
+
+        private:
+
+            std::ofstream m_stream;
+            std::size_t m_offset;
+        };
+
+        /**
+         * Sequential reader of a file loaded in memory, checking that it
+         * never reads past the end.
+         */
+        class xbinary_reader
+        {
+        public:
+
+            xbinary_reader(const char* data, std::size_t size);
+
+            template <class T>
+            T read();
+            const char* read(std::size_t length);
+            std::string read_string();
+            void align();
+
+        private:
+
+            const char* p_data;
+            std::size_t m_size;
+            std::size_t m_offset;
+        };
+
+        /*********************************
+         * xbinary_writer implementation *
+         *********************************/
+
+        inline xbinary_writer::xbinary_writer(const std::string& filename)
+            : m_stream(filename, std::ios::binary | std::ios::trunc), m_offset(0)
+        {
+            if (!m_stream)
+                throw std::runtime_error("cannot open file " + filename);
+        }
+
+        template <class T>
+        inline void xbinary_writer::write(const T& value)
+        {
+            write(reinterpret_cast<const char*>(&value), sizeof(T));
+        }
+
+        inline void xbinary_writer::write(const char* data, std::size_t length)
+        {
+            m_stream.write(data, static_cast<std::streamsize>(length));
+            m_offset += length;
+        }
+
+        inline void xbinary_writer::write_string(const char* data, std::size_t length)
+        {
+            write(static_cast<uint64_t>(length));
+            write(data, length);
+        }
+
+        inline void xbinary_writer::align()
+        {
+            const char zeros[xbinary_alignment] = {};
+            write(zeros, xbinary_padding(m_offset));
+        }
+
+        inline void xbinary_writer::close()
+        {
+            m_stream.close();
+            if (!m_stream)
+                throw std::runtime_error("cannot write variable file");
+        }
+
+        /*********************************
+         * xbinary_reader implementation *
+         *********************************/
+
+        inline xbinary_reader::xbinary_reader(const char* data, std::size_t size)
+            : p_data(data), m_size(size), m_offset(0)
+        {
+        }
+
+        template <class T>
+        inline T xbinary_reader::read()
+        {
+            T res;
+            std::memcpy(&res, read(sizeof(T)), sizeof(T));
+            return res;
+        }
+
+        inline const char* xbinary_reader::read(std::size_t length)
+        {
+            if (length > m_size - m_offset)
+                throw std::runtime_error("truncated variable file");
+            const char* res = p_data + m_offset;
+            m_offset += length;
+            return res;
+        }
+
+        inline std::string xbinary_reader::read_string()
+        {
+            const uint64_t length = read<uint64_t>();
+            if (length > m_size - m_offset)
+                throw std::runtime_error("truncated variable file");
+            const char* data = read(static_cast<std::size_t>(length));
+            return std::string(data, static_cast<std::size_t>(length));
+        }
+
+        inline void xbinary_reader::align()
+        {
+            read(std::min(xbinary_padding(m_offset), m_size - m_offset));
+        }
+
+        /****************
+         * label coding *
+         ****************/
+
+        template <class LB>
+        inline void write_binary_labels(xbinary_writer& writer, const std::vector<LB>& labels, std::true_type)
+        {
+            writer.write(reinterpret_cast<const char*>(labels.data()), labels.size() * sizeof(LB));
+        }
+
+        template <class LB>
+        inline void write_binary_labels(xbinary_writer& writer, const std::vector<LB>& labels, std::false_type)
+        {
+            for (const auto& label : labels)
+                writer.write_string(label.data(), label.size());
+        }
+
+        template <class LB>
+        inline std::vector<LB> read_binary_labels(xbinary_reader& reader, std::size_t size, std::true_type)
+        {
+            if (size > std::numeric_limits<std::size_t>::max() / sizeof(LB))
+                throw std::runtime_error("truncated variable file");
+            std::vector<LB> res(size);
+            std::memcpy(res.data(), reader.read(size * sizeof(LB)), size * sizeof(LB));
+            return res;
+        }
+
+        template <class LB>
+        inline std::vector<LB> read_binary_labels(xbinary_reader& reader, std::size_t size, std::false_type)
+        {
+            std::vector<LB> res;
+            for (std::size_t i = 0; i < size; ++i)
+            {
+                const std::string label = reader.read_string();
+                res.push_back(LB(label.data(), label.size()));
+            }
+            return res;
+        }
+
+        // Only an xaxis_default is stored as a default axis, an explicit
+        // axis keeps its labels even when they are 0 to n - 1
+        template <class A>
+        inline bool is_default_binary_axis(const A& axis)
+        {
+            return xtl::visit([](const auto& arg)
+            {
+                using axis_type = std::decay_t<decltype(arg)>;
+                return std::is_same<axis_type, xaxis_default<typename axis_type::key_type, typename axis_type::mapped_type>>::value;
+            }, axis.storage());
+        }
+
+        template <class A, class LB>
+        inline A make_default_binary_axis(std::size_t size, std::true_type)
+        {
+            return A(xaxis_default<LB, typename A::mapped_type>(size));
+        }
+
+        template <class A, class LB>
+        inline A make_default_binary_axis(std::size_t, std::false_type)
+        {
+            throw std::runtime_error("invalid default axis in variable file");
+        }
+
+        /**
+         * Reads an axis whose label type is the type at position index in
+         * the label list.
+         */
+        template <class A, class... LB>
+        struct xbinary_axis_reader;
+
+        template <class A>
+        struct xbinary_axis_reader<A>
+        {
+            static A read(xbinary_reader&, uint32_t, uint32_t, bool, std::size_t)
+            {
+                throw std::runtime_error("unknown label type in variable file");
+            }
+        };
+
+        template <class A, class LB1, class... LB>
+        struct xbinary_axis_reader<A, LB1, LB...>
+        {
+            static A read(xbinary_reader& reader, uint32_t index, uint32_t code, bool is_default, std::size_t size)
+            {
+                if (index != 0)
+                    return xbinary_axis_reader<A, LB...>::read(reader, index - 1, code, is_default, size);
+                if (code != xbinary_type_code<LB1>())
+                    throw std::runtime_error("label type mismatch in variable file");
+                if (is_default)
+                    return make_default_binary_axis<A, LB1>(size, std::is_integral<LB1>());
+                using axis_type = xaxis<LB1, typename A::mapped_type, typename A::map_container_tag>;
+                return A(axis_type(read_binary_labels<LB1>(reader, size, std::is_arithmetic<LB1>())));
+            }
+        };
+
+        template <class A, class TL>
+        struct xbinary_axis_reader_list;
+
+        template <class A, template <class...> class TL, class... LB>
+        struct xbinary_axis_reader_list<A, TL<LB...>>
+        {
+            using type = xbinary_axis_reader<A, LB...>;
+        };
+
+        template <class A>
+        inline void write_binary_axis(xbinary_writer& writer, const A& axis)
+        {
+            auto labels = axis.labels();
+            const uint32_t index = static_cast<uint32_t>(labels.storage().index());
+            const bool is_default = is_default_binary_axis(axis);
+            xtl::visit([&writer, index, is_default](const auto& arg)
+            {
+                const auto& vec = unwrap(arg);
+                using label_type = typename std::decay_t<decltype(vec)>::value_type;
+                writer.write(index);
+                writer.write(xbinary_type_code<label_type>());
+                writer.write(static_cast<uint32_t>(is_default));
+                writer.write(uint32_t(0));
+                writer.write(static_cast<uint64_t>(vec.size()));
+                if (!is_default)
+                    write_binary_labels(writer, vec, std::is_arithmetic<label_type>());
+            }, labels.storage());
+        }
+    }
+
+    /*************************************
+     * save and load_mmap implementation *
+     *************************************/
+
+    /**
+     * Writes a variable to a file that can be loaded with load_mmap. The
+     * values must be of an arithmetic type.
+     * @param filename the name of the file.
+     * @param v the variable to save.
+     */
+    template <class CCT, class ECT>
+    inline void save(const std::string& filename, const xvariable_container<CCT, ECT>& v)
+    {
+        const auto& values = v.data().value();
+        const auto& mask = v.data().has_value();
+        using value_type = typename std::decay_t<decltype(values)>::value_type;
+        static_assert(std::is_arithmetic<value_type>::value, "only variables of arithmetic values can be saved");
+
+        detail::xbinary_writer writer(filename);
+        const auto& dims = v.dimension_mapping().labels();
+        writer.write(detail::xbinary_magic, sizeof(detail::xbinary_magic));
+        writer.write(xbinary_version);
+        writer.write(detail::xbinary_byte_order);
+        writer.write(detail::xbinary_type_code<value_type>());
+        writer.write(static_cast<uint32_t>(dims.size()));
+        writer.write(static_cast<uint64_t>(values.size()));
+        for (const auto& dim : dims)
+            writer.write_string(dim.data(), dim.size());
+        for (const auto& dim : dims)
+            detail::write_binary_axis(writer, v.coordinates()[dim]);
+
+        // values and mask are written by chunks, in row-major order
+        constexpr std::size_t chunk_size = 1 << 16;
+        std::vector<value_type> value_chunk;
+        value_chunk.reserve(chunk_size);
+        writer.align();
+        for (auto it = values.cbegin(); it != values.cend(); ++it)
+        {
+            value_chunk.push_back(*it);
+            if (value_chunk.size() == chunk_size)
+            {
+                writer.write(reinterpret_cast<const char*>(value_chunk.data()), value_chunk.size() * sizeof(value_type));
+                value_chunk.clear();
+            }
+        }
+        writer.write(reinterpret_cast<const char*>(value_chunk.data()), value_chunk.size() * sizeof(value_type));
+
+        std::vector<char> mask_chunk;
+        mask_chunk.reserve(chunk_size);
+        writer.align();
+        for (auto it = mask.cbegin(); it != mask.cend(); ++it)
+        {
+            mask_chunk.push_back(*it ? char(1) : char(0));
+            if (mask_chunk.size() == chunk_size)
+            {
+                writer.write(mask_chunk.data(), mask_chunk.size());
+                mask_chunk.clear();
+            }
+        }
+        writer.write(mask_chunk.data(), mask_chunk.size());
+        writer.close();
+    }
+
+    /**
+     * Loads a variable written by save, wrapping the values and the mask of
+     * the file without copying them.
+     * @param filename the name of the file.
+     * @tparam T the value type of the variable, must be the saved one.
+     */
+    template <class T, class K, class L, class S, class MT>
+    inline xmapped_variable<T, K, L, S, MT> load_mmap(const std::string& filename)
+    {
+        return xmapped_variable<T, K, L, S, MT>(filename);
+    }
+
+    /***********************************
+     * xmapped_variable implementation *
+     ***********************************/
+
+    template <class T, class K, class L, class S, class MT>
+    inline xmapped_variable<T, K, L, S, MT>::xmapped_variable(const std::string& filename)
+        : m_file(filename, false, true), m_buffer(), m_variable(load(filename))
+    {
+    }
+
+    template <class T, class K, class L, class S, class MT>
+    inline auto xmapped_variable<T, K, L, S, MT>::variable() noexcept -> variable_type&
+    {
+        return m_variable;
+    }
+
+    template <class T, class K, class L, class S, class MT>
+    inline auto xmapped_variable<T, K, L, S, MT>::variable() const noexcept -> const variable_type&
+    {
+        return m_variable;
+    }
+
+    template <class T, class K, class L, class S, class MT>
+    inline auto xmapped_variable<T, K, L, S, MT>::load(const std::string& filename) -> variable_type
+    {
+        static_assert(std::is_arithmetic<T>::value, "only variables of arithmetic values can be loaded");
+        // the mapping is private and writable, see xmapped_file
+        char* data = const_cast<char*>(m_file.data());
+        std::size_t size = m_file.size();
+        if (!m_file.is_open())
+        {
+            std::ifstream in(filename, std::ios::binary);
+            if (!in)
+                throw std::runtime_error("cannot open file " + filename);
+            m_buffer.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+            data = m_buffer.data();
+            size = m_buffer.size();
+        }
+
+        detail::xbinary_reader reader(data, size);
+        if (std::memcmp(reader.read(sizeof(detail::xbinary_magic)), detail::xbinary_magic, sizeof(detail::xbinary_magic)) != 0)
+            throw std::runtime_error("not a variable file");
+        if (reader.read<uint32_t>() != xbinary_version)
+            throw std::runtime_error("unsupported variable file version");
+        if (reader.read<uint32_t>() != detail::xbinary_byte_order)
+            throw std::runtime_error("variable file written with another byte order");
+        if (reader.read<uint32_t>() != detail::xbinary_type_code<T>())
+            throw std::runtime_error("value type mismatch in variable file");
+        const std::size_t dimension_count = reader.read<uint32_t>();
+        const uint64_t value_count = reader.read<uint64_t>();
+
+        std::vector<K> dims;
+        dims.reserve(dimension_count);
+        for (std::size_t i = 0; i < dimension_count; ++i)
+        {
+            const std::string dim = reader.read_string();
+            dims.push_back(K(dim.data(), dim.size()));
+        }
+
+        using axis_type = typename coordinate_type::axis_type;
+        using axis_reader = typename detail::xbinary_axis_reader_list<axis_type, L>::type;
+        typename coordinate_type::map_type axes;
+        shape_type shape;
+        shape.reserve(dimension_count);
+        uint64_t expected_count = 1;
+        for (const auto& dim : dims)
+        {
+            const uint32_t index = reader.read<uint32_t>();
+            const uint32_t code = reader.read<uint32_t>();
+            const bool is_default = reader.read<uint32_t>() != 0;
+            reader.read<uint32_t>();
+            const std::size_t axis_size = static_cast<std::size_t>(reader.read<uint64_t>());
+            axis_type axis = axis_reader::read(reader, index, code, is_default, axis_size);
+            shape.push_back(axis_size);
+            expected_count *= axis_size;
+            axes.emplace(dim, std::move(axis));
+        }
+        if (expected_count != value_count)
+            throw std::runtime_error("value count does not match the axes in variable file");
+
+        if (value_count > std::numeric_limits<std::size_t>::max() / sizeof(T))
+            throw std::runtime_error("truncated variable file");
+        const std::size_t count = static_cast<std::size_t>(value_count);
+        reader.align();
+        T* values = reinterpret_cast<T*>(const_cast<char*>(reader.read(count * sizeof(T))));
+        reader.align();
+        bool* mask = reinterpret_cast<bool*>(const_cast<char*>(reader.read(count)));
+
+        data_type var_data(xt::adapt(values, count, xt::no_ownership(), shape),
+                           xt::adapt(mask, count, xt::no_ownership(), shape));
+        return variable_type(std::move(var_data), coordinate_type(std::move(axes)), dimension_type(std::move(dims)));
+    }
+}
+
+#endif
@@ -0,0 +1,809 @@
+/***************************************************************************
+* Copyright (c) Johan Mabille, Sylvain Corlay, Wolf Vollprecht and         *
+* Martin Renou                                                             *
+* Copyright (c) QuantStack                                                 *
+*                                                                          *
+* Distributed under the terms of the BSD 3-Clause License.                 *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#ifndef XFRAME_IO_CHUNKED_HPP
+#define XFRAME_IO_CHUNKED_HPP
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#if defined(_WIN32)
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#include <sys/types.h>
+#endif
+
+#include "xtensor/xarray.hpp"
+#include "xtensor/xoptional_assembly.hpp"
+
+#include "xaxis_label_slice.hpp"
+#include "xio_binary.hpp"
+#include "xselecting.hpp"
+#include "xvariable.hpp"
+#include "xvariable_view.hpp"
+
+namespace xf
+{
+    /**
+     * Layout of the directories written by save_chunked. The values are
+     * split into blocks of the chunk shape; the blocks on the upper edges
+     * of the variable are truncated to its shape.
+     *
+     * - metadata, in the file named xchunked_metadata: magic "XFRAMECK",
+     *   version (uint32), byte order mark (uint32), value type code (uint32),
+     *   dimension count (uint32), then the chunk shape (uint64 each), then
+     *   the dimension list and the axes encoded as in the files written by
+     *   save (see xio_binary.hpp)
+     * - one file per block, named after the position of the block along
+     *   each dimension separated by dots ("0.3.1"): the values of the block
+     *   in row-major order, followed by the missing mask, one byte per value
+     */
+    constexpr uint32_t xchunked_version = 1;
+    constexpr const char* xchunked_metadata = ".xchunks";
+
+    namespace detail
+    {
+        template <class T>
+        struct xchunk
+        {
+            std::vector<T> values;
+            std::vector<char> mask;
+        };
+
+        /**
+         * @class xchunk_cache
+         * @brief Bounded cache of the last blocks read, least recently used
+         * blocks being evicted first.
+         */
+        template <class T>
+        class xchunk_cache
+        {
+        public:
+
+            using chunk_type = xchunk<T>;
+            using chunk_pointer = std::shared_ptr<const chunk_type>;
+
+            explicit xchunk_cache(std::size_t capacity);
+
+            template <class F>
+            chunk_pointer get(std::size_t id, F&& load);
+
+        private:
+
+            using list_type = std::list<std::pair<std::size_t, chunk_pointer>>;
+
+            std::size_t m_capacity;
+            list_type m_chunks;
+            std::unordered_map<std::size_t, typename list_type::iterator> m_index;
+            std::mutex m_mutex;
+        };
+    }
+
+    /*********************
+     * xchunked_variable *
+     *********************/
+
+    /**
+     * @class xchunked_variable
+     * @brief Variable stored in a directory written by save_chunked.
+     *
+     * Only the axes are read when the variable is opened. Accessing an element
+     * reads the block that holds it, and load reads the blocks intersecting the
+     * selected region only. The last blocks read are kept in a cache bounded
+     * by a number of blocks, so that memory use does not depend on the size of
+     * the variable. Const access is thread-safe.
+     *
+     * @tparam T the value type of the variable.
+     * @tparam K the type of dimension names.
+     * @tparam L the type list of axes labels.
+     * @tparam S the integer type used to represent positions in axes.
+     * @tparam MT the tag used for choosing the map type of the axes.
+     */
+    template <class T, class K = fstring, class L = XFRAME_DEFAULT_LABEL_LIST, class S = std::size_t, class MT = hash_map_tag>
+    class xchunked_variable
+    {
+    public:
+
+        using value_type = xtl::xoptional<T, bool>;
+        using coordinate_type = xcoordinate<K, L, S, MT>;
+        using dimension_type = xdimension<K, S>;
+        using key_type = K;
+        using size_type = S;
+        using shape_type = std::vector<size_type>;
+        using data_type = xt::xoptional_assembly<xt::xarray<T>, xt::xarray<bool>>;
+        using variable_type = xvariable_container<coordinate_type, data_type>;
+        using slice_map = std::map<key_type, xaxis_slice<L>>;
+
+        template <std::size_t N = dynamic()>
+        using index_type = detail::xselector_sequence_t<size_type, N>;
+        template <std::size_t N = dynamic()>
+        using selector_type = xselector<coordinate_type, dimension_type, N>;
+        template <std::size_t N = dynamic()>
+        using selector_sequence_type = typename selector_type<N>::sequence_type;
+
+        explicit xchunked_variable(const std::string& directory, std::size_t cache_capacity = 64);
+
+        const coordinate_type& coordinates() const noexcept;
+        const dimension_type& dimension_mapping() const noexcept;
+        size_type dimension() const noexcept;
+        const shape_type& shape() const noexcept;
+        const shape_type& chunk_shape() const noexcept;
+
+        template <class... Args>
+        value_type operator()(Args... args) const;
+
+        template <std::size_t N = dynamic()>
+        value_type element(const index_type<N>& index) const;
+
+        template <class... Args>
+        value_type locate(Args&&... args) const;
+
+        template <std::size_t N = dynamic()>
+        value_type select(const selector_sequence_type<N>& selector) const;
+
+        variable_type load() const;
+        auto load(slice_map&& slices) const;
+
+    private:
+
+        struct metadata
+        {
+            typename coordinate_type::map_type axes;
+            std::vector<key_type> dims;
+            shape_type chunk_shape;
+        };
+
+        xchunked_variable(const std::string& directory, std::size_t cache_capacity, metadata&& meta);
+
+        static metadata read_metadata(const std::string& directory);
+
+        template <std::size_t... I, class... Args>
+        value_type locate_impl(std::index_sequence<I...>, Args&&... args) const;
+
+        template <class Idx>
+        value_type element_at(const Idx& index) const;
+
+        variable_type load_region(const shape_type& first, const shape_type& last) const;
+
+        using cache_type = detail::xchunk_cache<T>;
+        using chunk_pointer = typename cache_type::chunk_pointer;
+
+        chunk_pointer read_chunk(const shape_type& chunk_index) const;
+
+        std::string m_directory;
+        coordinate_type m_coordinate;
+        dimension_type m_dimension;
+        shape_type m_shape;
+        shape_type m_chunk_shape;
+        shape_type m_chunk_count;
+        std::unique_ptr<cache_type> p_cache;
+    };
+
+    template <class CCT, class ECT>
+    void save_chunked(const std::string& directory, const xvariable_container<CCT, ECT>& v, const std::vector<std::size_t>& chunk_shape);
+
+    template <class T, class K = fstring, class L = XFRAME_DEFAULT_LABEL_LIST, class S = std::size_t, class MT = hash_map_tag>
+    xchunked_variable<T, K, L, S, MT> open_chunked(const std::string& directory, std::size_t cache_capacity = 64);
+
+    namespace detail
+    {
+        constexpr char xchunked_magic[8] = {'X', 'F', 'R', 'A', 'M', 'E', 'C', 'K'};
+
+        /*******************************
+         * xchunk_cache implementation *
+         *******************************/
+
+        template <class T>
+        inline xchunk_cache<T>::xchunk_cache(std::size_t capacity)
+            : m_capacity(std::max(capacity, std::size_t(1)))
+        {
+        }
+
+        /**
+         * Returns the block of the specified id, calling load to read it if
+         * it is not in the cache. The block stays valid while it is referred
+         * to, even if it is evicted meanwhile.
+         */
+        template <class T>
+        template <class F>
+        inline auto xchunk_cache<T>::get(std::size_t id, F&& load) -> chunk_pointer
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                auto it = m_index.find(id);
+                if (it != m_index.end())
+                {
+                    m_chunks.splice(m_chunks.begin(), m_chunks, it->second);
+                    return it->second->second;
+                }
+            }
+            // reads happen outside the lock; concurrent readers of the same
+            // block may both read it, the first one inserted is kept
+            chunk_pointer chunk = load();
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto it = m_index.find(id);
+            if (it != m_index.end())
+                return it->second->second;
+            m_chunks.emplace_front(id, chunk);
+            m_index.emplace(id, m_chunks.begin());
+            if (m_chunks.size() > m_capacity)
+            {
+                m_index.erase(m_chunks.back().first);
+                m_chunks.pop_back();
+            }
+            return chunk;
+        }
+
+        /***************
+         * chunk files *
+         ***************/
+
+        inline void make_chunked_directory(const std::string& directory)
+        {
+#if defined(_WIN32)
+            const int res = ::_mkdir(directory.c_str());
+#else
+            const int res = ::mkdir(directory.c_str(), 0755);
+#endif
+            if (res != 0 && errno != EEXIST)
+                throw std::runtime_error("cannot create directory " + directory);
+        }
+
+        template <class It>
+        inline std::string chunk_filename(const std::string& directory, It first, It last)
+        {
+            std::string res = directory + "/";
+            for (It it = first; it != last; ++it)
+            {
+                if (it != first)
+                    res += '.';
+                res += std::to_string(*it);
+            }
+            return res;
+        }
+
+        /**
+         * Moves index to the next position of the box [first, last) in
+         * row-major order; returns false once the whole box has been visited.
+         */
+        template <class I>
+        inline bool next_chunked_index(I& index, const I& first, const I& last)
+        {
+            for (std::size_t i = index.size(); i != 0; --i)
+            {
+                if (++index[i - 1] != last[i - 1])
+                    return true;
+                index[i - 1] = first[i - 1];
+            }
+            return false;
+        }
+
+        template <class A, class LB, class T>
+        inline bool make_default_chunked_axis(const xaxis_default<LB, T>&, std::size_t size, A& res)
+        {
+            res = A(xaxis_default<LB, T>(size));
+            return true;
+        }
+
+        template <class A, class X>
+        inline bool make_default_chunked_axis(const X&, std::size_t, A&)
+        {
+            return false;
+        }
+
+        /**
+         * Returns the axis holding the labels [first, last) of axis. A default
+         * axis stays a default axis when the box starts at its first label.
+         */
+        template <class A>
+        inline A make_chunked_axis(const A& axis, std::size_t first, std::size_t last)
+        {
+            if (first == 0)
+            {
+                A res;
+                auto make_default = [last, &res](const auto& arg) { return make_default_chunked_axis(arg, last, res); };
+                if (xtl::visit(make_default, axis.storage()))
+                    return res;
+            }
+            auto labels = axis.labels();
+            return xtl::visit([first, last](const auto& arg) -> A
+            {
+                const auto& vec = unwrap(arg);
+                using label_type = typename std::decay_t<decltype(vec)>::value_type;
+                using axis_type = xaxis<label_type, typename A::mapped_type, typename A::map_container_tag>;
+                return A(axis_type(std::vector<label_type>(vec.cbegin() + first, vec.cbegin() + last)));
+            }, labels.storage());
+        }
+
+        /**
+         * Rewrites the slice selecting the specified indices of an axis as a
+         * slice of the labels, which only refers to selected labels. Evenly
+         * spaced indices give a range, other ones a keep slice.
+         */
+        template <class L, class A, class V>
+        inline xaxis_slice<L> make_chunked_slice(const A& axis, const V& indices)
+        {
+            const std::size_t size = indices.size();
+            bool is_range = size > 1 && indices[1] > indices[0];
+            for (std::size_t i = 2; i < size && is_range; ++i)
+                is_range = indices[i] - indices[i - 1] == indices[1] - indices[0];
+            if (is_range && indices[1] - indices[0] == 1)
+                return range<L>(axis.label(indices.front()), axis.label(indices.back()));
+            if (is_range)
+                return range<std::size_t, L>(axis.label(indices.front()), axis.label(indices.back()), indices[1] - indices[0]);
+            std::vector<xlabel_variant_t<L>> labels;
+            labels.reserve(size);
+            for (const auto& index : indices)
+                labels.push_back(axis.label(index));
+            return keep<L>(labels);
+        }
+    }
+
+    /************************************
+     * xchunked_variable implementation *
+     ************************************/
+
+    /**
+     * Opens a variable written by save_chunked, reading its axes only.
+     * @param directory the directory of the variable.
+     * @param cache_capacity the number of blocks kept in memory.
+     */
+    template <class T, class K, class L, class S, class MT>
+    inline xchunked_variable<T, K, L, S, MT>::xchunked_variable(const std::string& directory, std::size_t cache_capacity)
+        : xchunked_variable(directory, cache_capacity, read_metadata(directory))
+    {
+    }
+
+    template <class T, class K, class L, class S, class MT>
+    inline xchunked_variable<T, K, L, S, MT>::xchunked_variable(const std::string& directory, std::size_t cache_capacity, metadata&& meta)
+        : m_directory(directory),
+          m_coordinate(std::move(meta.axes)),
+          m_dimension(std::move(meta.dims)),
+          m_shape(),
+          m_chunk_shape(std::move(meta.chunk_shape)),
+          m_chunk_count(),
+          p_cache(std::make_unique<cache_type>(cache_capacity))
+    {
+        for (std::size_t i = 0; i < m_chunk_shape.size(); ++i)
+        {
+            m_shape.push_back(m_coordinate[m_dimension.labels()[i]].size());
+            m_chunk_count.push_back((m_shape[i] + m_chunk_shape[i] - 1) / m_chunk_shape[i]);
+        }
+    }
+
+    template <class T, class K, class L, class S, class MT>
+    inline auto xchunked_variable<T, K, L, S, MT>::read_metadata(const std::string& directory) -> metadata
+    {
+        static_assert(std::is_arithmetic<T>::value, "only variables of arithmetic values can be loaded");
+        const std::string filename = directory + "/" + xchunked_metadata;
+        std::ifstream in(filename, std::ios::binary);
+        if (!in)
+            throw std::runtime_error("cannot open file " + filename);
+        const std::vector<char> buffer((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+        detail::xbinary_reader reader(buffer.data(), buffer.size());
+        if (std::memcmp(reader.read(sizeof(detail::xchunked_magic)), detail::xchunked_magic, sizeof(detail::xchunked_magic)) != 0)
+            throw std::runtime_error("not a chunked variable");
+        if (reader.read<uint32_t>() != xchunked_version)
+            throw std::runtime_error("unsupported chunked variable version");
+        if (reader.read<uint32_t>() != detail::xbinary_byte_order)
+            throw std::runtime_error("chunked variable written with another byte order");
+        if (reader.read<uint32_t>() != detail::xbinary_type_code<T>())
+            throw std::runtime_error("value type mismatch in chunked variable");
+        const std::size_t dimension_count = reader.read<uint32_t>();
+        if (dimension_count == 0)
+            throw std::runtime_error("invalid chunked variable");
+
+        metadata res;
+        for (std::size_t i = 0; i < dimension_count; ++i)
+        {
+            const uint64_t size = reader.read<uint64_t>();
+            if (size == 0)
+                throw std::runtime_error("invalid chunk shape in chunked variable");
+            res.chunk_shape.push_back(static_cast<size_type>(size));
+        }
+        for (std::size_t i = 0; i < dimension_count; ++i)
+        {
+            const std::string dim = reader.read_string();
+            res.dims.push_back(K(dim.data(), dim.size()));
+        }
+
+        using axis_type = typename coordinate_type::axis_type;
+        using axis_reader = typename detail::xbinary_axis_reader_list<axis_type, L>::type;
+        for (const auto& dim : res.dims)
+        {
+            const uint32_t index = reader.read<uint32_t>();
+            const uint32_t code = reader.read<uint32_t>();
+            const bool is_default = reader.read<uint32_t>() != 0;
+            reader.read<uint32_t>();
+            const std::size_t axis_size = static_cast<std::size_t>(reader.read<uint64_t>());
+            res.axes.emplace(dim, axis_reader::read(reader, index, code, is_default, axis_size));
+        }
+        if (res.axes.size() != dimension_count)
+            throw std::runtime_error("duplicate dimension in chunked variable");
+        return res;
+    }
+
+    template <class T, class K, class L, class S, class MT>
+    inline auto xchunked_variable<T, K, L, S, MT>::coordinates() const noexcept -> const coordinate_type&
+    {
+        return m_coordinate;
+    }
+
+    template <class T, class K, class L, class S, class MT>
+    inline auto xchunked_variable<T, K, L, S, MT>::dimension_mapping() const noexcept -> const dimension_type&
+    {
+        return m_dimension;
+    }
+
+    template <class T, class K, class L, class S, class MT>
+    inline auto xchunked_variable<T, K, L, S, MT>::dimension() const noexcept -> size_type
+    {
+        return m_shape.size();
+    }
+
+    template <class T, class K, class L, class S, class MT>
+    inline auto xchunked_variable<T, K, L, S, MT>::shape() const noexcept -> const shape_type&
+    {
+        return m_shape;
+    }
+
+    template <class T, class K, class L, class S, class MT>
+    inline auto xchunked_variable<T, K, L, S, MT>::chunk_shape() const noexcept -> const shape_type&
+    {
+        return m_chunk_shape;
+    }
+
+    /**
+     * Returns the element at the specified positions, reading the block
+     * that holds it.
+     */
+    template <class T, class K, class L, class S, class MT>
+    template <class... Args>
+    inline auto xchunked_variable<T, K, L, S, MT>::operator()(Args... args) const -> value_type
+    {
+        index_type<sizeof...(Args)> index = { static_cast<size_type>(args)... };
+        return element_at(index);
+    }
+
+    template <class T, class K, class L, class S, class MT>
+    template <std::size_t N>
+    inline auto xchunked_variable<T, K, L, S, MT>::element(const index_type<N>& index) const -> value_type
+    {
+        return element_at(index);
+    }
+
+    /**
+     * Returns the element at the specified labels, one per dimension in
+     * the order of the dimensions.
+     */
+    template <class T, class K, class L, class S, class MT>
+    template <class... Args>
+    inline auto xchunked_variable<T, K, L, S, MT>::locate(Args&&... args) const -> value_type
+    {
+        return locate_impl(std::make_index_sequence<sizeof...(Args)>(), std::forward<Args>(args)...);
+    }
+
+    template <class T, class K, class L, class S, class MT>
+    template <std::size_t N>
+    inline auto xchunked_variable<T, K, L, S, MT>::select(const selector_sequence_type<N>& selector) const -> value_type
+    {
+        return element_at(selector_type<N>(selector).get_index(m_coordinate, m_dimension));
+    }
+
+    /**
+     * Reads the whole variable in memory.
+     */
+    template <class T, class K, class L, class S, class MT>
+    inline auto xchunked_variable<T, K, L, S, MT>::load() const -> variable_type
+    {
+        return load_region(shape_type(m_shape.size(), size_type(0)), m_shape);
+    }
+
+    /**
+     * Returns a view on the region selected by slices, as select does on an
+     * in-memory variable. The smallest box holding the selected elements is
+     * read in memory, the view owns it; only the blocks intersecting this
+     * box are read.
+     * @param slices the slices of the dimensions to select, all the labels
+     *               of the other dimensions are selected.
+     */
+    template <class T, class K, class L, class S, class MT>
+    inline auto xchunked_variable<T, K, L, S, MT>::load(slice_map&& slices) const
+    {
+        const auto& dims = m_dimension.labels();
+        shape_type first(dims.size(), size_type(0));
+        shape_type last(m_shape);
+        std::vector<std::vector<size_type>> indices(dims.size());
+        std::vector<bool> is_squeeze(dims.size(), false);
+        for (std::size_t i = 0; i < dims.size(); ++i)
+        {
+            auto iter = slices.find(dims[i]);
+            if (iter == slices.end())
+                continue;
+            const auto& axis = m_coordinate[dims[i]];
+            if (auto* sq = iter->second.get_squeeze())
+            {
+                is_squeeze[i] = true;
+                first[i] = axis[*sq];
+                last[i] = first[i] + 1;
+            }
+            else
+            {
+                auto index_slice = iter->second.build_index_slice(axis);
+                for (size_type j = 0; j < index_slice.size(); ++j)
+                    indices[i].push_back(index_slice(j));
+                if (indices[i].empty())
+                {
+                    last[i] = first[i];
+                }
+                else
+                {
+                    auto bounds = std::minmax_element(indices[i].cbegin(), indices[i].cend());
+                    first[i] = *bounds.first;
+                    last[i] = *bounds.second + 1;
+                }
+            }
+        }
+
+        variable_type region = load_region(first, last);
+
+        slice_map region_slices;
+        for (std::size_t i = 0; i < dims.size(); ++i)
+        {
+            auto iter = slices.find(dims[i]);
+            if (iter == slices.end())
+                continue;
+            if (is_squeeze[i])
+            {
+                region_slices.emplace(dims[i], std::move(iter->second));
+            }
+            else
+            {
+                for (auto& index : indices[i])
+                    index -= first[i];
+                region_slices.emplace(dims[i], detail::make_chunked_slice<L>(region.coordinates()[dims[i]], indices[i]));
+            }
+        }
+        return xf::select(std::move(region), std::move(region_slices));
+    }
+
+    template <class T, class K, class L, class S, class MT>
+    template <std::size_t... I, class... Args>
+    inline auto xchunked_variable<T, K, L, S, MT>::locate_impl(std::index_sequence<I...>, Args&&... args) const -> value_type
+    {
+        index_type<sizeof...(Args)> index = { m_coordinate[m_dimension.labels()[I]][args]... };
+        return element_at(index);
+    }
+
+    template <class T, class K, class L, class S, class MT>
+    template <class Idx>
+    inline auto xchunked_variable<T, K, L, S, MT>::element_at(const Idx& index) const -> value_type
+    {
+        if (index.size() != m_shape.size())
+            throw std::runtime_error("index does not match the dimension of the chunked variable");
+        shape_type chunk_index(m_shape.size());
+        std::size_t offset = 0;
+        for (std::size_t i = 0; i < m_shape.size(); ++i)
+        {
+            if (static_cast<size_type>(index[i]) >= m_shape[i])
+                throw std::runtime_error("index out of the bounds of the chunked variable");
+            chunk_index[i] = static_cast<size_type>(index[i]) / m_chunk_shape[i];
+            const size_type chunk_first = chunk_index[i] * m_chunk_shape[i];
+            const size_type chunk_size = std::min(m_chunk_shape[i], m_shape[i] - chunk_first);
+            offset = offset * chunk_size + (static_cast<size_type>(index[i]) - chunk_first);
+        }
+        chunk_pointer chunk = read_chunk(chunk_index);
+        return value_type(chunk->values[offset], chunk->mask[offset] != 0);
+    }
+
+    /**
+     * Reads the box [first, last) in a variable, block by block.
+     */
+    template <class T, class K, class L, class S, class MT>
+    inline auto xchunked_variable<T, K, L, S, MT>::load_region(const shape_type& first, const shape_type& last) const -> variable_type
+    {
+        const auto& dims = m_dimension.labels();
+        const std::size_t dimension = m_shape.size();
+        shape_type region_shape(dimension);
+        for (std::size_t i = 0; i < dimension; ++i)
+            region_shape[i] = last[i] - first[i];
+        xt::xarray<T> values = xt::xarray<T>::from_shape(region_shape);
+        xt::xarray<bool> mask = xt::xarray<bool>::from_shape(region_shape);
+
+        const bool is_empty = std::find(region_shape.cbegin(), region_shape.cend(), size_type(0)) != region_shape.cend();
+        if (!is_empty)
+        {
+            shape_type first_chunk(dimension);
+            shape_type last_chunk(dimension);
+            for (std::size_t i = 0; i < dimension; ++i)
+            {
+                first_chunk[i] = first[i] / m_chunk_shape[i];
+                last_chunk[i] = (last[i] - 1) / m_chunk_shape[i] + 1;
+            }
+
+            // each block is copied by runs along the last dimension
+            shape_type chunk_index(first_chunk);
+            do
+            {
+                chunk_pointer chunk = read_chunk(chunk_index);
+                shape_type chunk_begin(dimension);
+                shape_type chunk_size(dimension);
+                shape_type box_first(dimension);
+                shape_type box_last(dimension);
+                for (std::size_t i = 0; i < dimension; ++i)
+                {
+                    chunk_begin[i] = chunk_index[i] * m_chunk_shape[i];
+                    chunk_size[i] = std::min(m_chunk_shape[i], m_shape[i] - chunk_begin[i]);
+                    box_first[i] = std::max(first[i], chunk_begin[i]);
+                    box_last[i] = std::min(last[i], chunk_begin[i] + chunk_size[i]);
+                }
+                const std::size_t run = box_last.back() - box_first.back();
+                shape_type position(box_first);
+                shape_type run_last(box_last);
+                run_last.back() = box_first.back() + 1;
+                do
+                {
+                    std::size_t src = 0;
+                    std::size_t dst = 0;
+                    for (std::size_t i = 0; i < dimension; ++i)
+                    {
+                        src = src * chunk_size[i] + (position[i] - chunk_begin[i]);
+                        dst = dst * region_shape[i] + (position[i] - first[i]);
+                    }
+                    std::copy(chunk->values.data() + src, chunk->values.data() + src + run, values.data() + dst);
+                    std::transform(chunk->mask.data() + src, chunk->mask.data() + src + run, mask.data() + dst,
+                                   [](char c) { return c != 0; });
+                } while (detail::next_chunked_index(position, box_first, run_last));
+            } while (detail::next_chunked_index(chunk_index, first_chunk, last_chunk));
+        }
+
+        typename coordinate_type::map_type axes;
+        for (std::size_t i = 0; i < dimension; ++i)
+            axes.emplace(dims[i], detail::make_chunked_axis(m_coordinate[dims[i]], first[i], last[i]));
+        return variable_type(data_type(std::move(values), std::move(mask)), coordinate_type(std::move(axes)), m_dimension);
+    }
+
+    template <class T, class K, class L, class S, class MT>
+    inline auto xchunked_variable<T, K, L, S, MT>::read_chunk(const shape_type& chunk_index) const -> chunk_pointer
+    {
+        std::size_t id = 0;
+        std::size_t count = 1;
+        for (std::size_t i = 0; i < chunk_index.size(); ++i)
+        {
+            id = id * m_chunk_count[i] + chunk_index[i];
+            count *= std::min(m_chunk_shape[i], m_shape[i] - chunk_index[i] * m_chunk_shape[i]);
+        }
+        return p_cache->get(id, [this, &chunk_index, count]()
+        {
+            const std::string filename = detail::chunk_filename(m_directory, chunk_index.cbegin(), chunk_index.cend());
+            std::ifstream in(filename, std::ios::binary);
+            if (!in)
+                throw std::runtime_error("cannot open file " + filename);
+            auto chunk = std::make_shared<detail::xchunk<T>>();
+            chunk->values.resize(count);
+            chunk->mask.resize(count);
+            in.read(reinterpret_cast<char*>(chunk->values.data()), static_cast<std::streamsize>(count * sizeof(T)));
+            in.read(chunk->mask.data(), static_cast<std::streamsize>(count));
+            if (!in)
+                throw std::runtime_error("truncated chunk file " + filename);
+            return chunk_pointer(std::move(chunk));
+        });
+    }
+
+    /************************************************
+     * save_chunked and open_chunked implementation *
+     ************************************************/
+
+    /**
+     * Writes a variable to a directory, split into blocks that can be read
+     * independently by the variable returned by open_chunked. The directory
+     * is created if it does not exist; the values must be of an arithmetic
+     * type.
+     * @param directory the directory of the variable.
+     * @param v the variable to save.
+     * @param chunk_shape the shape of the blocks, in the order of the dimensions.
+     */
+    template <class CCT, class ECT>
+    inline void save_chunked(const std::string& directory, const xvariable_container<CCT, ECT>& v, const std::vector<std::size_t>& chunk_shape)
+    {
+        const auto& values = v.data().value();
+        const auto& mask = v.data().has_value();
+        using value_type = typename std::decay_t<decltype(values)>::value_type;
+        static_assert(std::is_arithmetic<value_type>::value, "only variables of arithmetic values can be saved");
+
+        const auto& dims = v.dimension_mapping().labels();
+        const std::size_t dimension = dims.size();
+        if (dimension == 0 || chunk_shape.size() != dimension
+            || std::find(chunk_shape.cbegin(), chunk_shape.cend(), std::size_t(0)) != chunk_shape.cend())
+        {
+            throw std::runtime_error("invalid chunk shape");
+        }
+        detail::make_chunked_directory(directory);
+
+        detail::xbinary_writer writer(directory + "/" + xchunked_metadata);
+        writer.write(detail::xchunked_magic, sizeof(detail::xchunked_magic));
+        writer.write(xchunked_version);
+        writer.write(detail::xbinary_byte_order);
+        writer.write(detail::xbinary_type_code<value_type>());
+        writer.write(static_cast<uint32_t>(dimension));
+        for (auto size : chunk_shape)
+            writer.write(static_cast<uint64_t>(size));
+        for (const auto& dim : dims)
+            writer.write_string(dim.data(), dim.size());
+        for (const auto& dim : dims)
+            detail::write_binary_axis(writer, v.coordinates()[dim]);
+        writer.close();
+
+        const std::vector<std::size_t> shape(values.shape().cbegin(), values.shape().cend());
+        if (std::find(shape.cbegin(), shape.cend(), std::size_t(0)) != shape.cend())
+            return;
+        std::vector<std::size_t> first_chunk(dimension, 0);
+        std::vector<std::size_t> last_chunk(dimension);
+        for (std::size_t i = 0; i < dimension; ++i)
+            last_chunk[i] = (shape[i] + chunk_shape[i] - 1) / chunk_shape[i];
+
+        std::vector<value_type> chunk_values;
+        std::vector<char> chunk_mask;
+        std::vector<std::size_t> chunk_index(first_chunk);
+        do
+        {
+            std::vector<std::size_t> first(dimension);
+            std::vector<std::size_t> last(dimension);
+            for (std::size_t i = 0; i < dimension; ++i)
+            {
+                first[i] = chunk_index[i] * chunk_shape[i];
+                last[i] = std::min(first[i] + chunk_shape[i], shape[i]);
+            }
+            chunk_values.clear();
+            chunk_mask.clear();
+            std::vector<std::size_t> index(first);
+            do
+            {
+                chunk_values.push_back(values.element(index.cbegin(), index.cend()));
+                chunk_mask.push_back(mask.element(index.cbegin(), index.cend()) ? char(1) : char(0));
+            } while (detail::next_chunked_index(index, first, last));
+
+            detail::xbinary_writer chunk_writer(detail::chunk_filename(directory, chunk_index.cbegin(), chunk_index.cend()));
+            chunk_writer.write(reinterpret_cast<const char*>(chunk_values.data()), chunk_values.size() * sizeof(value_type));
+            chunk_writer.write(chunk_mask.data(), chunk_mask.size());
+            chunk_writer.close();
+        } while (detail::next_chunked_index(chunk_index, first_chunk, last_chunk));
+    }
+
+    /**
+     * Opens a variable written by save_chunked; see xchunked_variable.
+     * @param directory the directory of the variable.
+     * @param cache_capacity the number of blocks kept in memory.
+     * @tparam T the value type of the variable, must be the saved one.
+     */
+    template <class T, class K, class L, class S, class MT>
+    inline xchunked_variable<T, K, L, S, MT> open_chunked(const std::string& directory, std::size_t cache_capacity)
+    {
+        return xchunked_variable<T, K, L, S, MT>(directory, cache_capacity);
+    }
+}
+
+#endif
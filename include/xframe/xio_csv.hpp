@@ -0,0 +1,812 @@
+/***************************************************************************
+* Copyright (c) Johan Mabille, Sylvain Corlay, Wolf Vollprecht and         *
+* Martin Renou                                                             *
+* Copyright (c) QuantStack                                                 *
+*                                                                          *
+* Distributed under the terms of the BSD 3-Clause License.                 *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#ifndef XFRAME_IO_CSV_HPP
+#define XFRAME_IO_CSV_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <istream>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "xio_mmap.hpp"
+#include "xvariable.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define XFRAME_CSV_SSE2 1
+#else
+#define XFRAME_CSV_SSE2 0
+#endif
+
+namespace xf
+{
+    enum class csv_column_type
+    {
+        number,
+        string
+    };
+
+    using csv_coordinate_type = xcoordinate<fstring>;
+    using csv_dimension_type = xdimension<fstring, std::size_t>;
+    using csv_number_variable = xvariable<double, csv_coordinate_type>;
+    using csv_string_variable = xvariable<std::string, csv_coordinate_type>;
+
+    /**
+     * @class csv_dataset
+     * @brief Columns read from a delimited file.
+     *
+     * Numeric and text columns are stored in two variables with dimensions
+     * { "column", "row" }. The "column" axis holds the names of the header,
+     * the "row" axis holds the values of the index column, or is a default
+     * axis when there is no index column. Empty fields are missing values.
+     */
+    struct csv_dataset
+    {
+        csv_number_variable numbers;
+        csv_string_variable strings;
+    };
+
+    /**
+     * @class csv_read_options
+     * @brief Options of read_csv.
+     */
+    struct csv_read_options
+    {
+        char delimiter = ',';
+        char quote = '"';
+
+        /**
+         * If false, the file has no header and the columns are named
+         * by their position.
+         */
+        bool header = true;
+
+        /**
+         * Name of the column holding the labels of the "row" axis. Its values
+         * must be unique; they are integer labels when they all are integers,
+         * string labels otherwise.
+         */
+        std::string index_column;
+
+        /**
+         * Types of the columns; the type of the other columns is inferred,
+         * a column is numeric when all its non-empty fields are numbers.
+         */
+        std::map<std::string, csv_column_type> column_types;
+
+        /**
+         * Number of threads tokenising the file; 0 means one per core.
+         */
+        std::size_t thread_count = 1;
+    };
+
+    csv_dataset read_csv(std::istream& is, const csv_read_options& options = csv_read_options());
+    csv_dataset read_csv(const std::string& filename, const csv_read_options& options = csv_read_options());
+
+    namespace detail
+    {
+        /**
+         * A field of a row. When quoted, data points after the opening
+         * quote and escaped tells whether it contains doubled quotes.
+         */
+        struct xcsv_field
+        {
+            const char* data;
+            std::size_t length;
+            bool escaped;
+        };
+
+        /**
+         * Statistics of a chunk of rows, computed by the first pass.
+         */
+        struct xcsv_chunk
+        {
+            const char* begin;
+            const char* end;
+            std::size_t row_count = 0;
+            std::size_t row_index = 0;
+            std::vector<char> is_number;
+            bool is_integer_index = true;
+        };
+
+        template <class T>
+        inline bool has_duplicate_labels(std::vector<T> labels)
+        {
+            std::sort(labels.begin(), labels.end());
+            return std::adjacent_find(labels.begin(), labels.end()) != labels.end();
+        }
+
+        inline bool is_csv_digit(char c) noexcept
+        {
+            return c >= '0' && c <= '9';
+        }
+
+        /**
+         * Parses a plain decimal number: an optional sign, digits with an
+         * optional fraction, and an optional exponent. Unlike strtod, spaces,
+         * hexadecimal numbers, nan and inf are rejected, and the decimal
+         * point does not depend on the locale. Numbers with at most 19
+         * significant digits and a small exponent are converted exactly
+         * with a single multiplication or division; the others are handed
+         * to strtod without their decimal point, so that it rounds them
+         * correctly in any locale.
+         */
+        inline bool parse_csv_number(const char* first, const char* last, double& value)
+        {
+            static const double powers[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                            1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+            const char* it = first;
+            const bool negative = it != last && *it == '-';
+            if (it != last && (*it == '-' || *it == '+'))
+                ++it;
+            const char* int_first = it;
+            while (it != last && is_csv_digit(*it))
+                ++it;
+            const char* int_last = it;
+            const char* frac_first = it;
+            if (it != last && *it == '.')
+            {
+                frac_first = ++it;
+                while (it != last && is_csv_digit(*it))
+                    ++it;
+            }
+            const char* frac_last = it;
+            if (int_first == int_last && frac_first == frac_last)
+                return false;
+            long exponent = 0;
+            if (it != last && (*it == 'e' || *it == 'E'))
+            {
+                ++it;
+                const bool negative_exponent = it != last && *it == '-';
+                if (it != last && (*it == '-' || *it == '+'))
+                    ++it;
+                if (it == last || !is_csv_digit(*it))
+                    return false;
+                for (; it != last && is_csv_digit(*it); ++it)
+                    exponent = std::min(exponent * 10 + (*it - '0'), 100000L);
+                exponent = negative_exponent ? -exponent : exponent;
+            }
+            if (it != last)
+                return false;
+
+            // significant digits, up to 19 of them fit in the mantissa
+            uint64_t mantissa = 0;
+            int digit_count = 0;
+            bool truncated = false;
+            long scale = exponent;
+            auto add_digit = [&](char c, bool is_fraction)
+            {
+                if (digit_count < 19)
+                {
+                    mantissa = mantissa * 10 + static_cast<uint64_t>(c - '0');
+                    digit_count += mantissa != 0 ? 1 : 0;
+                    scale -= is_fraction ? 1 : 0;
+                }
+                else
+                {
+                    truncated = truncated || c != '0';
+                    scale += is_fraction ? 0 : 1;
+                }
+            };
+            std::for_each(int_first, int_last, [&](char c) { add_digit(c, false); });
+            std::for_each(frac_first, frac_last, [&](char c) { add_digit(c, true); });
+
+            if (mantissa == 0)
+            {
+                value = negative ? -0. : 0.;
+            }
+            else if (!truncated && mantissa <= (uint64_t(1) << 53) && scale >= -22 && scale <= 22)
+            {
+                const double m = static_cast<double>(mantissa);
+                value = scale < 0 ? m / powers[-scale] : m * powers[scale];
+                value = negative ? -value : value;
+            }
+            else
+            {
+                std::string buffer(negative ? "-" : "");
+                buffer.append(int_first, int_last);
+                buffer.append(frac_first, frac_last);
+                buffer += 'e';
+                buffer += std::to_string(exponent - static_cast<long>(frac_last - frac_first));
+                value = std::strtod(buffer.c_str(), nullptr);
+            }
+            return true;
+        }
+
+        /**
+         * Parses an integer made of an optional sign and decimal digits.
+         */
+        inline bool parse_csv_integer(const char* first, const char* last, int& value)
+        {
+            const char* it = first;
+            const bool negative = it != last && *it == '-';
+            if (it != last && (*it == '-' || *it == '+'))
+                ++it;
+            if (it == last)
+                return false;
+            // accumulated as a negative number, whose range is the largest
+            const long long bound = negative ? static_cast<long long>(std::numeric_limits<int>::min())
+                                             : -static_cast<long long>(std::numeric_limits<int>::max());
+            long long res = 0;
+            for (; it != last; ++it)
+            {
+                if (!is_csv_digit(*it))
+                    return false;
+                res = res * 10 - (*it - '0');
+                if (res < bound)
+                    return false;
+            }
+            value = static_cast<int>(negative ? res : -res);
+            return true;
+        }
+
+        /***************
+         * xcsv_parser *
+         ***************/
+
+        /**
+         * @class xcsv_parser
+         * @brief Two-pass parallel parser of delimited text.
+         *
+         * The text after the header is split into chunks ending on a line
+         * break outside quotes. A first pass counts the rows of each chunk
+         * and checks which columns are numeric; a prefix sum of the row
+         * counts gives the position of each chunk, and a second pass writes
+         * the fields directly at their position in the columnar buffers.
+         * Both passes process the chunks in parallel.
+         */
+        class xcsv_parser
+        {
+        public:
+
+            xcsv_parser(const char* data, std::size_t size, const csv_read_options& options);
+
+            csv_dataset parse();
+
+        private:
+
+            enum class slot_kind
+            {
+                number,
+                string,
+                index
+            };
+
+            struct column_slot
+            {
+                slot_kind kind;
+                std::size_t index;
+            };
+
+            const char* next_special(const char* first, const char* last) const noexcept;
+            const char* parse_row(const char* it, std::vector<xcsv_field>& fields) const;
+            std::string field_string(const xcsv_field& field) const;
+            void assign_field(std::string& str, const xcsv_field& field) const;
+            bool parse_number(const xcsv_field& field, std::string& buffer, double& value) const;
+            bool parse_integer(const xcsv_field& field, std::string& buffer, int& value) const;
+
+            void parse_header();
+            std::vector<xcsv_chunk> split(std::size_t chunk_count) const;
+            void scan_chunk(xcsv_chunk& chunk) const;
+            void decode_chunk(const xcsv_chunk& chunk, double* numbers, bool* number_mask, std::string* strings,
+                              bool* string_mask, std::vector<int>& int_labels, std::vector<std::string>& string_labels) const;
+
+            template <class F>
+            void run(std::vector<xcsv_chunk>& chunks, F&& f) const;
+
+            const char* p_begin;
+            const char* p_end;
+            const csv_read_options& m_options;
+            std::size_t m_thread_count;
+            std::vector<std::string> m_colname_vec;
+            std::size_t m_index_column;
+            bool m_integer_index;
+            std::vector<column_slot> m_slot_vec;
+            std::size_t m_row_count;
+        };
+
+        /******************************
+         * xcsv_parser implementation *
+         ******************************/
+
+        inline xcsv_parser::xcsv_parser(const char* data, std::size_t size, const csv_read_options& options)
+            : p_begin(data), p_end(data + size), m_options(options), m_thread_count(options.thread_count),
+              m_colname_vec(), m_index_column(std::numeric_limits<std::size_t>::max()), m_integer_index(false),
+              m_slot_vec(), m_row_count(0)
+        {
+            if (m_thread_count == 0)
+                m_thread_count = std::max(std::thread::hardware_concurrency(), 1u);
+            if (options.delimiter == '\n' || options.delimiter == '\r' || options.delimiter == options.quote)
+                throw std::runtime_error("invalid csv delimiter");
+        }
+
+        /**
+         * Returns the first delimiter, quote or line feed of [first, last),
+         * or last. With SSE2, the text is scanned sixteen bytes at a time
+         * by comparing them to the three characters. Otherwise, and for the
+         * tail, it is scanned eight bytes at a time: a byte equal to c
+         * becomes a zero byte of word ^ (c * 0x0101..), and zero bytes are
+         * detected for the three characters at once.
+         */
+        inline const char* xcsv_parser::next_special(const char* first, const char* last) const noexcept
+        {
+#if XFRAME_CSV_SSE2
+            const __m128i delimiter_mask = _mm_set1_epi8(m_options.delimiter);
+            const __m128i quote_mask = _mm_set1_epi8(m_options.quote);
+            const __m128i line_feed_mask = _mm_set1_epi8('\n');
+            while (last - first >= 16)
+            {
+                const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first));
+                const __m128i match = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(block, delimiter_mask), _mm_cmpeq_epi8(block, quote_mask)),
+                                                   _mm_cmpeq_epi8(block, line_feed_mask));
+                if (_mm_movemask_epi8(match) != 0)
+                    break;
+                first += 16;
+            }
+#endif
+            constexpr uint64_t ones = 0x0101010101010101ull;
+            constexpr uint64_t highs = 0x8080808080808080ull;
+            const uint64_t delimiter = ones * static_cast<unsigned char>(m_options.delimiter);
+            const uint64_t quote = ones * static_cast<unsigned char>(m_options.quote);
+            const uint64_t line_feed = ones * static_cast<unsigned char>('\n');
+            auto has_zero = [](uint64_t v) { return (v - ones) & ~v & highs; };
+            while (last - first >= 8)
+            {
+                uint64_t word;
+                std::memcpy(&word, first, sizeof(word));
+                if ((has_zero(word ^ delimiter) | has_zero(word ^ quote) | has_zero(word ^ line_feed)) != 0)
+                    break;
+                first += 8;
+            }
+            const char delimiter_char = m_options.delimiter;
+            const char quote_char = m_options.quote;
+            while (first != last && *first != delimiter_char && *first != quote_char && *first != '\n')
+                ++first;
+            return first;
+        }
+
+        /**
+         * Splits the row starting at it into fields and returns the beginning
+         * of the next row. A trailing carriage return is not part of the row.
+         */
+        inline const char* xcsv_parser::parse_row(const char* it, std::vector<xcsv_field>& fields) const
+        {
+            fields.clear();
+            const char quote = m_options.quote;
+            while (true)
+            {
+                xcsv_field field = {it, 0, false};
+                const char* stop;
+                if (it != p_end && *it == quote)
+                {
+                    // quoted field, up to the quote that is not doubled
+                    const char* data = it + 1;
+                    const char* pos = data;
+                    while (true)
+                    {
+                        pos = static_cast<const char*>(std::memchr(pos, quote, static_cast<std::size_t>(p_end - pos)));
+                        if (pos == nullptr)
+                            throw std::runtime_error("unterminated csv quoted field");
+                        if (pos + 1 != p_end && pos[1] == quote)
+                        {
+                            field.escaped = true;
+                            pos += 2;
+                        }
+                        else
+                        {
+                            break;
+                        }
+                    }
+                    field.data = data;
+                    field.length = static_cast<std::size_t>(pos - data);
+                    // only a delimiter or a line break may follow the closing quote
+                    stop = pos + 1;
+                    if (stop != p_end && *stop == '\r' && (stop + 1 == p_end || stop[1] == '\n'))
+                        ++stop;
+                    if (stop != p_end && *stop != m_options.delimiter && *stop != '\n')
+                        throw std::runtime_error("unexpected character after csv quoted field");
+                }
+                else
+                {
+                    stop = next_special(it, p_end);
+                    if (stop != p_end && *stop == quote)
+                        throw std::runtime_error("unexpected quote in csv field");
+                    field.length = static_cast<std::size_t>(stop - it);
+                }
+                if (stop == p_end || *stop == '\n')
+                {
+                    if (field.length != 0 && field.data[field.length - 1] == '\r' && field.data + field.length == stop)
+                        --field.length;
+                    fields.push_back(field);
+                    return stop == p_end ? stop : stop + 1;
+                }
+                if (*stop == quote)
+                    throw std::runtime_error("unexpected quote in csv field");
+                fields.push_back(field);
+                it = stop + 1;
+            }
+        }
+
+        inline std::string xcsv_parser::field_string(const xcsv_field& field) const
+        {
+            std::string res;
+            assign_field(res, field);
+            return res;
+        }
+
+        inline void xcsv_parser::assign_field(std::string& str, const xcsv_field& field) const
+        {
+            if (!field.escaped)
+            {
+                str.assign(field.data, field.length);
+                return;
+            }
+            str.clear();
+            for (std::size_t i = 0; i < field.length; ++i)
+            {
+                str.push_back(field.data[i]);
+                if (field.data[i] == m_options.quote)
+                    ++i;
+            }
+        }
+
+        inline bool xcsv_parser::parse_number(const xcsv_field& field, std::string& buffer, double& value) const
+        {
+            if (!field.escaped)
+                return parse_csv_number(field.data, field.data + field.length, value);
+            assign_field(buffer, field);
+            return parse_csv_number(buffer.data(), buffer.data() + buffer.size(), value);
+        }
+
+        inline bool xcsv_parser::parse_integer(const xcsv_field& field, std::string& buffer, int& value) const
+        {
+            if (!field.escaped)
+                return parse_csv_integer(field.data, field.data + field.length, value);
+            assign_field(buffer, field);
+            return parse_csv_integer(buffer.data(), buffer.data() + buffer.size(), value);
+        }
+
+        inline void xcsv_parser::parse_header()
+        {
+            std::vector<xcsv_field> fields;
+            const char* it = p_begin;
+            if (it == p_end)
+                throw std::runtime_error("empty csv file");
+            const char* next = parse_row(it, fields);
+            if (m_options.header)
+            {
+                for (const auto& field : fields)
+                    m_colname_vec.push_back(field_string(field));
+                p_begin = next;
+            }
+            else
+            {
+                for (std::size_t i = 0; i < fields.size(); ++i)
+                    m_colname_vec.push_back(std::to_string(i));
+            }
+
+            if (!m_options.index_column.empty())
+            {
+                auto index_it = std::find(m_colname_vec.cbegin(), m_colname_vec.cend(), m_options.index_column);
+                if (index_it == m_colname_vec.cend())
+                    throw std::runtime_error("unknown csv index column " + m_options.index_column);
+                m_index_column = static_cast<std::size_t>(index_it - m_colname_vec.cbegin());
+            }
+            for (const auto& type : m_options.column_types)
+            {
+                if (std::find(m_colname_vec.cbegin(), m_colname_vec.cend(), type.first) == m_colname_vec.cend())
+                    throw std::runtime_error("unknown csv column " + type.first);
+            }
+        }
+
+        /**
+         * Splits the rows into chunks of about the same size. The number of
+         * quotes before a line break tells whether it ends a row or is part
+         * of a quoted field; they are counted once, from chunk to chunk.
+         */
+        inline std::vector<xcsv_chunk> xcsv_parser::split(std::size_t chunk_count) const
+        {
+            std::vector<xcsv_chunk> res;
+            const std::size_t size = static_cast<std::size_t>(p_end - p_begin);
+            const char quote = m_options.quote;
+            const char* begin = p_begin;
+            bool in_quotes = false;
+            for (std::size_t i = 1; i <= chunk_count && begin != p_end; ++i)
+            {
+                const char* end = p_end;
+                if (i != chunk_count)
+                {
+                    const char* target = std::max(begin, p_begin + size / chunk_count * i);
+                    in_quotes ^= (std::count(begin, target, quote) % 2) != 0;
+                    end = target;
+                    while (end != p_end && (in_quotes || (end != p_begin && end[-1] != '\n')))
+                    {
+                        if (*end == quote)
+                            in_quotes = !in_quotes;
+                        ++end;
+                    }
+                }
+                xcsv_chunk chunk;
+                chunk.begin = begin;
+                chunk.end = end;
+                res.push_back(std::move(chunk));
+                begin = end;
+            }
+            return res;
+        }
+
+        /**
+         * First pass: counts the rows of a chunk and checks which columns
+         * only hold numbers, and whether the index holds integers.
+         */
+        inline void xcsv_parser::scan_chunk(xcsv_chunk& chunk) const
+        {
+            const std::size_t column_count = m_colname_vec.size();
+            chunk.is_number.assign(column_count, 1);
+            std::vector<xcsv_field> fields;
+            std::string buffer;
+            double value = 0.;
+            int label = 0;
+            const char* it = chunk.begin;
+            while (it != chunk.end)
+            {
+                if (*it == '\n' || (*it == '\r' && it + 1 != chunk.end && it[1] == '\n'))
+                {
+                    it += *it == '\n' ? 1 : 2;
+                    continue;
+                }
+                it = parse_row(it, fields);
+                if (fields.size() != column_count)
+                    throw std::runtime_error("csv row has " + std::to_string(fields.size()) + " fields, "
+                                             + std::to_string(column_count) + " expected");
+                for (std::size_t col = 0; col < column_count; ++col)
+                {
+                    if (chunk.is_number[col] && fields[col].length != 0 && !parse_number(fields[col], buffer, value))
+                        chunk.is_number[col] = 0;
+                }
+                if (m_index_column < column_count && chunk.is_integer_index)
+                    chunk.is_integer_index = parse_integer(fields[m_index_column], buffer, label);
+                ++chunk.row_count;
+            }
+        }
+
+        /**
+         * Second pass: decodes the rows of a chunk at their position in
+         * the buffers.
+         */
+        inline void xcsv_parser::decode_chunk(const xcsv_chunk& chunk, double* numbers, bool* number_mask, std::string* strings,
+                                              bool* string_mask, std::vector<int>& int_labels, std::vector<std::string>& string_labels) const
+        {
+            std::vector<xcsv_field> fields;
+            std::string buffer;
+            std::size_t row = chunk.row_index;
+            const char* it = chunk.begin;
+            while (it != chunk.end)
+            {
+                if (*it == '\n' || (*it == '\r' && it + 1 != chunk.end && it[1] == '\n'))
+                {
+                    it += *it == '\n' ? 1 : 2;
+                    continue;
+                }
+                it = parse_row(it, fields);
+                for (std::size_t col = 0; col < fields.size(); ++col)
+                {
+                    const auto& field = fields[col];
+                    const column_slot& slot = m_slot_vec[col];
+                    if (slot.kind == slot_kind::number)
+                    {
+                        const std::size_t pos = slot.index * m_row_count + row;
+                        double value = std::numeric_limits<double>::quiet_NaN();
+                        const bool has_value = field.length != 0 && parse_number(field, buffer, value);
+                        if (field.length != 0 && !has_value)
+                            throw std::runtime_error("invalid number in csv column " + m_colname_vec[col]);
+                        numbers[pos] = has_value ? value : std::numeric_limits<double>::quiet_NaN();
+                        number_mask[pos] = has_value;
+                    }
+                    else if (slot.kind == slot_kind::string)
+                    {
+                        const std::size_t pos = slot.index * m_row_count + row;
+                        assign_field(strings[pos], field);
+                        string_mask[pos] = field.length != 0;
+                    }
+                    else if (m_integer_index)
+                    {
+                        parse_integer(field, buffer, int_labels[row]);
+                    }
+                    else
+                    {
+                        assign_field(string_labels[row], field);
+                    }
+                }
+                ++row;
+            }
+        }
+
+        /**
+         * Calls f on every chunk, the chunks being shared by the threads.
+         */
+        template <class F>
+        inline void xcsv_parser::run(std::vector<xcsv_chunk>& chunks, F&& f) const
+        {
+            if (chunks.size() < 2)
+            {
+                for (auto& chunk : chunks)
+                    f(chunk);
+                return;
+            }
+            std::vector<std::thread> threads;
+            std::vector<std::exception_ptr> errors(chunks.size());
+            threads.reserve(chunks.size());
+            for (std::size_t i = 0; i < chunks.size(); ++i)
+            {
+                threads.emplace_back([&chunks, &errors, &f, i]()
+                {
+                    try
+                    {
+                        f(chunks[i]);
+                    }
+                    catch (...)
+                    {
+                        errors[i] = std::current_exception();
+                    }
+                });
+            }
+            for (auto& thread : threads)
+                thread.join();
+            for (auto& error : errors)
+            {
+                if (error)
+                    std::rethrow_exception(error);
+            }
+        }
+
+        inline csv_dataset xcsv_parser::parse()
+        {
+            parse_header();
+            const std::size_t column_count = m_colname_vec.size();
+            std::vector<xcsv_chunk> chunks = split(m_thread_count);
+            run(chunks, [this](xcsv_chunk& chunk) { scan_chunk(chunk); });
+
+            std::vector<char> is_number(column_count, 1);
+            bool is_integer_index = true;
+            for (auto& chunk : chunks)
+            {
+                chunk.row_index = m_row_count;
+                m_row_count += chunk.row_count;
+                for (std::size_t col = 0; col < column_count; ++col)
+                    is_number[col] &= chunk.is_number[col];
+                is_integer_index = is_integer_index && chunk.is_integer_index;
+            }
+
+            std::vector<fstring> number_names;
+            std::vector<fstring> string_names;
+            for (std::size_t col = 0; col < column_count; ++col)
+            {
+                const auto& name = m_colname_vec[col];
+                if (col == m_index_column)
+                {
+                    m_slot_vec.push_back({slot_kind::index, 0});
+                    continue;
+                }
+                auto type_it = m_options.column_types.find(name);
+                csv_column_type type = is_number[col] ? csv_column_type::number : csv_column_type::string;
+                if (type_it != m_options.column_types.end())
+                    type = type_it->second;
+                if (type == csv_column_type::number && !is_number[col])
+                    throw std::runtime_error("csv column " + name + " is not numeric");
+                if (type == csv_column_type::number)
+                {
+                    m_slot_vec.push_back({slot_kind::number, number_names.size()});
+                    number_names.push_back(fstring(name));
+                }
+                else
+                {
+                    m_slot_vec.push_back({slot_kind::string, string_names.size()});
+                    string_names.push_back(fstring(name));
+                }
+            }
+
+            xt::xarray<double> numbers(std::vector<std::size_t>({number_names.size(), m_row_count}));
+            xt::xarray<bool> number_mask(std::vector<std::size_t>({number_names.size(), m_row_count}));
+            xt::xarray<std::string> strings(std::vector<std::size_t>({string_names.size(), m_row_count}));
+            xt::xarray<bool> string_mask(std::vector<std::size_t>({string_names.size(), m_row_count}));
+            const bool has_index = m_index_column < column_count;
+            m_integer_index = has_index && is_integer_index;
+            std::vector<int> int_labels(m_integer_index ? m_row_count : 0);
+            std::vector<std::string> string_labels(has_index && !m_integer_index ? m_row_count : 0);
+            run(chunks, [&](xcsv_chunk& chunk)
+            {
+                decode_chunk(chunk, numbers.data(), number_mask.data(), strings.data(), string_mask.data(), int_labels, string_labels);
+            });
+
+            using axis_type = typename csv_coordinate_type::axis_type;
+            axis_type row_axis = xaxis_default<std::size_t, std::size_t>(m_row_count);
+            if (m_integer_index)
+            {
+                if (has_duplicate_labels(int_labels))
+                    throw std::runtime_error("duplicate labels in csv index column");
+                row_axis = xaxis<int, std::size_t>(std::move(int_labels));
+            }
+            else if (has_index)
+            {
+                if (has_duplicate_labels(string_labels))
+                    throw std::runtime_error("duplicate labels in csv index column");
+                std::vector<fstring> labels;
+                labels.reserve(string_labels.size());
+                for (const auto& label : string_labels)
+                    labels.push_back(fstring(label));
+                row_axis = xaxis<fstring, std::size_t>(std::move(labels));
+            }
+
+            using number_data_type = csv_number_variable::data_type;
+            using string_data_type = csv_string_variable::data_type;
+            csv_dimension_type dims({"column", "row"});
+            csv_dataset res;
+            res.numbers = csv_number_variable(
+                number_data_type(std::move(numbers), std::move(number_mask)),
+                coordinate<fstring>({{fstring("column"), axis_type(xaxis<fstring, std::size_t>(std::move(number_names)))},
+                                     {fstring("row"), row_axis}}),
+                dims);
+            res.strings = csv_string_variable(
+                string_data_type(std::move(strings), std::move(string_mask)),
+                coordinate<fstring>({{fstring("column"), axis_type(xaxis<fstring, std::size_t>(std::move(string_names)))},
+                                     {fstring("row"), std::move(row_axis)}}),
+                dims);
+            return res;
+        }
+    }
+
+    /**
+     * Reads the content of a delimited stream.
+     * @param is the input stream.
+     * @param options the reading options.
+     * @return the numeric and text columns of the stream.
+     */
+    inline csv_dataset read_csv(std::istream& is, const csv_read_options& options)
+    {
+        std::vector<char> buffer((std::istreambuf_iterator<char>(is)), std::istreambuf_iterator<char>());
+        detail::xcsv_parser parser(buffer.data(), buffer.size(), options);
+        return parser.parse();
+    }
+
+    /**
+     * Reads the content of a delimited file. The file is memory-mapped when
+     * possible, and its rows are tokenised by options.thread_count threads.
+     * @param filename the name of the file.
+     * @param options the reading options.
+     * @return the numeric and text columns of the file.
+     */
+    inline csv_dataset read_csv(const std::string& filename, const csv_read_options& options)
+    {
+        detail::xmapped_file mapping(filename);
+        if (mapping.is_open())
+        {
+            detail::xcsv_parser parser(mapping.data(), mapping.size(), options);
+            return parser.parse();
+        }
+        std::ifstream in(filename, std::ios::binary);
+        if (!in)
+            throw std::runtime_error("cannot open file " + filename);
+        return read_csv(in, options);
+    }
+}
+
+#endif
@@ -0,0 +1,169 @@
+/***************************************************************************
+* Copyright (c) Johan Mabille, Sylvain Corlay, Wolf Vollprecht and         *
+* Martin Renou                                                             *
+* Copyright (c) QuantStack                                                 *
+*                                                                          *
+* Distributed under the terms of the BSD 3-Clause License.                 *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#ifndef XFRAME_IO_MMAP_HPP
+#define XFRAME_IO_MMAP_HPP
+
+#include <cstddef>
+#include <string>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define XFRAME_HAS_MMAP 1
+#else
+#define XFRAME_HAS_MMAP 0
+#endif
+
+namespace xf
+{
+    namespace detail
+    {
+        /****************
+         * xmapped_file *
+         ****************/
+
+        /**
+         * @class xmapped_file
+         * @brief Read-only memory mapping of a whole file.
+         *
+         * The mapping starts at a page boundary and stays valid for the
+         * lifetime of the object. On systems without mmap, or when the
+         * file cannot be mapped, is_open returns false and the caller is
+         * expected to fall back to stream reads.
+         *
+         * A copy-on-write mapping is also writable: modified pages are
+         * copied in memory and never written back to the file.
+         */
+        class xmapped_file
+        {
+        public:
+
+            xmapped_file() = default;
+            explicit xmapped_file(const std::string& filename, bool sequential = false, bool copy_on_write = false);
+            ~xmapped_file();
+
+            xmapped_file(const xmapped_file&) = delete;
+            xmapped_file& operator=(const xmapped_file&) = delete;
+
+            xmapped_file(xmapped_file&& rhs) noexcept;
+            xmapped_file& operator=(xmapped_file&& rhs) noexcept;
+
+            bool is_open() const noexcept;
+            const char* data() const noexcept;
+            std::size_t size() const noexcept;
+
+        private:
+
+            void close() noexcept;
+
+            const char* p_data = nullptr;
+            std::size_t m_size = 0;
+        };
+
+        /*******************************
+         * xmapped_file implementation *
+         *******************************/
+
+        /**
+         * Maps the specified file.
+         * @param filename the name of the file.
+         * @param sequential if true, the kernel is advised that the file
+         *        is read sequentially, so that it reads ahead aggressively
+         *        and drops the pages that have been read.
+         * @param copy_on_write if true, the mapping is writable and private.
+         */
+        inline xmapped_file::xmapped_file(const std::string& filename, bool sequential, bool copy_on_write)
+        {
+#if XFRAME_HAS_MMAP
+            int fd = ::open(filename.c_str(), O_RDONLY);
+            if (fd == -1)
+            {
+                return;
+            }
+            struct stat st;
+            if (::fstat(fd, &st) == 0 && st.st_size > 0)
+            {
+                const int protection = copy_on_write ? PROT_READ | PROT_WRITE : PROT_READ;
+                void* addr = ::mmap(nullptr, static_cast<std::size_t>(st.st_size), protection, MAP_PRIVATE, fd, 0);
+                if (addr != MAP_FAILED)
+                {
+                    p_data = static_cast<const char*>(addr);
+                    m_size = static_cast<std::size_t>(st.st_size);
+                    if (sequential)
+                    {
+                        ::madvise(addr, m_size, MADV_SEQUENTIAL);
+                    }
+                }
+            }
+            ::close(fd);
+#else
+            (void)filename;
+            (void)sequential;
+            (void)copy_on_write;
+#endif
+        }
+
+        inline xmapped_file::~xmapped_file()
+        {
+            close();
+        }
+
+        inline xmapped_file::xmapped_file(xmapped_file&& rhs) noexcept
+            : p_data(rhs.p_data), m_size(rhs.m_size)
+        {
+            rhs.p_data = nullptr;
+            rhs.m_size = 0;
+        }
+
+        inline xmapped_file& xmapped_file::operator=(xmapped_file&& rhs) noexcept
+        {
+            if (this != &rhs)
+            {
+                close();
+                std::swap(p_data, rhs.p_data);
+                std::swap(m_size, rhs.m_size);
+            }
+            return *this;
+        }
+
+        inline bool xmapped_file::is_open() const noexcept
+        {
+            return p_data != nullptr;
+        }
+
+        inline const char* xmapped_file::data() const noexcept
+        {
+            return p_data;
+        }
+
+        inline std::size_t xmapped_file::size() const noexcept
+        {
+            return m_size;
+        }
+
+        inline void xmapped_file::close() noexcept
+        {
+#if XFRAME_HAS_MMAP
+            if (p_data != nullptr)
+            {
+                ::munmap(const_cast<char*>(p_data), m_size);
+            }
+#endif
+            p_data = nullptr;
+            m_size = 0;
+        }
+    }
+}
+
+#endif
@@ -11,11 +11,24 @@
 #ifndef XFRAME_IO_SAS_HPP
 #define XFRAME_IO_SAS_HPP
 
-#include <string>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <exception>
 #include <fstream>
+#include <initializer_list>
+#include <istream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
-#include <xtl/xany.hpp>
+#include "xtensor/xbuilder.hpp"
 
+#include "xio_mmap.hpp"
 #include "xvariable.hpp"
 
 namespace xf
@@ -25,29 +38,304 @@ namespace xf
         sas7bdat,
         xport
     };
-//    inline xf::xvariable<xtl::any, xf::xcoordinate<xf::fstring>> read_sas(const std::ifstream& ifs, const sas_format& format = sas_format::sas7bdata);
-    void read_sas(const std::ifstream& ifs, const sas_format& format = sas_format::sas7bdat);
+
+    using sas_coordinate_type = xcoordinate<fstring>;
+    using sas_dimension_type = xdimension<fstring, std::size_t>;
+    using sas_number_variable = xvariable<double, sas_coordinate_type>;
+    using sas_string_variable = xvariable<std::string, sas_coordinate_type>;
+    using sas_code_variable = xvariable<int, sas_coordinate_type>;
+
+    /**
+     * @class sas_dataset
+     * @brief Columns read from a SAS file.
+     *
+     * Numeric and character columns are stored in two variables with
+     * dimensions { "column", "row" }. The "column" axis holds the SAS
+     * column names, the "row" axis is a default axis. Since the data
+     * is row-major, each column is a contiguous buffer.
+     *
+     * When requested, missing_codes has the shape of numbers and holds
+     * the kind of each missing value: '.', '_' or 'A' to 'Z', and '\0'
+     * for values that are not missing.
+     *
+     * When character columns are dictionary-encoded, strings is empty and
+     * string_codes holds, for each cell, the index of its value in
+     * string_dictionary. The dictionary is shared by all the character
+     * columns, values are stored in the order they are first met. The
+     * codes can be used as labels of an xaxis<int>.
+     */
+    struct sas_dataset
+    {
+        sas_number_variable numbers;
+        sas_string_variable strings;
+        xt::xarray<char> missing_codes;
+        sas_code_variable string_codes;
+        std::vector<std::string> string_dictionary;
+    };
+
+    /**
+     * @class sas_read_options
+     * @brief Options for reading a SAS file.
+     */
+    struct sas_read_options
+    {
+        /**
+         * Number of threads decoding the pages, 0 means one per core.
+         * Only memory-mapped sas7bdat files are decoded in parallel,
+         * streams and transport files are decoded on the calling thread.
+         */
+        std::size_t thread_count = 1;
+
+        /**
+         * Names of the columns to read, in the order of the result. If both
+         * columns and column_indices are empty, all the columns are read.
+         */
+        std::vector<std::string> columns;
+
+        /**
+         * Positions in the file of the columns to read, in the order of the
+         * result. Cannot be combined with columns.
+         */
+        std::vector<std::size_t> column_indices;
+
+        /**
+         * Rows [row_start, row_stop) are read; row_stop is clamped to the
+         * number of rows of the file. Pages outside of this range are not
+         * decoded.
+         */
+        std::size_t row_start = 0;
+        std::size_t row_stop = std::numeric_limits<std::size_t>::max();
+
+        /**
+         * If true, the kind of the missing numbers (.A to .Z, ._ or .)
+         * is stored in sas_dataset::missing_codes.
+         */
+        bool missing_codes = false;
+
+        /**
+         * If true, character columns are dictionary-encoded into
+         * sas_dataset::string_codes and sas_dataset::string_dictionary.
+         */
+        bool string_dictionary = false;
+    };
+
+    /**
+     * Type of a column of a SAS file.
+     */
+    enum class sas_column_type
+    {
+        number,
+        string
+    };
+
+    /**
+     * @class sas_schema
+     * @brief Description of the columns of a SAS file.
+     *
+     * The vectors have one element per column, in the order of the file.
+     * Columns without a format or a label have an empty one.
+     */
+    struct sas_schema
+    {
+        std::vector<std::string> names;
+        std::vector<std::string> formats;
+        std::vector<std::string> labels;
+        std::vector<sas_column_type> types;
+        std::size_t row_count = 0;
+    };
+
+    sas_dataset read_sas(std::istream& is, const sas_format& format = sas_format::sas7bdat,
+                         const sas_read_options& options = sas_read_options());
+    sas_dataset read_sas(const std::string& filename, const sas_format& format = sas_format::sas7bdat,
+                         const sas_read_options& options = sas_read_options());
+
+    sas_schema read_sas_schema(std::istream& is, const sas_format& format = sas_format::sas7bdat);
+    sas_schema read_sas_schema(const std::string& filename, const sas_format& format = sas_format::sas7bdat);
 
     namespace detail
     {
+        /**************
+         * xsas_input *
+         **************/
+
+        /**
+         * @class xsas_input
+         * @brief Read-only access to the bytes of a SAS file.
+         *
+         * When built from a file name, the file is memory-mapped and read
+         * returns pointers into the mapping, valid for the lifetime of the
+         * object; nothing is copied. When built from a stream, or when the
+         * file cannot be mapped, read fills an internal buffer which is
+         * reused, the returned pointer is valid until the next call.
+         */
+        class xsas_input
+        {
+        public:
+
+            explicit xsas_input(std::istream& is);
+            explicit xsas_input(const std::string& filename);
+
+            xsas_input(const xsas_input&) = delete;
+            xsas_input& operator=(const xsas_input&) = delete;
+
+            bool mapped() const noexcept;
+            uint64_t size();
+            const char* read(uint64_t offset, uint64_t length);
+
+        private:
+
+            xmapped_file m_mapping;
+            std::ifstream m_file;
+            std::istream* p_stream;
+            std::vector<char> m_buffer;
+        };
+
+        /*******************
+         * xsas_dictionary *
+         *******************/
+
+        /**
+         * @class xsas_dictionary
+         * @brief Interning of the values of character columns.
+         *
+         * Each distinct value, without its trailing blanks, is given the
+         * next integer code the first time it is inserted.
+         */
+        class xsas_dictionary
+        {
+        public:
+
+            xsas_dictionary() = default;
+            xsas_dictionary(const xsas_dictionary&) = delete;
+            xsas_dictionary& operator=(const xsas_dictionary&) = delete;
+            xsas_dictionary(xsas_dictionary&&) = default;
+            xsas_dictionary& operator=(xsas_dictionary&&) = default;
+
+            int insert(const char* data, std::size_t length);
+            std::size_t size() const noexcept;
+            const std::string& operator[](std::size_t code) const;
+            std::vector<std::string> values() const;
+            std::vector<int> merge(const xsas_dictionary& rhs);
+
+        private:
+
+            std::unordered_map<std::string, int> m_index;
+            // the keys of m_index, by code; nodes are never moved
+            std::vector<const std::string*> m_values;
+            std::string m_key;
+        };
+
+        /**
+         * Destination of decoded rows. Each buffer holds its columns one after
+         * the other. missing_codes is null when the codes are not requested;
+         * character columns are either assigned to strings, or interned in
+         * dictionary and their codes written to string_codes.
+         */
+        struct xsas_buffers
+        {
+            double* numbers;
+            bool* number_mask;
+            char* missing_codes;
+            std::string* strings;
+            int* string_codes;
+            xsas_dictionary* dictionary;
+        };
+
+        /**
+         * Decoded columns, before they are wrapped into a sas_dataset.
+         */
+        struct xsas_columns
+        {
+            xsas_columns(std::size_t number_count, std::size_t string_count, std::size_t row_count, const sas_read_options& options);
+            xsas_buffers buffers();
+
+            xt::xarray<double> numbers;
+            xt::xarray<bool> number_mask;
+            xt::xarray<char> missing_codes;
+            xt::xarray<std::string> strings;
+            xt::xarray<int> string_codes;
+            xsas_dictionary dictionary;
+            bool has_missing_codes;
+            bool has_dictionary;
+        };
+
+        /**
+         * Commands of the SAS run-length encoding, stored in the high
+         * nibble of the control byte.
+         */
+        enum class xsas_rle_command : uint8_t
+        {
+            copy64 = 0,
+            unknown1 = 1,
+            unknown2 = 2,
+            unknown3 = 3,
+            insert_byte18 = 4,
+            insert_at17 = 5,
+            insert_blank17 = 6,
+            insert_zero17 = 7,
+            copy1 = 8,
+            copy17 = 9,
+            copy33 = 10,
+            copy49 = 11,
+            insert_byte3 = 12,
+            insert_at2 = 13,
+            insert_blank2 = 14,
+            insert_zero2 = 15
+        };
+
+        /**
+         * Commands of the Ross Data Compression, stored in the high nibble
+         * of their first byte; commands 3 to 15 are short patterns of that
+         * many bytes.
+         */
+        enum class xsas_rdc_command : uint8_t
+        {
+            short_rle = 0,
+            long_rle = 1,
+            long_pattern = 2
+        };
+
+        std::vector<std::size_t> select_sas_columns(const std::vector<std::string>& names, const sas_read_options& options);
+        void assign_sas_string(std::string& str, const char* data, std::size_t length);
+        void decode_sas_numbers(const char* data, std::size_t stride, std::size_t count, std::size_t length,
+                                bool little_endian, bool swap, double* values, bool* mask, char* missing_codes);
+        void decode_sas_strings(const char* data, std::size_t stride, std::size_t count, std::size_t length,
+                                const xsas_buffers& buffers, std::size_t start);
+        sas_dataset make_sas_dataset(xsas_columns&& columns, xaxis<fstring>&& number_axis, xaxis<fstring>&& string_axis);
+        void decompress_sas_rle(const char* input, uint64_t input_length, char* output, uint64_t output_length);
+        void decompress_sas_rdc(const char* input, uint64_t input_length, char* output, uint64_t output_length);
+
+        /********************
+         * xsas7bdat_parser *
+         ********************/
+
         class xsas7bdat_parser
         {
         public:
-            explicit xsas7bdat_parser(std::ifstream& ifs);
+            explicit xsas7bdat_parser(xsas_input& input);
 
             xsas7bdat_parser(xsas7bdat_parser&) = delete;
             xsas7bdat_parser(xsas7bdat_parser&&) = delete;
             xsas7bdat_parser& operator=(const xsas7bdat_parser&) = delete;
             xsas7bdat_parser& operator=(xsas7bdat_parser&&) = delete;
             void parse_meta();
-            void parse_data();
+            sas_dataset parse_data(const sas_read_options& options = sas_read_options());
+            sas_schema schema() const;
+
+            void select(const sas_read_options& options);
+            uint64_t row_begin() const noexcept;
+            uint64_t row_end() const noexcept;
+            xaxis<fstring> number_axis() const;
+            xaxis<fstring> string_axis() const;
+            void decode_rows(uint64_t row_begin, uint64_t row_end, uint64_t& page, uint64_t& page_first_row,
+                             const xsas_buffers& buffers);
 
         private:
             using memory_data_type = std::vector<char>;
-            using memory_data_iterator = std::vector<char>::iterator;
-            using difference_type = typename memory_data_type::difference_type;
-            using size_type = memory_data_type::size_type;
-            using value_type = memory_data_type::value_type;
+            using memory_data_iterator = const char*;
+            using difference_type = std::ptrdiff_t;
+            using size_type = std::size_t;
+            using value_type = char;
 
             enum class endian : uint8_t
             {
@@ -104,47 +392,56 @@ namespace xf
                 rle = 0x04
             };
 
-            enum class rle_command : uint8_t
-            {
-                copy64 = 0,
-                unknown1 = 1,
-                unknown2 = 2,
-                unknown3 = 3,
-                insert_byte18 = 4,
-                insert_at17 = 5,
-                insert_blank17 = 6,
-                insert_zero17 = 7,
-                copy1 = 8,
-                copy17 = 9,
-                copy33 = 10,
-                copy49 = 11,
-                insert_byte3 = 12,
-                insert_at2 = 13,
-                insert_blank2 = 14,
-                insert_zero2 = 15
+            enum class compression_method : uint8_t
+            {
+                none,
+                rle,
+                rdc
+            };
+
+            enum : uint8_t
+            {
+                data_subheader_type = 0x01
             };
 
-#pragma pack(push, 1)
+            // data points into the input; it is backed by storage
+            // only when the input is not memory-mapped
             struct subheader
             {
-                memory_data_type data;
+                const char* data;
+                uint64_t length;
                 uint64_t signature;
                 uint8_t compression;
+                memory_data_type storage;
+            };
+
+            struct subheader_pointer
+            {
+                uint64_t offset;
+                uint64_t length;
+                uint8_t compression;
+                uint8_t type;
+            };
+
+            // a column to decode and its position in the numeric or the string buffer
+            struct column_slot
+            {
+                uint64_t offset;
+                uint64_t length;
+                column_type type;
+                std::size_t index;
             };
-#pragma pack(pop)
 
             bool little_endian();
 
             template <typename T>
             auto swap_endian(const T&) -> T;
             
-            memory_data_type load_data(std::ifstream& ifs, uint64_t length);
-
             template <typename T>
-            auto read_memory_data(memory_data_type memory_data, uint64_t pos, bool swap) -> T;
+            auto read_memory_data(const char* memory_data, uint64_t pos, bool swap) -> T;
 
             template <typename Container>
-            auto read_memory_data(memory_data_type memory_data, uint64_t pos, uint64_t length) -> Container;
+            auto read_memory_data(const char* memory_data, uint64_t pos, uint64_t length) -> Container;
 
             template <typename T>
             auto iterator_memory_data(memory_data_iterator& memory_data_it, bool swap) -> T;
@@ -153,24 +450,452 @@ namespace xf
             auto iterator_memory_data(memory_data_iterator& memory_data_it, uint64_t length) -> Container;
 
             void parse_head();
-            std::vector<subheader> parse_page_subheader(memory_data_type& page_memory);
+            uint16_t read_page_type(const char* page_memory);
+            std::vector<subheader_pointer> parse_page_subheader_pointer(const char* page_memory);
+            bool is_data_subheader(const subheader_pointer& pointer) const;
+            std::vector<subheader> parse_page_subheader(const char* page_memory);
+            void parse_rowsize_subheader(std::vector<subheader>& rowsize_subheader_vec);
+            void parse_coltext_subheader(std::vector<subheader>& coltext_subheader_vec);
             void parse_colname_subheader(std::vector<subheader>& colname_subheader_vec, std::vector<subheader>& coltext_subheader_vec);
             void parse_collabel_subheader(std::vector<subheader>& collabel_subheader_vec, std::vector<subheader>& coltext_subheader_vec);
             void parse_colattr_subheader(std::vector<subheader>& colattr_subheader_vec);
+            uint64_t colname_subheader_count(const subheader& colname_subheader) const;
+            uint64_t colattr_subheader_count(const subheader& colattr_subheader) const;
+            bool has_column_text(const std::vector<subheader>& colname_subheader_vec, const std::vector<subheader>& collabel_subheader_vec,
+                                 std::size_t coltext_count);
+
+            void init_column_index(const sas_read_options& options);
+            xaxis<fstring> column_axis(column_type type) const;
+            uint64_t page_row_count(const char* page_memory, uint64_t remaining_row_count);
+            void decode_pages(uint64_t& page, uint64_t last_page, uint64_t& page_first_row,
+                              const xsas_buffers& buffers);
+            void decode_pages_parallel(std::size_t thread_count, const xsas_buffers& buffers);
+            const char* decompress_row(const char* data, uint64_t length, char* buffer) const;
+            void parse_rows(const char* rows, uint64_t row_count, uint64_t row_index, const xsas_buffers& buffers);
 
-            std::ifstream& m_sas_ifs;
+            xsas_input& m_input;
             bool m_64bit {false};
             bool m_swap_endian {false};
+            bool m_little_endian {true};
+            compression_method m_compression {compression_method::none};
             uint64_t m_page_count {0};
             uint64_t m_header_size {0};
             uint64_t m_page_size {0};
+            uint64_t m_row_length {0};
+            uint64_t m_row_count {0};
+            uint64_t m_mix_page_row_count {0};
+            std::vector<std::string> m_colname_vec;
+            std::vector<std::string> m_colfmt_vec;
+            std::vector<std::string> m_collabel_vec;
+            std::vector<column_type> m_coltype_vec;
+            std::vector<uint64_t> m_coloffset_vec;
+            std::vector<uint64_t> m_collength_vec;
+            // selected columns, as positions in the file, and how to decode them
+            std::vector<std::size_t> m_colselect_vec;
+            std::vector<column_slot> m_colslot_vec;
+            std::size_t m_number_column_count {0};
+            std::size_t m_string_column_count {0};
+            // selected rows
+            uint64_t m_row_begin {0};
+            uint64_t m_row_end {0};
+        };
+
+        /*****************
+         * xxport_parser *
+         *****************/
+
+        void ibm_to_ieee(const uint64_t* ibm, std::size_t size, double* ieee, bool* mask, char* missing_codes);
+
+        /**
+         * @class xxport_parser
+         * @brief Parser of SAS transport files, versions 5 and 8.
+         *
+         * Transport files are made of 80-byte records. The description of
+         * the variables is followed by the observations, which are packed
+         * one after the other; numbers are IBM 370 floating-point numbers.
+         * Only the first member of a library is read.
+         */
+        class xxport_parser
+        {
+        public:
+
+            explicit xxport_parser(xsas_input& input);
+
+            xxport_parser(const xxport_parser&) = delete;
+            xxport_parser& operator=(const xxport_parser&) = delete;
+
+            void parse_meta();
+            sas_dataset parse_data(const sas_read_options& options = sas_read_options());
+            sas_schema schema() const;
+
+        private:
+
+            enum class column_type : uint16_t
+            {
+                column_type_number = 0x01,
+                column_type_char = 0x02
+            };
+
+            enum : uint64_t
+            {
+                record_length = 80,
+                // rows decoded at once, column by column
+                chunk_length = 1 << 20
+            };
+
+            bool is_header(const char* record, const char* name) const;
+            uint64_t find_header(uint64_t offset, std::initializer_list<const char*> names);
+            void parse_namestr(const char* namestr);
+            void parse_labels(const char* labels, uint64_t length, bool v9);
+            uint64_t trailing_blank_rows(uint64_t data_length);
+
+            xsas_input& m_input;
+            bool m_v8 {false};
+            uint64_t m_namestr_length {0};
+            uint64_t m_data_offset {0};
+            uint64_t m_row_length {0};
+            uint64_t m_row_count {0};
             std::vector<std::string> m_colname_vec;
             std::vector<std::string> m_colfmt_vec;
             std::vector<std::string> m_collabel_vec;
             std::vector<column_type> m_coltype_vec;
+            std::vector<uint64_t> m_coloffset_vec;
+            std::vector<uint64_t> m_collength_vec;
         };
 
-        xsas7bdat_parser::xsas7bdat_parser(std::ifstream& ifs) : m_sas_ifs(ifs)
+        /*****************************
+         * xsas_input implementation *
+         *****************************/
+
+        inline xsas_input::xsas_input(std::istream& is)
+            : m_mapping(), m_file(), p_stream(&is), m_buffer()
+        {
+        }
+
+        inline xsas_input::xsas_input(const std::string& filename)
+            : m_mapping(filename, true), m_file(), p_stream(nullptr), m_buffer()
+        {
+            if (!m_mapping.is_open())
+            {
+                m_file.open(filename, std::ios::in | std::ios::binary);
+                if (!m_file)
+                    throw std::runtime_error("cannot open sas file " + filename);
+                p_stream = &m_file;
+            }
+        }
+
+        inline bool xsas_input::mapped() const noexcept
+        {
+            return m_mapping.is_open();
+        }
+
+        inline uint64_t xsas_input::size()
+        {
+            if (mapped())
+                return m_mapping.size();
+            p_stream->clear();
+            if (!p_stream->seekg(0, std::ios::end))
+                throw std::runtime_error("cannot seek in the sas file");
+            return static_cast<uint64_t>(p_stream->tellg());
+        }
+
+        inline const char* xsas_input::read(uint64_t offset, uint64_t length)
+        {
+            if (mapped())
+            {
+                if (offset + length > m_mapping.size())
+                    throw std::runtime_error("read past the end of the sas file");
+                return m_mapping.data() + offset;
+            }
+            if (m_buffer.size() < length)
+                m_buffer.resize(static_cast<std::size_t>(length));
+            if (!p_stream->seekg(static_cast<std::streamoff>(offset), std::ios::beg)
+                || !p_stream->read(m_buffer.data(), static_cast<std::streamsize>(length)))
+                throw std::runtime_error("read past the end of the sas file");
+            return m_buffer.data();
+        }
+
+        /**
+         * Returns the positions of the columns selected in options, in
+         * the order of the result.
+         * @param names the names of the columns of the file.
+         * @param options the reading options.
+         */
+        inline std::vector<std::size_t> select_sas_columns(const std::vector<std::string>& names, const sas_read_options& options)
+        {
+            if (!options.columns.empty() && !options.column_indices.empty())
+                throw std::runtime_error("sas columns must be selected either by name or by index");
+            std::vector<std::size_t> res;
+            if (!options.columns.empty())
+            {
+                for (const auto& name : options.columns)
+                {
+                    auto it = std::find(names.cbegin(), names.cend(), name);
+                    if (it == names.cend())
+                        throw std::runtime_error("unknown sas column " + name);
+                    res.push_back(static_cast<std::size_t>(it - names.cbegin()));
+                }
+            }
+            else if (!options.column_indices.empty())
+            {
+                for (auto col : options.column_indices)
+                {
+                    if (col >= names.size())
+                        throw std::runtime_error("sas column index out of range");
+                    res.push_back(col);
+                }
+            }
+            else
+            {
+                for (std::size_t col = 0; col < names.size(); ++col)
+                    res.push_back(col);
+            }
+
+            std::vector<bool> selected(names.size(), false);
+            for (auto col : res)
+            {
+                if (selected[col])
+                    throw std::runtime_error("sas column " + names[col] + " selected twice");
+                selected[col] = true;
+            }
+            return res;
+        }
+
+        /**
+         * Assigns a character field to str, without its trailing blanks.
+         * The capacity of str is reused.
+         */
+        inline void assign_sas_string(std::string& str, const char* data, std::size_t length)
+        {
+            while (length != 0 && (data[length - 1] == ' ' || data[length - 1] == '\0'))
+                --length;
+            str.assign(data, length);
+        }
+
+        inline uint64_t byte_swap(uint64_t value) noexcept
+        {
+            value = ((value & 0x00000000FFFFFFFFull) << 32) | (value >> 32);
+            value = ((value & 0x0000FFFF0000FFFFull) << 16) | ((value & 0xFFFF0000FFFF0000ull) >> 16);
+            value = ((value & 0x00FF00FF00FF00FFull) << 8) | ((value & 0xFF00FF00FF00FF00ull) >> 8);
+            return value;
+        }
+
+        template <std::size_t N, bool Swap, bool Codes>
+        inline void decode_sas_numbers_impl(const char* data, std::size_t stride, std::size_t count, std::size_t position,
+                                            double* values, bool* mask, char* missing_codes)
+        {
+            for (std::size_t i = 0; i < count; ++i, data += stride)
+            {
+                uint64_t bits = 0;
+                std::memcpy(reinterpret_cast<char*>(&bits) + position, data, N);
+                if (Swap)
+                    bits = byte_swap(bits);
+                const bool missing = (bits & 0x7FF0000000000000ull) == 0x7FF0000000000000ull
+                                  && (bits & 0x000FFFFFFFFFFFFFull) != 0;
+                std::memcpy(values + i, &bits, sizeof(double));
+                mask[i] = !missing;
+                if (Codes)
+                {
+                    // the complemented code is in bits 40 to 47, the third most
+                    // significant byte, which survives truncation to 3 bytes
+                    const uint64_t tag = ~(bits >> 40) & 0xFF;
+                    const char code = tag == 0 ? '_' : (tag >= 2 && tag <= 27 ? static_cast<char>('A' + tag - 2) : '.');
+                    missing_codes[i] = missing ? code : '\0';
+                }
+            }
+        }
+
+        template <std::size_t N>
+        inline void decode_sas_numbers_length(const char* data, std::size_t stride, std::size_t count, bool little_endian,
+                                              bool swap, double* values, bool* mask, char* missing_codes)
+        {
+            // the truncated bytes are the most significant ones
+            const std::size_t position = little_endian ? sizeof(double) - N : 0;
+            if (swap)
+            {
+                if (missing_codes == nullptr)
+                    decode_sas_numbers_impl<N, true, false>(data, stride, count, position, values, mask, missing_codes);
+                else
+                    decode_sas_numbers_impl<N, true, true>(data, stride, count, position, values, mask, missing_codes);
+            }
+            else
+            {
+                if (missing_codes == nullptr)
+                    decode_sas_numbers_impl<N, false, false>(data, stride, count, position, values, mask, missing_codes);
+                else
+                    decode_sas_numbers_impl<N, false, true>(data, stride, count, position, values, mask, missing_codes);
+            }
+        }
+
+        /**
+         * Decodes a column of count SAS numbers, stored stride bytes apart and
+         * truncated to their length most significant bytes. The values and the
+         * mask are written in the same pass. The loop is specialized for the
+         * length, the byte order and the missing value codes, so that it has no
+         * branch and reads a fixed number of bytes.
+         * @param little_endian true if the file is little-endian.
+         * @param swap true if the byte order of the file is not the native one.
+         * @param missing_codes the codes of the missing values, may be null.
+         */
+        inline void decode_sas_numbers(const char* data, std::size_t stride, std::size_t count, std::size_t length,
+                                       bool little_endian, bool swap, double* values, bool* mask, char* missing_codes)
+        {
+            switch (length)
+            {
+            case 1: decode_sas_numbers_length<1>(data, stride, count, little_endian, swap, values, mask, missing_codes); break;
+            case 2: decode_sas_numbers_length<2>(data, stride, count, little_endian, swap, values, mask, missing_codes); break;
+            case 3: decode_sas_numbers_length<3>(data, stride, count, little_endian, swap, values, mask, missing_codes); break;
+            case 4: decode_sas_numbers_length<4>(data, stride, count, little_endian, swap, values, mask, missing_codes); break;
+            case 5: decode_sas_numbers_length<5>(data, stride, count, little_endian, swap, values, mask, missing_codes); break;
+            case 6: decode_sas_numbers_length<6>(data, stride, count, little_endian, swap, values, mask, missing_codes); break;
+            case 7: decode_sas_numbers_length<7>(data, stride, count, little_endian, swap, values, mask, missing_codes); break;
+            case 8: decode_sas_numbers_length<8>(data, stride, count, little_endian, swap, values, mask, missing_codes); break;
+            default: throw std::runtime_error("invalid sas numeric column length");
+            }
+        }
+
+        /**
+         * Decodes a character column of count fields, stored stride bytes apart,
+         * starting at the position start of the buffers.
+         */
+        inline void decode_sas_strings(const char* data, std::size_t stride, std::size_t count, std::size_t length,
+                                       const xsas_buffers& buffers, std::size_t start)
+        {
+            if (buffers.dictionary != nullptr)
+            {
+                int* codes = buffers.string_codes + start;
+                for (std::size_t row = 0; row < count; ++row, data += stride)
+                    codes[row] = buffers.dictionary->insert(data, length);
+            }
+            else
+            {
+                std::string* strings = buffers.strings + start;
+                for (std::size_t row = 0; row < count; ++row, data += stride)
+                    assign_sas_string(strings[row], data, length);
+            }
+        }
+
+        /**
+         * Builds the dataset returned by read_sas from the decoded columns.
+         */
+        inline sas_dataset make_sas_dataset(xsas_columns&& columns, xaxis<fstring>&& number_axis, xaxis<fstring>&& string_axis)
+        {
+            using number_data_type = sas_number_variable::data_type;
+            using string_data_type = sas_string_variable::data_type;
+            using code_data_type = sas_code_variable::data_type;
+
+            const std::size_t row_count = columns.numbers.shape()[1];
+            sas_dimension_type dims({"column", "row"});
+            sas_dataset res;
+            res.numbers = sas_number_variable(
+                number_data_type(std::move(columns.numbers), std::move(columns.number_mask)),
+                coordinate<fstring>({{fstring("column"), std::move(number_axis)},
+                                     {fstring("row"), xaxis_default<std::size_t>(row_count)}}),
+                dims);
+            auto string_coordinate = coordinate<fstring>({{fstring("column"), std::move(string_axis)},
+                                                          {fstring("row"), xaxis_default<std::size_t>(row_count)}});
+            if (columns.has_dictionary)
+            {
+                xt::xarray<bool> code_mask = xt::ones<bool>(columns.string_codes.shape());
+                res.string_codes = sas_code_variable(code_data_type(std::move(columns.string_codes), std::move(code_mask)),
+                                                     std::move(string_coordinate), dims);
+                res.string_dictionary = columns.dictionary.values();
+            }
+            else
+            {
+                xt::xarray<bool> string_mask = xt::ones<bool>(columns.strings.shape());
+                res.strings = sas_string_variable(string_data_type(std::move(columns.strings), std::move(string_mask)),
+                                                  std::move(string_coordinate), dims);
+            }
+            res.missing_codes = std::move(columns.missing_codes);
+            return res;
+        }
+
+        /**********************************
+         * xsas_dictionary implementation *
+         **********************************/
+
+        /**
+         * Returns the code of a character field, without its trailing blanks.
+         */
+        inline int xsas_dictionary::insert(const char* data, std::size_t length)
+        {
+            assign_sas_string(m_key, data, length);
+            auto it = m_index.find(m_key);
+            if (it != m_index.end())
+                return it->second;
+            if (m_values.size() == static_cast<std::size_t>(std::numeric_limits<int>::max()))
+                throw std::runtime_error("too many distinct sas strings");
+            const int code = static_cast<int>(m_values.size());
+            it = m_index.emplace(m_key, code).first;
+            m_values.push_back(&(it->first));
+            return code;
+        }
+
+        inline std::size_t xsas_dictionary::size() const noexcept
+        {
+            return m_values.size();
+        }
+
+        inline const std::string& xsas_dictionary::operator[](std::size_t code) const
+        {
+            return *m_values[code];
+        }
+
+        inline std::vector<std::string> xsas_dictionary::values() const
+        {
+            std::vector<std::string> res;
+            res.reserve(m_values.size());
+            for (auto value : m_values)
+                res.push_back(*value);
+            return res;
+        }
+
+        /**
+         * Inserts the values of rhs, in their order, and returns the new
+         * code of each code of rhs.
+         */
+        inline std::vector<int> xsas_dictionary::merge(const xsas_dictionary& rhs)
+        {
+            std::vector<int> res;
+            res.reserve(rhs.size());
+            for (auto value : rhs.m_values)
+                res.push_back(insert(value->data(), value->size()));
+            return res;
+        }
+
+        /*******************************
+         * xsas_columns implementation *
+         *******************************/
+
+        inline xsas_columns::xsas_columns(std::size_t number_count, std::size_t string_count, std::size_t row_count,
+                                          const sas_read_options& options)
+            : numbers(std::vector<std::size_t>({number_count, row_count})),
+              number_mask(std::vector<std::size_t>({number_count, row_count})),
+              missing_codes(options.missing_codes ? std::vector<std::size_t>({number_count, row_count}) : std::vector<std::size_t>({0, 0})),
+              strings(options.string_dictionary ? std::vector<std::size_t>({0, 0}) : std::vector<std::size_t>({string_count, row_count})),
+              string_codes(options.string_dictionary ? std::vector<std::size_t>({string_count, row_count}) : std::vector<std::size_t>({0, 0})),
+              dictionary(),
+              has_missing_codes(options.missing_codes),
+              has_dictionary(options.string_dictionary)
+        {
+        }
+
+        inline xsas_buffers xsas_columns::buffers()
+        {
+            return {numbers.data(),
+                    number_mask.data(),
+                    has_missing_codes ? missing_codes.data() : nullptr,
+                    has_dictionary ? nullptr : strings.data(),
+                    has_dictionary ? string_codes.data() : nullptr,
+                    has_dictionary ? &dictionary : nullptr};
+        }
+
+        /***********************************
+         * xsas7bdat_parser implementation *
+         ***********************************/
+
+        inline xsas7bdat_parser::xsas7bdat_parser(xsas_input& input) : m_input(input)
         {
         }
 
@@ -195,28 +920,20 @@ namespace xf
             return dst.val;
         }
 
-        inline xsas7bdat_parser::memory_data_type xsas7bdat_parser::load_data(std::ifstream& ifs, uint64_t length)
-        {
-            memory_data_type memory_data;
-            memory_data.resize(static_cast<size_t>(length));
-            ifs.read(&memory_data[0], static_cast<std::streamsize>(length));
-            return memory_data;
-        }
-
         template <typename T>
-        auto xsas7bdat_parser::read_memory_data(memory_data_type memory_data, uint64_t pos, bool swap) -> T
+        auto xsas7bdat_parser::read_memory_data(const char* memory_data, uint64_t pos, bool swap) -> T
         {
             T ret;
-            std::memcpy(&ret, &memory_data[static_cast<size_type>(pos)], sizeof (T));
+            std::memcpy(&ret, memory_data + pos, sizeof (T));
             if (swap)
                 ret = swap_endian(ret);
             return ret;
         }
 
         template <typename Container>
-        auto xsas7bdat_parser::read_memory_data(memory_data_type memory_data, uint64_t pos, uint64_t length) -> Container
+        auto xsas7bdat_parser::read_memory_data(const char* memory_data, uint64_t pos, uint64_t length) -> Container
         {
-            Container ret(memory_data.begin() + static_cast<difference_type>(pos), memory_data.begin() + static_cast<difference_type>(pos + length));
+            Container ret(memory_data + pos, memory_data + pos + length);
             return ret;
         }
 
@@ -224,7 +941,7 @@ namespace xf
         auto xsas7bdat_parser::iterator_memory_data(memory_data_iterator& memory_data_it, bool swap) -> T
         {
             T ret;
-            std::memcpy(&ret, &*memory_data_it, sizeof (T));
+            std::memcpy(&ret, memory_data_it, sizeof (T));
             if (swap)
                 ret = swap_endian(ret);
             memory_data_it += sizeof (T);
@@ -239,9 +956,20 @@ namespace xf
             return ret;
         }
 
-        void xsas7bdat_parser::parse_meta()
+        /**
+         * Collects the subheaders describing the columns. The scan stops as
+         * soon as the row size, the column size, and the name, attributes,
+         * format and label of every column have been found, which is usually
+         * within the first pages; otherwise it stops at the first data page.
+         */
+        inline void xsas7bdat_parser::parse_meta()
         {
             parse_head();
+            const uint64_t int_length = m_64bit ? 8 : 4;
+            // unknown until the column size subheader is found
+            uint64_t column_count = std::numeric_limits<uint64_t>::max();
+            uint64_t colname_count = 0;
+            uint64_t colattr_count = 0;
             std::vector<subheader> rowsize_subheader_vec;
             std::vector<subheader> colsize_subheader_vec;
             std::vector<subheader> coltext_subheader_vec;
@@ -252,11 +980,8 @@ namespace xf
             for (uint64_t idx = 0; idx < m_page_count; idx++)
             {
                 auto page_offset = m_header_size + idx * m_page_size;
-                if (!m_sas_ifs.seekg(static_cast<std::ifstream::off_type>(page_offset), m_sas_ifs.beg))
-                    throw std::runtime_error("parse sas error");
-
-                auto page_memory = load_data(m_sas_ifs, m_page_size);
-                auto p_type = m_64bit ? read_memory_data<uint16_t>(page_memory, 16, m_swap_endian) : read_memory_data<uint16_t>(page_memory, 32, m_swap_endian);
+                auto page_memory = m_input.read(page_offset, m_page_size);
+                auto p_type = read_page_type(page_memory);
                 if (static_cast<page_type>(p_type) == page_type::comp)
                     continue;
                 if (static_cast<page_type>(p_type) == page_type::data)
@@ -271,15 +996,22 @@ namespace xf
                         rowsize_subheader_vec.emplace_back(std::move(sub_header));
                         break;
                     case subheader_signature_type::subheader_signature_column_size:
+                        if (sub_header.length >= 2 * int_length)
+                        {
+                            column_count = m_64bit ? read_memory_data<uint64_t>(sub_header.data, int_length, m_swap_endian)
+                                                   : read_memory_data<uint32_t>(sub_header.data, int_length, m_swap_endian);
+                        }
                         colsize_subheader_vec.emplace_back(std::move(sub_header));
                         break;
                     case subheader_signature_type::subheader_signature_column_text:
                         coltext_subheader_vec.emplace_back(std::move(sub_header));
                         break;
                     case subheader_signature_type::subheader_signature_column_name:
+                        colname_count += colname_subheader_count(sub_header);
                         colname_subheader_vec.emplace_back(std::move(sub_header));
                         break;
                     case subheader_signature_type::subheader_signature_column_attrs:
+                        colattr_count += colattr_subheader_count(sub_header);
                         colattr_subheader_vec.emplace_back(std::move(sub_header));
                         break;
                     case subheader_signature_type::subheader_signature_column_label:
@@ -289,15 +1021,126 @@ namespace xf
                         break;
                     }
                 }
+                if (static_cast<page_type>(p_type) == page_type::mix)
+                    break;
+                if (!rowsize_subheader_vec.empty() && colname_count >= column_count && colattr_count >= column_count
+                    && collabs_subheader_vec.size() >= column_count
+                    && has_column_text(colname_subheader_vec, collabs_subheader_vec, coltext_subheader_vec.size()))
+                {
+                    break;
+                }
             }
+            parse_rowsize_subheader(rowsize_subheader_vec);
+            parse_coltext_subheader(coltext_subheader_vec);
             parse_colname_subheader(colname_subheader_vec, coltext_subheader_vec);
             parse_collabel_subheader(collabs_subheader_vec, coltext_subheader_vec);
             parse_colattr_subheader(colattr_subheader_vec);
+            if (m_coltype_vec.size() != m_colname_vec.size())
+                throw std::runtime_error("column attributes do not match column names");
+        }
+
+        /**
+         * Decodes the rows of the file into two columnar buffers, one for
+         * numeric columns and one for character columns. Each row is scattered
+         * directly into the buffers, no intermediate row object is built.
+         * Only the columns and the rows selected in options are decoded.
+         * When the input is memory-mapped and the thread count is not 1, the
+         * pages are decoded in parallel. parse_meta must have been called
+         * before.
+         */
+        inline sas_dataset xsas7bdat_parser::parse_data(const sas_read_options& options)
+        {
+            select(options);
+            const std::size_t row_count = static_cast<std::size_t>(m_row_end - m_row_begin);
+            xsas_columns columns(m_number_column_count, m_string_column_count, row_count, options);
+            const xsas_buffers buffers = columns.buffers();
+
+            std::size_t thread_count = options.thread_count;
+            if (thread_count == 0)
+                thread_count = std::max(std::thread::hardware_concurrency(), 1u);
+            if (m_input.mapped() && thread_count > 1)
+            {
+                decode_pages_parallel(thread_count, buffers);
+            }
+            else
+            {
+                uint64_t page = 0;
+                uint64_t page_first_row = 0;
+                decode_pages(page, m_page_count, page_first_row, buffers);
+            }
+
+            return make_sas_dataset(std::move(columns), number_axis(), string_axis());
+        }
+
+        /**
+         * Returns the description of the columns. parse_meta must have been
+         * called before.
+         */
+        inline sas_schema xsas7bdat_parser::schema() const
+        {
+            sas_schema res;
+            res.names = m_colname_vec;
+            res.formats = m_colfmt_vec;
+            res.labels = m_collabel_vec;
+            res.formats.resize(m_colname_vec.size());
+            res.labels.resize(m_colname_vec.size());
+            res.types.reserve(m_coltype_vec.size());
+            for (auto type : m_coltype_vec)
+                res.types.push_back(type == column_type::column_type_number ? sas_column_type::number : sas_column_type::string);
+            res.row_count = static_cast<std::size_t>(m_row_count);
+            return res;
+        }
+
+        /**
+         * Selects the columns and the rows to decode. parse_meta must have
+         * been called before.
+         */
+        inline void xsas7bdat_parser::select(const sas_read_options& options)
+        {
+            init_column_index(options);
+            m_row_end = std::min(static_cast<uint64_t>(options.row_stop), m_row_count);
+            m_row_begin = std::min(static_cast<uint64_t>(options.row_start), m_row_end);
+        }
+
+        inline uint64_t xsas7bdat_parser::row_begin() const noexcept
+        {
+            return m_row_begin;
+        }
+
+        inline uint64_t xsas7bdat_parser::row_end() const noexcept
+        {
+            return m_row_end;
+        }
+
+        /**
+         * Returns the axis of the selected numeric columns.
+         */
+        inline xaxis<fstring> xsas7bdat_parser::number_axis() const
+        {
+            return column_axis(column_type::column_type_number);
         }
 
-        void xsas7bdat_parser::parse_data()
+        /**
+         * Returns the axis of the selected character columns.
+         */
+        inline xaxis<fstring> xsas7bdat_parser::string_axis() const
         {
+            return column_axis(column_type::column_type_char);
+        }
 
+        /**
+         * Decodes the rows [row_begin, row_end) of the selected columns into
+         * buffers holding row_end - row_begin rows. page is the page where
+         * the decoding starts and page_first_row the index of its first row;
+         * on return, they designate the page holding row_end, so that
+         * consecutive ranges are decoded without walking the file again.
+         */
+        inline void xsas7bdat_parser::decode_rows(uint64_t row_begin, uint64_t row_end, uint64_t& page, uint64_t& page_first_row,
+                                                  const xsas_buffers& buffers)
+        {
+            m_row_begin = row_begin;
+            m_row_end = row_end;
+            decode_pages(page, m_page_count, page_first_row, buffers);
         }
 
         inline void xsas7bdat_parser::parse_head()
@@ -308,7 +1151,7 @@ namespace xf
                 0xb3, 0x14, 0x11, 0xcf, 0xbd, 0x92, 0x08, 0x00,
                 0x09, 0xc7, 0x31, 0x8c, 0x18, 0x1f, 0x10, 0x11
             };
-            auto basic_info_memory_data = load_data(m_sas_ifs, 38);
+            auto basic_info_memory_data = m_input.read(0, 38);
             auto magic_number = read_memory_data<std::string>(basic_info_memory_data, 0, static_cast<uint64_t>(sizeof (sas7bdat_magic_number)));
             if (std::memcmp(magic_number.c_str(), sas7bdat_magic_number, sizeof (sas7bdat_magic_number)) != 0)
                 throw std::runtime_error("magic number not match");
@@ -329,170 +1172,176 @@ namespace xf
                 m_swap_endian = !little_endian();
             else
                 throw std::runtime_error("unsupport endian");
+            m_little_endian = static_cast<endian>(file_endian) == endian::endian_little;
 
-            if (!m_sas_ifs.seekg(a1 + 196 - 38, m_sas_ifs.cur))
-                throw std::runtime_error("seek sas stream error");
+            auto size_memory_data = m_input.read(a1 + 196, m_64bit ? 16 : 12);
+            m_header_size = read_memory_data<uint32_t>(size_memory_data, 0, m_swap_endian);
 
-            auto header_size_memory_data = load_data(m_sas_ifs, 4);
-            m_header_size = read_memory_data<uint32_t>(header_size_memory_data, 0, m_swap_endian);
-
-            auto page_info_memory_data = m_64bit ? load_data(m_sas_ifs, 12) : load_data(m_sas_ifs, 8);
-            auto it = page_info_memory_data.begin();
+            auto it = size_memory_data + 4;
             m_page_size = iterator_memory_data<uint32_t>(it, m_swap_endian);
             m_page_count = m_64bit ? iterator_memory_data<uint64_t>(it, m_swap_endian) : iterator_memory_data<uint32_t>(it, m_swap_endian);
         }
 
-        std::vector<xsas7bdat_parser::subheader> xsas7bdat_parser::parse_page_subheader(memory_data_type& page_memory)
+        inline uint16_t xsas7bdat_parser::read_page_type(const char* page_memory)
         {
-            std::vector<subheader> ret_vec;
-            auto it = page_memory.begin();
+            auto p_type = m_64bit ? read_memory_data<uint16_t>(page_memory, 32, m_swap_endian) : read_memory_data<uint16_t>(page_memory, 16, m_swap_endian);
+            return static_cast<uint16_t>(p_type & 0xFF00);
+        }
+
+        inline std::vector<xsas7bdat_parser::subheader_pointer> xsas7bdat_parser::parse_page_subheader_pointer(const char* page_memory)
+        {
+            std::vector<subheader_pointer> ret_vec;
+            auto it = page_memory;
             it = m_64bit ? it + 36 : it + 20;
             auto subheader_pointers_count = iterator_memory_data<uint16_t>(it, m_swap_endian);
             it = it + 2;
+            ret_vec.reserve(subheader_pointers_count);
             for (auto idx = 0; idx < subheader_pointers_count; idx++)
             {
-                auto offset_to_subhead = m_64bit ? iterator_memory_data<uint64_t>(it, m_swap_endian) : iterator_memory_data<uint32_t>(it, m_swap_endian);
-                auto length = m_64bit ? iterator_memory_data<uint64_t>(it, m_swap_endian) : iterator_memory_data<uint32_t>(it, m_swap_endian);
-                if (length == 0)
+                subheader_pointer pointer;
+                pointer.offset = m_64bit ? iterator_memory_data<uint64_t>(it, m_swap_endian) : iterator_memory_data<uint32_t>(it, m_swap_endian);
+                pointer.length = m_64bit ? iterator_memory_data<uint64_t>(it, m_swap_endian) : iterator_memory_data<uint32_t>(it, m_swap_endian);
+                pointer.compression = iterator_memory_data<uint8_t>(it, m_swap_endian);
+                pointer.type = iterator_memory_data<uint8_t>(it, m_swap_endian);
+                it = it + (m_64bit ? 6 : 2);
+                if (pointer.length == 0 || static_cast<compression_type>(pointer.compression) == compression_type::trunc)
                     continue;
-                auto compression = iterator_memory_data<uint8_t>(it, m_swap_endian);
-                it = it + (m_64bit ? 7 : 3);
-                if (static_cast<compression_type>(compression) == compression_type::none)
-                {
-                    auto subheader_it = page_memory.begin() + static_cast<difference_type>(offset_to_subhead);
-                    subheader sub_header;
-                    sub_header.data = iterator_memory_data<memory_data_type>(subheader_it, length);
-                    sub_header.signature = m_64bit ? read_memory_data<uint64_t>(sub_header.data, 0, m_swap_endian)
-                                                   : read_memory_data<uint32_t>(sub_header.data, 0, m_swap_endian);
-                    sub_header.compression = compression;
-                    ret_vec.emplace_back(sub_header);
-                }
-                else if (static_cast<compression_type>(compression) == compression_type::rle)
-                {
-                    auto subheader_it = page_memory.begin() + static_cast<difference_type>(offset_to_subhead);
-                    subheader sub_header;
-                    sub_header.data = iterator_memory_data<memory_data_type>(subheader_it, length);
-                    auto it = sub_header.data.begin();
-                    while (it != sub_header.data.end())
-                    {
-                        auto control = iterator_memory_data<uint8_t>(it, false);
-                        auto command = (control & 0xF0) >> 4;
-                        auto length = (control & 0x0F);
-                        memory_data_type memory_data;
-                        switch (static_cast<rle_command>(command))
-                        {
-                        case rle_command::copy64:
-                        {
-                            auto copy_len = iterator_memory_data<uint8_t>(it, false) + 64 + length * 256;
-                            memory_data = iterator_memory_data<memory_data_type>(it, static_cast<uint64_t>(copy_len));
-                            break;
-                        }
-                        case rle_command::unknown1:
-                        case rle_command::unknown2:
-                        case rle_command::unknown3:
-                            break;
-                        case rle_command::insert_byte18:
-                        {
-                            auto insert_len = iterator_memory_data<uint8_t>(it, false) + 18 + length * 256;
-                            auto insert_byte = iterator_memory_data<uint8_t>(it, false);
-                            memory_data.insert(memory_data.begin(), static_cast<size_type>(insert_len), static_cast<value_type>(insert_byte));
-                        }
-                            break;
-                        case rle_command::insert_at17:
-                        {
-                            auto insert_len = iterator_memory_data<uint8_t>(it, false) + 17 + length * 256;
-                            auto insert_byte = '@';
-                            memory_data.insert(memory_data.begin(), static_cast<size_type>(insert_len), static_cast<value_type>(insert_byte));
-                            break;
-                        }
-                        case rle_command::insert_blank17:
-                        {
-                            auto insert_len = iterator_memory_data<uint8_t>(it, false) + 17 + length * 256;
-                            auto insert_byte = ' ';
-                            memory_data.insert(memory_data.begin(), static_cast<size_type>(insert_len), static_cast<value_type>(insert_byte));
-                            break;
-                        }
-                        case rle_command::insert_zero17:
-                        {
-                            auto insert_len = iterator_memory_data<uint8_t>(it, false) + 17 + length * 256;
-                            auto insert_byte = '\0';
-                            memory_data.insert(memory_data.begin(), static_cast<size_type>(insert_len), static_cast<value_type>(insert_byte));
-                            break;
-                        }
-                        case rle_command::copy1:
-                        {
-                            auto copy_len = length + 1;
-                            memory_data = iterator_memory_data<memory_data_type>(it, static_cast<uint64_t>(copy_len));
-                            break;
-                        }
-                        case rle_command::copy17:
-                        {
-                            auto copy_len = length + 17;
-                            memory_data = iterator_memory_data<memory_data_type>(it, static_cast<uint64_t>(copy_len));
-                            break;
-                        }
-                        case rle_command::copy33:
-                        {
-                            auto copy_len = length + 33;
-                            memory_data = iterator_memory_data<memory_data_type>(it, static_cast<uint64_t>(copy_len));
-                            break;
-                        }
-                        case rle_command::copy49:
-                        {
-                            auto copy_len = length + 49;
-                            memory_data = iterator_memory_data<memory_data_type>(it, static_cast<uint64_t>(copy_len));
-                            break;
-                        }
-                        case rle_command::insert_byte3:
-                        {
-                            auto insert_len = length + 3;
-                            auto insert_byte = iterator_memory_data<uint8_t>(it, false);
-                            memory_data.insert(memory_data.begin(), static_cast<size_type>(insert_len), static_cast<value_type>(insert_byte));
-                            break;
-                        }
-                        case rle_command::insert_at2:
-                        {
-                            auto insert_len = length + 2;
-                            auto insert_byte = '@';
-                            memory_data.insert(memory_data.begin(), static_cast<size_type>(insert_len), static_cast<value_type>(insert_byte));
-                            break;
-                        }
-                        case rle_command::insert_blank2:
-                        {
-                            auto insert_len = length + 2;
-                            auto insert_byte = ' ';
-                            memory_data.insert(memory_data.begin(), static_cast<size_type>(insert_len), static_cast<value_type>(insert_byte));
-                            break;
-                        }
-                        case rle_command::insert_zero2:
-                        {
-                            auto insert_len = length + 2;
-                            auto insert_byte = '\0';
-                            memory_data.insert(memory_data.begin(), static_cast<size_type>(insert_len), static_cast<value_type>(insert_byte));
-                            break;
-                        }
-                        }
-                    }
-                }
-                else
+                if (pointer.offset + pointer.length > m_page_size)
+                    throw std::runtime_error("sas subheader out of page bounds");
+                ret_vec.push_back(pointer);
+            }
+            return ret_vec;
+        }
+
+        /**
+         * In compressed files, rows are stored as subheaders of the meta pages.
+         */
+        inline bool xsas7bdat_parser::is_data_subheader(const subheader_pointer& pointer) const
+        {
+            auto compression = static_cast<compression_type>(pointer.compression);
+            return m_compression != compression_method::none
+                && (compression == compression_type::none || compression == compression_type::rle)
+                && pointer.type == data_subheader_type;
+        }
+
+        inline std::vector<xsas7bdat_parser::subheader> xsas7bdat_parser::parse_page_subheader(const char* page_memory)
+        {
+            std::vector<subheader> ret_vec;
+            for (const auto& pointer : parse_page_subheader_pointer(page_memory))
+            {
+                // compressed subheaders only hold rows
+                if (is_data_subheader(pointer) || static_cast<compression_type>(pointer.compression) != compression_type::none)
+                    continue;
+                subheader sub_header;
+                sub_header.data = page_memory + pointer.offset;
+                sub_header.length = pointer.length;
+                // A stream-backed input reuses its buffer for the next page, metadata
+                // subheaders must then be copied. Moving the subheader keeps data valid.
+                if (!m_input.mapped())
                 {
-                    // do nothing.
+                    sub_header.storage.assign(sub_header.data, sub_header.data + pointer.length);
+                    sub_header.data = sub_header.storage.data();
                 }
-
+                // only the low 32 bits of the 64 bit signatures are significant
+                sub_header.signature = m_64bit ? static_cast<uint32_t>(read_memory_data<uint64_t>(sub_header.data, 0, m_swap_endian))
+                                               : read_memory_data<uint32_t>(sub_header.data, 0, m_swap_endian);
+                sub_header.compression = pointer.compression;
+                ret_vec.emplace_back(std::move(sub_header));
             }
             return ret_vec;
         }
 
-        void xsas7bdat_parser::parse_colname_subheader(std::vector<subheader>& colname_subheader_vec, std::vector<subheader>& coltext_subheader_vec)
+        inline void xsas7bdat_parser::parse_rowsize_subheader(std::vector<subheader>& rowsize_subheader_vec)
+        {
+            if (rowsize_subheader_vec.size() == 0)
+                throw std::runtime_error("rowsize subheader vec expect greater than 0");
+            auto rowsize = rowsize_subheader_vec.front().data;
+            const uint64_t int_length = m_64bit ? 8 : 4;
+            auto read_int = [this, &rowsize](uint64_t pos) -> uint64_t
+            {
+                return m_64bit ? read_memory_data<uint64_t>(rowsize, pos, m_swap_endian)
+                               : read_memory_data<uint32_t>(rowsize, pos, m_swap_endian);
+            };
+            m_row_length = read_int(5 * int_length);
+            m_row_count = read_int(6 * int_length);
+            m_mix_page_row_count = read_int(15 * int_length);
+        }
+
+        inline void xsas7bdat_parser::parse_coltext_subheader(std::vector<subheader>& coltext_subheader_vec)
+        {
+            if (coltext_subheader_vec.size() == 0)
+                throw std::runtime_error("coltext subheader vec expect greater than 0");
+            // The compression literal is stored in the first column text subheader
+            const auto& text = coltext_subheader_vec.front();
+            auto contains = [&text](const char* literal)
+            {
+                auto text_end = text.data + text.length;
+                return std::search(text.data, text_end, literal, literal + std::strlen(literal)) != text_end;
+            };
+            if (contains("SASYZCRL"))
+                m_compression = compression_method::rle;
+            else if (contains("SASYZCR2"))
+                m_compression = compression_method::rdc;
+            else
+                m_compression = compression_method::none;
+        }
+
+        inline uint64_t xsas7bdat_parser::colname_subheader_count(const subheader& colname_subheader) const
+        {
+            const uint64_t header_length = m_64bit ? 28 : 20;
+            return colname_subheader.length < header_length ? 0 : (colname_subheader.length - header_length) / 8;
+        }
+
+        inline uint64_t xsas7bdat_parser::colattr_subheader_count(const subheader& colattr_subheader) const
+        {
+            const uint64_t header_length = m_64bit ? 28 : 20;
+            return colattr_subheader.length < header_length ? 0 : (colattr_subheader.length - header_length) / (m_64bit ? 16 : 12);
+        }
+
+        /**
+         * Checks that the column text subheaders referenced by the names,
+         * formats and labels have been found.
+         */
+        inline bool xsas7bdat_parser::has_column_text(const std::vector<subheader>& colname_subheader_vec,
+                                                      const std::vector<subheader>& collabel_subheader_vec,
+                                                      std::size_t coltext_count)
+        {
+            const uint64_t pointer_offset = m_64bit ? 16 : 12;
+            for (const auto& colname_subheader : colname_subheader_vec)
+            {
+                const uint64_t count = colname_subheader_count(colname_subheader);
+                for (uint64_t idx = 0; idx < count; ++idx)
+                {
+                    if (read_memory_data<uint16_t>(colname_subheader.data, pointer_offset + idx * 8, m_swap_endian) >= coltext_count)
+                        return false;
+                }
+            }
+            const uint64_t format_offset = m_64bit ? 46 : 34;
+            const uint64_t label_offset = m_64bit ? 52 : 40;
+            for (const auto& collabel_subheader : collabel_subheader_vec)
+            {
+                if (collabel_subheader.length < label_offset + 6)
+                    return false;
+                if (read_memory_data<uint16_t>(collabel_subheader.data, format_offset, m_swap_endian) >= coltext_count
+                    && read_memory_data<uint16_t>(collabel_subheader.data, format_offset + 4, m_swap_endian) > 0)
+                    return false;
+                if (read_memory_data<uint16_t>(collabel_subheader.data, label_offset, m_swap_endian) >= coltext_count
+                    && read_memory_data<uint16_t>(collabel_subheader.data, label_offset + 4, m_swap_endian) > 0)
+                    return false;
+            }
+            return true;
+        }
+
+        inline void xsas7bdat_parser::parse_colname_subheader(std::vector<subheader>& colname_subheader_vec, std::vector<subheader>& coltext_subheader_vec)
         {
             if (colname_subheader_vec.size() == 0 || coltext_subheader_vec.size() == 0)
                 throw std::runtime_error("colsize subheader vec expect greater than 0");
             for (auto& colname_subheader : colname_subheader_vec)
             {
-                auto subheader_pointor_length = m_64bit ? colname_subheader.data.size() - 28 : colname_subheader.data.size() - 20;
+                auto subheader_pointor_length = m_64bit ? colname_subheader.length - 28 : colname_subheader.length - 20;
                 auto subheader_pointor_count = subheader_pointor_length / 8;
                 auto subheader_pointor_offset = m_64bit ? 16 : 12;
-                auto pointor_it = colname_subheader.data.begin() + subheader_pointor_offset;
+                auto pointor_it = colname_subheader.data + subheader_pointor_offset;
                 for (size_t idx = 0; idx < subheader_pointor_count; idx++)
                 {
                     auto it = pointor_it + static_cast<difference_type>(idx * 8);
@@ -505,67 +1354,1143 @@ namespace xf
             }
         }
 
-        void xsas7bdat_parser::parse_collabel_subheader(std::vector<subheader>& collabel_subheader_vec, std::vector<subheader>& coltext_subheader_vec)
+        inline void xsas7bdat_parser::parse_collabel_subheader(std::vector<subheader>& collabel_subheader_vec, std::vector<subheader>& coltext_subheader_vec)
         {
             if (collabel_subheader_vec.size() == 0 || coltext_subheader_vec.size() == 0)
                 throw std::runtime_error("colsize subheader vec expect greater than 0");
             for (auto& collab : collabel_subheader_vec)
             {
-                auto it = m_64bit ? collab.data.begin() + 46 : collab.data.begin() + 34;
+                // formats and labels are stored for every column, even if they are
+                // empty, so that m_colfmt_vec and m_collabel_vec match m_colname_vec
+                auto it = m_64bit ? collab.data + 46 : collab.data + 34;
                 auto select_index = iterator_memory_data<uint16_t>(it, m_swap_endian);
                 auto offset = iterator_memory_data<uint16_t>(it, m_swap_endian) + (m_64bit ? 8 : 4);
                 auto length = iterator_memory_data<uint16_t>(it, m_swap_endian);
+                std::string fmt;
                 if (length > 0)
                 {
-                    auto fmt = read_memory_data<std::string>(coltext_subheader_vec[select_index].data, static_cast<uint64_t>(offset), static_cast<uint64_t>(length));
-                    m_colfmt_vec.emplace_back(std::move(fmt));
+                    fmt = read_memory_data<std::string>(coltext_subheader_vec[select_index].data, static_cast<uint64_t>(offset), static_cast<uint64_t>(length));
                 }
-                
-                it = m_64bit ? collab.data.begin() + 52 : collab.data.begin() + 40;
+                m_colfmt_vec.emplace_back(std::move(fmt));
+
+                it = m_64bit ? collab.data + 52 : collab.data + 40;
                 select_index = iterator_memory_data<uint16_t>(it, m_swap_endian);
                 offset = iterator_memory_data<uint16_t>(it, m_swap_endian) + (m_64bit ? 8 : 4);
                 length = iterator_memory_data<uint16_t>(it, m_swap_endian);
+                std::string label;
                 if (length > 0)
                 {
-                    auto label = read_memory_data<std::string>(coltext_subheader_vec[select_index].data, static_cast<uint64_t>(offset), static_cast<uint64_t>(length));
-                    m_collabel_vec.emplace_back(std::move(label));
+                    label = read_memory_data<std::string>(coltext_subheader_vec[select_index].data, static_cast<uint64_t>(offset), static_cast<uint64_t>(length));
                 }
+                m_collabel_vec.emplace_back(std::move(label));
             }
         }
 
-        void xsas7bdat_parser::parse_colattr_subheader(std::vector<subheader>& colattr_subheader_vec)
+        inline void xsas7bdat_parser::parse_colattr_subheader(std::vector<subheader>& colattr_subheader_vec)
         {
             if (colattr_subheader_vec.size() == 0 )
                 throw std::runtime_error("colattr subheader vec expect greater than 0");
             for (auto& colattr_subheader : colattr_subheader_vec)
             {
-                auto subheader_pointor_length = m_64bit ? colattr_subheader.data.size() - 28 : colattr_subheader.data.size() - 20;
+                auto subheader_pointor_length = m_64bit ? colattr_subheader.length - 28 : colattr_subheader.length - 20;
                 auto subheader_pointor_count = m_64bit ? subheader_pointor_length / 16 : subheader_pointor_length / 12;
                 auto subheader_pointor_offset = m_64bit ? 16 : 12;
-                auto pointor_it = colattr_subheader.data.begin() + subheader_pointor_offset;
+                auto pointor_it = colattr_subheader.data + subheader_pointor_offset;
                 for (size_t idx = 0; idx < subheader_pointor_count; idx++)
                 {
                     auto it = pointor_it + static_cast<difference_type>(idx * (m_64bit ? 16 : 12));
-                    it = it + static_cast<difference_type>(m_64bit ? 14 : 10);
+                    auto col_offset = m_64bit ? iterator_memory_data<uint64_t>(it, m_swap_endian) : iterator_memory_data<uint32_t>(it, m_swap_endian);
+                    auto col_length = iterator_memory_data<uint32_t>(it, m_swap_endian);
+                    it = it + 2;
                     auto col_type = iterator_memory_data<uint8_t>(it, m_swap_endian);
+                    m_coloffset_vec.emplace_back(col_offset);
+                    m_collength_vec.emplace_back(col_length);
                     m_coltype_vec.emplace_back(static_cast<column_type>(col_type));
                 }
             }
         }
+
+        /**
+         * Resolves the columns selected in options and computes where each
+         * of them is read in a row and written in the buffers. The other
+         * columns are never touched while decoding.
+         */
+        inline void xsas7bdat_parser::init_column_index(const sas_read_options& options)
+        {
+            m_colselect_vec = select_sas_columns(m_colname_vec, options);
+            m_colslot_vec.clear();
+            m_number_column_count = 0;
+            m_string_column_count = 0;
+            for (auto col : m_colselect_vec)
+            {
+                if (m_coloffset_vec[col] + m_collength_vec[col] > m_row_length)
+                    throw std::runtime_error("sas column out of row bounds");
+                if (m_coltype_vec[col] == column_type::column_type_number && (m_collength_vec[col] == 0 || m_collength_vec[col] > 8))
+                    throw std::runtime_error("invalid sas numeric column length");
+                column_slot slot;
+                slot.offset = m_coloffset_vec[col];
+                slot.length = m_collength_vec[col];
+                slot.type = m_coltype_vec[col];
+                slot.index = slot.type == column_type::column_type_number ? m_number_column_count++ : m_string_column_count++;
+                m_colslot_vec.push_back(slot);
+            }
+        }
+
+        inline xaxis<fstring> xsas7bdat_parser::column_axis(column_type type) const
+        {
+            std::vector<fstring> names;
+            for (auto col : m_colselect_vec)
+            {
+                if (m_coltype_vec[col] == type)
+                    names.push_back(fstring(m_colname_vec[col]));
+            }
+            return xaxis<fstring>(std::move(names));
+        }
+
+        /**
+         * Returns the number of rows stored in a page, at most remaining_row_count.
+         */
+        inline uint64_t xsas7bdat_parser::page_row_count(const char* page_memory, uint64_t remaining_row_count)
+        {
+            const uint64_t bit_offset = m_64bit ? 32 : 16;
+            uint64_t count = 0;
+            switch (static_cast<page_type>(read_page_type(page_memory)))
+            {
+            case page_type::meta:
+            case page_type::meta2:
+            case page_type::amd:
+                if (m_compression != compression_method::none)
+                {
+                    auto pointers = parse_page_subheader_pointer(page_memory);
+                    count = static_cast<uint64_t>(std::count_if(pointers.cbegin(), pointers.cend(),
+                        [this](const subheader_pointer& pointer) { return is_data_subheader(pointer); }));
+                }
+                break;
+            case page_type::mix:
+                count = m_mix_page_row_count;
+                break;
+            case page_type::data:
+                count = read_memory_data<uint16_t>(page_memory, bit_offset + 2, m_swap_endian);
+                break;
+            default:
+                break;
+            }
+            return std::min(count, remaining_row_count);
+        }
+
+        /**
+         * Decodes the selected rows stored in the pages [page, last_page);
+         * page_first_row is the index of the first row of page. Only the rows
+         * of these pages are written to the buffers, so that disjoint page
+         * ranges can be decoded concurrently. Pages whose rows are all before
+         * the selected range are skipped. On return, page and page_first_row
+         * designate the first page holding rows after the selected range,
+         * or last_page.
+         */
+        inline void xsas7bdat_parser::decode_pages(uint64_t& page, uint64_t last_page, uint64_t& page_first_row,
+                                                   const xsas_buffers& buffers)
+        {
+            memory_data_type row_buffer(static_cast<size_type>(m_row_length));
+            const uint64_t bit_offset = m_64bit ? 32 : 16;
+            const uint64_t subheader_pointer_length = m_64bit ? 24 : 12;
+            for (; page < last_page && page_first_row < m_row_end; ++page)
+            {
+                auto page_offset = m_header_size + page * m_page_size;
+                auto page_memory = m_input.read(page_offset, m_page_size);
+                auto p_type = static_cast<page_type>(read_page_type(page_memory));
+                const uint64_t page_stop = page_first_row + page_row_count(page_memory, m_row_count - page_first_row);
+                const uint64_t page_end = std::min(page_stop, m_row_end);
+                uint64_t row_index = page_first_row;
+                if (page_end > m_row_begin)
+                {
+                    if (p_type == page_type::meta || p_type == page_type::meta2 || p_type == page_type::amd)
+                    {
+                        for (const auto& pointer : parse_page_subheader_pointer(page_memory))
+                        {
+                            if (!is_data_subheader(pointer) || row_index == page_end)
+                                continue;
+                            if (row_index++ < m_row_begin)
+                                continue;
+                            auto row = decompress_row(page_memory + pointer.offset, pointer.length, row_buffer.data());
+                            parse_rows(row, 1, row_index - 1, buffers);
+                        }
+                    }
+                    else if (p_type == page_type::mix || p_type == page_type::data)
+                    {
+                        uint64_t offset = bit_offset + 8;
+                        if (p_type == page_type::mix)
+                        {
+                            auto subheader_count = read_memory_data<uint16_t>(page_memory, bit_offset + 4, m_swap_endian);
+                            offset += subheader_count * subheader_pointer_length;
+                            offset += offset % 8;
+                        }
+                        if (offset + (page_end - row_index) * m_row_length > m_page_size)
+                            throw std::runtime_error("sas row out of page bounds");
+                        if (row_index < m_row_begin)
+                        {
+                            offset += (m_row_begin - row_index) * m_row_length;
+                            row_index = m_row_begin;
+                        }
+                        parse_rows(page_memory + offset, page_end - row_index, row_index, buffers);
+                    }
+                }
+                // the page also holds rows after the selected range
+                if (page_stop > m_row_end)
+                    break;
+                page_first_row = page_stop;
+            }
+        }
+
+        /**
+         * Splits the pages holding the selected rows into thread_count
+         * contiguous ranges holding about the same number of rows, and
+         * decodes each range on its own thread.
+         * The first row of each page is the prefix sum of the row counts of
+         * the previous pages; since each row has a fixed position in the
+         * buffers, the threads write to disjoint slices and need no locking.
+         * Each thread interns strings in its own dictionary; the dictionaries
+         * are then merged in the order of the pages and the codes of each
+         * range are translated, so that codes do not depend on the number of
+         * threads. The input must be memory-mapped.
+         */
+        inline void xsas7bdat_parser::decode_pages_parallel(std::size_t thread_count, const xsas_buffers& buffers)
+        {
+            std::vector<uint64_t> page_first_row(static_cast<size_type>(m_page_count + 1), 0);
+            for (uint64_t idx = 0; idx < m_page_count; ++idx)
+            {
+                // pages after the selected range are never decoded
+                if (page_first_row[idx] >= m_row_end)
+                {
+                    page_first_row[idx + 1] = page_first_row[idx];
+                    continue;
+                }
+                auto page_memory = m_input.read(m_header_size + idx * m_page_size, m_page_size);
+                page_first_row[idx + 1] = page_first_row[idx] + page_row_count(page_memory, m_row_count - page_first_row[idx]);
+            }
+
+            std::vector<std::thread> threads;
+            std::vector<std::exception_ptr> errors(thread_count);
+            std::vector<xsas_buffers> thread_buffers(thread_count, buffers);
+            std::vector<xsas_dictionary> dictionaries(buffers.dictionary != nullptr ? thread_count : 0);
+            // rows decoded by the threads with their own dictionary
+            std::vector<std::pair<uint64_t, uint64_t>> range_vec;
+            threads.reserve(thread_count);
+            // last page starting at or before the first selected row
+            uint64_t first_page = static_cast<uint64_t>(std::upper_bound(page_first_row.cbegin(), page_first_row.cend() - 1, m_row_begin)
+                                                        - page_first_row.cbegin()) - 1;
+            for (std::size_t i = 0; i < thread_count && first_page < m_page_count; ++i)
+            {
+                uint64_t last_page = m_page_count;
+                if (i + 1 != thread_count)
+                {
+                    const uint64_t target = m_row_begin + (m_row_end - m_row_begin) / thread_count * (i + 1);
+                    auto it = std::lower_bound(page_first_row.cbegin() + static_cast<difference_type>(first_page + 1), page_first_row.cend() - 1, target);
+                    last_page = static_cast<uint64_t>(it - page_first_row.cbegin());
+                }
+                if (i != 0 && buffers.dictionary != nullptr)
+                    thread_buffers[i].dictionary = &dictionaries[i];
+                threads.emplace_back([this, first_page, last_page, &page_first_row, &errors, i, &thread_buffers]()
+                {
+                    try
+                    {
+                        uint64_t page = first_page;
+                        uint64_t first_row = page_first_row[first_page];
+                        decode_pages(page, last_page, first_row, thread_buffers[i]);
+                    }
+                    catch (...)
+                    {
+                        errors[i] = std::current_exception();
+                    }
+                });
+                if (i != 0 && buffers.dictionary != nullptr)
+                    range_vec.emplace_back(std::max(page_first_row[first_page], m_row_begin), std::min(page_first_row[last_page], m_row_end));
+                first_page = last_page;
+            }
+            for (auto& thread : threads)
+                thread.join();
+            for (auto& error : errors)
+            {
+                if (error)
+                    std::rethrow_exception(error);
+            }
+
+            const std::size_t column_length = static_cast<std::size_t>(m_row_end - m_row_begin);
+            for (std::size_t i = 0; i < range_vec.size(); ++i)
+            {
+                const auto codes = buffers.dictionary->merge(dictionaries[i + 1]);
+                const std::size_t first = static_cast<std::size_t>(range_vec[i].first - m_row_begin);
+                const std::size_t last = static_cast<std::size_t>(range_vec[i].second - m_row_begin);
+                for (std::size_t col = 0; col < m_string_column_count; ++col)
+                {
+                    int* column = buffers.string_codes + col * column_length;
+                    for (std::size_t row = first; row < last; ++row)
+                        column[row] = codes[static_cast<std::size_t>(column[row])];
+                }
+            }
+        }
+
+        /**
+         * Returns a pointer to the uncompressed content of a row subheader. Rows
+         * that did not shrink when compressed are stored as is; the others are
+         * decompressed into buffer, which must hold m_row_length bytes.
+         */
+        inline const char* xsas7bdat_parser::decompress_row(const char* data, uint64_t length, char* buffer) const
+        {
+            if (length >= m_row_length)
+                return data;
+            switch (m_compression)
+            {
+            case compression_method::rle:
+                decompress_sas_rle(data, length, buffer, m_row_length);
+                break;
+            case compression_method::rdc:
+                decompress_sas_rdc(data, length, buffer, m_row_length);
+                break;
+            default:
+                throw std::runtime_error("unsupported sas7bdat compression");
+            }
+            return buffer;
+        }
+
+        /**
+         * Decompresses a row compressed with the SAS run-length encoding. The
+         * row is written forward in a single pass, literal and repeated runs
+         * being respectively copied and filled. Every run is checked against
+         * the bounds of the input and of the output before it is written; the
+         * row must fill exactly output_length bytes.
+         */
+        inline void decompress_sas_rle(const char* input, uint64_t input_length, char* output, uint64_t output_length)
+        {
+            const unsigned char* in = reinterpret_cast<const unsigned char*>(input);
+            const unsigned char* in_end = in + input_length;
+            char* out = output;
+            char* out_end = output + output_length;
+            while (in != in_end)
+            {
+                const unsigned char control = *in++;
+                const std::size_t length = control & 0x0F;
+                // commands reading a byte after the control byte
+                std::size_t arguments = 0;
+                switch (static_cast<xsas_rle_command>(control >> 4))
+                {
+                case xsas_rle_command::copy64:
+                case xsas_rle_command::insert_at17:
+                case xsas_rle_command::insert_blank17:
+                case xsas_rle_command::insert_zero17:
+                case xsas_rle_command::insert_byte3:
+                    arguments = 1;
+                    break;
+                case xsas_rle_command::insert_byte18:
+                    arguments = 2;
+                    break;
+                default:
+                    break;
+                }
+                if (static_cast<std::size_t>(in_end - in) < arguments)
+                    throw std::runtime_error("corrupted sas rle data");
+
+                std::size_t copy_length = 0;
+                std::size_t insert_length = 0;
+                char insert_byte = '\0';
+                switch (static_cast<xsas_rle_command>(control >> 4))
+                {
+                case xsas_rle_command::copy64:
+                    copy_length = *in++ + 64 + length * 256;
+                    break;
+                case xsas_rle_command::insert_byte18:
+                    insert_length = *in++ + 18 + length * 256;
+                    insert_byte = static_cast<char>(*in++);
+                    break;
+                case xsas_rle_command::insert_at17:
+                    insert_length = *in++ + 17 + length * 256;
+                    insert_byte = '@';
+                    break;
+                case xsas_rle_command::insert_blank17:
+                    insert_length = *in++ + 17 + length * 256;
+                    insert_byte = ' ';
+                    break;
+                case xsas_rle_command::insert_zero17:
+                    insert_length = *in++ + 17 + length * 256;
+                    break;
+                case xsas_rle_command::copy1:
+                    copy_length = length + 1;
+                    break;
+                case xsas_rle_command::copy17:
+                    copy_length = length + 17;
+                    break;
+                case xsas_rle_command::copy33:
+                    copy_length = length + 33;
+                    break;
+                case xsas_rle_command::copy49:
+                    copy_length = length + 49;
+                    break;
+                case xsas_rle_command::insert_byte3:
+                    insert_length = length + 3;
+                    insert_byte = static_cast<char>(*in++);
+                    break;
+                case xsas_rle_command::insert_at2:
+                    insert_length = length + 2;
+                    insert_byte = '@';
+                    break;
+                case xsas_rle_command::insert_blank2:
+                    insert_length = length + 2;
+                    insert_byte = ' ';
+                    break;
+                case xsas_rle_command::insert_zero2:
+                    insert_length = length + 2;
+                    break;
+                default:
+                    throw std::runtime_error("unknown sas rle command");
+                }
+
+                if (copy_length != 0)
+                {
+                    if (static_cast<std::size_t>(in_end - in) < copy_length || static_cast<std::size_t>(out_end - out) < copy_length)
+                        throw std::runtime_error("corrupted sas rle data");
+                    std::memcpy(out, in, copy_length);
+                    in += copy_length;
+                    out += copy_length;
+                }
+                else
+                {
+                    if (static_cast<std::size_t>(out_end - out) < insert_length)
+                        throw std::runtime_error("corrupted sas rle data");
+                    std::memset(out, insert_byte, insert_length);
+                    out += insert_length;
+                }
+            }
+            if (out != out_end)
+                throw std::runtime_error("sas rle row length mismatch");
+        }
+
+        /**
+         * Decompresses a row compressed with the Ross Data Compression, used by
+         * SAS for COMPRESS=BINARY. A 16-bit control word tells, for each of the
+         * next 16 items, whether it is a literal byte or a command; commands
+         * either repeat a byte or copy a pattern already written to the row.
+         * As for RLE, the row must fill exactly output_length bytes.
+         */
+        inline void decompress_sas_rdc(const char* input, uint64_t input_length, char* output, uint64_t output_length)
+        {
+            const unsigned char* in = reinterpret_cast<const unsigned char*>(input);
+            const unsigned char* in_end = in + input_length;
+            char* out = output;
+            char* out_end = output + output_length;
+            auto check_input = [&in, in_end](std::size_t n)
+            {
+                if (static_cast<std::size_t>(in_end - in) < n)
+                    throw std::runtime_error("corrupted sas rdc data");
+            };
+            auto check_output = [&out, out_end](std::size_t n)
+            {
+                if (static_cast<std::size_t>(out_end - out) < n)
+                    throw std::runtime_error("corrupted sas rdc data");
+            };
+
+            uint16_t control_bits = 0;
+            uint16_t control_mask = 0;
+            while (in != in_end)
+            {
+                control_mask = static_cast<uint16_t>(control_mask >> 1);
+                if (control_mask == 0)
+                {
+                    check_input(2);
+                    control_bits = static_cast<uint16_t>((in[0] << 8) | in[1]);
+                    control_mask = 0x8000;
+                    in += 2;
+                    if (in == in_end)
+                        break;
+                }
+                if ((control_bits & control_mask) == 0)
+                {
+                    check_output(1);
+                    *out++ = static_cast<char>(*in++);
+                    continue;
+                }
+
+                const unsigned char command = static_cast<unsigned char>(*in >> 4);
+                std::size_t count = *in++ & 0x0F;
+                switch (static_cast<xsas_rdc_command>(command))
+                {
+                case xsas_rdc_command::short_rle:
+                    check_input(1);
+                    count += 3;
+                    check_output(count);
+                    std::memset(out, static_cast<char>(*in++), count);
+                    out += count;
+                    break;
+                case xsas_rdc_command::long_rle:
+                    check_input(2);
+                    count += static_cast<std::size_t>(*in++) << 4;
+                    count += 19;
+                    check_output(count);
+                    std::memset(out, static_cast<char>(*in++), count);
+                    out += count;
+                    break;
+                default:
+                {
+                    check_input(1);
+                    std::size_t offset = count + 3;
+                    offset += static_cast<std::size_t>(*in++) << 4;
+                    if (static_cast<xsas_rdc_command>(command) == xsas_rdc_command::long_pattern)
+                    {
+                        check_input(1);
+                        count = static_cast<std::size_t>(*in++) + 16;
+                    }
+                    else
+                    {
+                        count = command;
+                    }
+                    if (static_cast<std::size_t>(out - output) < offset)
+                        throw std::runtime_error("corrupted sas rdc data");
+                    check_output(count);
+                    const char* pattern = out - offset;
+                    // the pattern may overlap the bytes being written
+                    if (offset >= count)
+                    {
+                        std::memcpy(out, pattern, count);
+                        out += count;
+                    }
+                    else
+                    {
+                        for (std::size_t i = 0; i < count; ++i)
+                            *out++ = pattern[i];
+                    }
+                    break;
+                }
+                }
+            }
+            if (out != out_end)
+                throw std::runtime_error("sas rdc row length mismatch");
+        }
+
+        /**
+         * Decodes row_count consecutive rows, the first of which has the index
+         * row_index, into the columnar buffers. The rows are decoded column by
+         * column: the fields of a column are read with a stride of a row and
+         * written contiguously. Each buffer holds its columns one after the
+         * other, the i-th column starts at i times the number of selected rows.
+         */
+        inline void xsas7bdat_parser::parse_rows(const char* rows, uint64_t row_count, uint64_t row_index, const xsas_buffers& buffers)
+        {
+            const std::size_t column_length = static_cast<std::size_t>(m_row_end - m_row_begin);
+            const std::size_t index = static_cast<std::size_t>(row_index - m_row_begin);
+            const std::size_t count = static_cast<std::size_t>(row_count);
+            const std::size_t stride = static_cast<std::size_t>(m_row_length);
+            for (const auto& column : m_colslot_vec)
+            {
+                const char* field = rows + column.offset;
+                const std::size_t start = column.index * column_length + index;
+                if (column.type == column_type::column_type_number)
+                {
+                    decode_sas_numbers(field, stride, count, static_cast<std::size_t>(column.length), m_little_endian, m_swap_endian,
+                                       buffers.numbers + start, buffers.number_mask + start,
+                                       buffers.missing_codes == nullptr ? nullptr : buffers.missing_codes + start);
+                }
+                else
+                {
+                    decode_sas_strings(field, stride, count, static_cast<std::size_t>(column.length), buffers, start);
+                }
+            }
+        }
+
+        template <bool Codes>
+        inline void ibm_to_ieee_impl(const uint64_t* ibm, std::size_t size, double* ieee, bool* mask, char* missing_codes)
+        {
+            for (std::size_t i = 0; i < size; ++i)
+            {
+                const uint64_t value = ibm[i];
+                const uint64_t fraction = value & 0x00FFFFFFFFFFFFFFull;
+                const uint64_t exponent = (value >> 56) & 0x7F;
+                // the first hexadecimal digit of the fraction is not null,
+                // the leading bit is found within its 4 bits
+                const uint64_t shift = static_cast<uint64_t>(fraction < (1ull << 55))
+                                     + static_cast<uint64_t>(fraction < (1ull << 54))
+                                     + static_cast<uint64_t>(fraction < (1ull << 53));
+                const uint64_t mantissa = ((fraction << shift) >> 3) & 0x000FFFFFFFFFFFFFull;
+                // 16^(e - 64) * 0.f = 2^(4e - 256 - 1 - shift) * 1.m
+                const uint64_t ieee_exponent = 4 * exponent + 1023 - 257 - shift;
+                uint64_t bits = (value & 0x8000000000000000ull) | (ieee_exponent << 52) | mantissa;
+                const bool missing = fraction == 0 && exponent != 0;
+                const uint64_t non_zero = 0 - static_cast<uint64_t>(fraction != 0);
+                bits = (bits & non_zero) | (0x7FF8000000000000ull & (0 - static_cast<uint64_t>(missing)));
+                std::memcpy(ieee + i, &bits, sizeof(double));
+                mask[i] = !missing;
+                if (Codes)
+                    missing_codes[i] = missing ? static_cast<char>(value >> 56) : '\0';
+            }
+        }
+
+        /**
+         * Converts big-endian IBM 370 floating-point numbers, loaded as
+         * integers, to IEEE 754 doubles, and fills the mask in the same
+         * pass. SAS missing values, which have a null fraction and whose
+         * first byte is their code, become NaN. The loop has no branch so
+         * that the compiler vectorizes it.
+         * @param missing_codes the codes of the missing values, may be null.
+         */
+        inline void ibm_to_ieee(const uint64_t* ibm, std::size_t size, double* ieee, bool* mask, char* missing_codes)
+        {
+            if (missing_codes == nullptr)
+                ibm_to_ieee_impl<false>(ibm, size, ieee, mask, missing_codes);
+            else
+                ibm_to_ieee_impl<true>(ibm, size, ieee, mask, missing_codes);
+        }
+
+        /********************************
+         * xxport_parser implementation *
+         ********************************/
+
+        inline xxport_parser::xxport_parser(xsas_input& input)
+            : m_input(input)
+        {
+        }
+
+        /**
+         * Checks that record is the header record of the given name, which
+         * is padded with blanks to 8 characters.
+         */
+        inline bool xxport_parser::is_header(const char* record, const char* name) const
+        {
+            constexpr const char prefix[] = "HEADER RECORD*******";
+            constexpr std::size_t prefix_length = sizeof(prefix) - 1;
+            if (std::memcmp(record, prefix, prefix_length) != 0)
+                return false;
+            const std::size_t name_length = std::strlen(name);
+            return std::memcmp(record + prefix_length, name, name_length) == 0
+                && std::all_of(record + prefix_length + name_length, record + prefix_length + 8,
+                               [](char c) { return c == ' '; });
+        }
+
+        /**
+         * Returns the offset of the first header record with one of the given
+         * names, starting at or after offset, or the size of the input.
+         */
+        inline uint64_t xxport_parser::find_header(uint64_t offset, std::initializer_list<const char*> names)
+        {
+            const uint64_t size = m_input.size();
+            const uint64_t block_length = chunk_length / record_length * record_length;
+            while (offset + record_length <= size)
+            {
+                const uint64_t length = std::min(block_length, (size - offset) / record_length * record_length);
+                const char* block = m_input.read(offset, length);
+                for (uint64_t pos = 0; pos < length; pos += record_length)
+                {
+                    const char* record = block + pos;
+                    if (std::any_of(names.begin(), names.end(), [this, record](const char* name) { return is_header(record, name); }))
+                        return offset + pos;
+                }
+                offset += length;
+            }
+            return size;
+        }
+
+        inline void xxport_parser::parse_meta()
+        {
+            const char* library = m_input.read(0, record_length);
+            if (is_header(library, "LIBV8"))
+                m_v8 = true;
+            else if (!is_header(library, "LIBRARY"))
+                throw std::runtime_error("not a sas transport file");
+
+            // library header, 2 library records, member header, descriptor
+            // header, 2 descriptor records, namestr header
+            const char* member = m_input.read(3 * record_length, record_length);
+            if (!is_header(member, m_v8 ? "MEMBV8" : "MEMBER"))
+                throw std::runtime_error("sas transport member header expected");
+            m_namestr_length = static_cast<uint64_t>(std::stoul(std::string(member + 74, 4)));
+            if (m_namestr_length < 88)
+                throw std::runtime_error("invalid sas transport namestr length");
+            const char* namestr_header = m_input.read(7 * record_length, record_length);
+            if (!is_header(namestr_header, m_v8 ? "NAMSTV8" : "NAMESTR"))
+                throw std::runtime_error("sas transport namestr header expected");
+            // the number of variables follows 6 zeros, it has 4 digits in
+            // version 5 and 6 in version 8
+            const char* count_field = namestr_header + 54;
+            const std::size_t count_length = m_v8 ? 6 : 4;
+            if (!std::all_of(count_field, count_field + count_length, [](char c) { return c >= '0' && c <= '9'; }))
+                throw std::runtime_error("invalid sas transport variable count");
+            const uint64_t column_count = static_cast<uint64_t>(std::stoul(std::string(count_field, count_length)));
+
+            // The namestr records are padded to a whole record, followed in
+            // version 8 by label records, then by the observation header.
+            const uint64_t namestr_offset = 8 * record_length;
+            const uint64_t header_offset = find_header(namestr_offset, {"OBS", "OBSV8", "LABELV8", "LABELV9"});
+            if (header_offset == m_input.size())
+                throw std::runtime_error("sas transport observation header expected");
+            // header is only valid until the next read
+            const char* header = m_input.read(header_offset, record_length);
+            const bool v9_labels = is_header(header, "LABELV9");
+            const bool has_labels = v9_labels || is_header(header, "LABELV8");
+            const uint64_t obs_offset = has_labels ? find_header(header_offset + record_length, {"OBS", "OBSV8"}) : header_offset;
+            if (obs_offset == m_input.size())
+                throw std::runtime_error("sas transport observation header expected");
+            // the namestrs of all the variables, padded to a whole record
+            const uint64_t namestrs_length = header_offset - namestr_offset;
+            if (column_count * m_namestr_length > namestrs_length || namestrs_length - column_count * m_namestr_length >= record_length)
+                throw std::runtime_error("sas transport variable count does not match the namestr records");
+            const char* namestrs = m_input.read(namestr_offset, column_count * m_namestr_length);
+            for (uint64_t col = 0; col < column_count; ++col)
+                parse_namestr(namestrs + col * m_namestr_length);
+            if (has_labels)
+            {
+                const uint64_t labels_offset = header_offset + record_length;
+                parse_labels(m_input.read(labels_offset, obs_offset - labels_offset), obs_offset - labels_offset, v9_labels);
+            }
+
+            m_data_offset = obs_offset + record_length;
+            const uint64_t data_end = find_header(m_data_offset, {"MEMBER", "MEMBV8"});
+            const uint64_t data_length = data_end - m_data_offset;
+            m_row_count = m_row_length == 0 ? 0 : data_length / m_row_length;
+            m_row_count -= trailing_blank_rows(data_length);
+        }
+
+        inline void xxport_parser::parse_namestr(const char* namestr)
+        {
+            auto read_int = [namestr](std::size_t pos, std::size_t length)
+            {
+                uint64_t res = 0;
+                for (std::size_t i = 0; i < length; ++i)
+                    res = (res << 8) | static_cast<unsigned char>(namestr[pos + i]);
+                return res;
+            };
+            const auto type = static_cast<column_type>(read_int(0, 2));
+            const uint64_t length = read_int(4, 2);
+            const uint64_t offset = read_int(84, 4);
+            if (type != column_type::column_type_number && type != column_type::column_type_char)
+                throw std::runtime_error("invalid sas transport column type");
+            if (type == column_type::column_type_number && (length < 2 || length > 8))
+                throw std::runtime_error("invalid sas transport numeric length");
+
+            std::string name;
+            if (m_v8 && m_namestr_length >= 120)
+                assign_sas_string(name, namestr + 88, 32);
+            if (name.empty())
+                assign_sas_string(name, namestr + 8, 8);
+            std::string format;
+            assign_sas_string(format, namestr + 56, 8);
+            std::string label;
+            assign_sas_string(label, namestr + 16, 40);
+            m_colname_vec.push_back(std::move(name));
+            m_colfmt_vec.push_back(std::move(format));
+            m_collabel_vec.push_back(std::move(label));
+            m_coltype_vec.push_back(type);
+            m_coloffset_vec.push_back(offset);
+            m_collength_vec.push_back(length);
+            m_row_length = std::max(m_row_length, offset + length);
+        }
+
+        /**
+         * Reads the labels longer than 40 characters, and in version 9 the
+         * formats longer than 8 characters, stored after the namestrs. Each
+         * entry starts with the column number and the lengths of its texts,
+         * followed by the texts; the entries are packed and padded to a whole
+         * record.
+         */
+        inline void xxport_parser::parse_labels(const char* labels, uint64_t length, bool v9)
+        {
+            auto read_int = [labels](uint64_t pos)
+            {
+                return static_cast<uint64_t>((static_cast<unsigned char>(labels[pos]) << 8) | static_cast<unsigned char>(labels[pos + 1]));
+            };
+            const uint64_t header_length = v9 ? 10 : 6;
+            uint64_t pos = 0;
+            while (pos + header_length <= length)
+            {
+                const uint64_t col = read_int(pos);
+                const uint64_t name_length = read_int(pos + 2);
+                const uint64_t label_length = read_int(pos + (v9 ? 8 : 4));
+                const uint64_t format_length = v9 ? read_int(pos + 4) : 0;
+                const uint64_t informat_length = v9 ? read_int(pos + 6) : 0;
+                const uint64_t text = pos + header_length;
+                // the padding of the last record is made of blanks
+                if (col == 0 || col > m_colname_vec.size())
+                    break;
+                if (text + name_length + label_length + format_length + informat_length > length)
+                    throw std::runtime_error("invalid sas transport label record");
+                assign_sas_string(m_collabel_vec[col - 1], labels + text + name_length, label_length);
+                if (format_length > 0)
+                    assign_sas_string(m_colfmt_vec[col - 1], labels + text + name_length + label_length, format_length);
+                pos = text + name_length + label_length + format_length + informat_length;
+            }
+        }
+
+        /**
+         * The observations are padded with blanks to a whole record; this
+         * padding may be as long as a row, if rows are shorter than a record.
+         */
+        inline uint64_t xxport_parser::trailing_blank_rows(uint64_t data_length)
+        {
+            if (m_row_count == 0)
+                return 0;
+            const uint64_t tail = std::min(data_length, static_cast<uint64_t>(record_length));
+            const char* data = m_input.read(m_data_offset + data_length - tail, tail);
+            uint64_t res = 0;
+            while (res < m_row_count)
+            {
+                const uint64_t row_offset = (m_row_count - res - 1) * m_row_length;
+                if (row_offset < data_length - tail)
+                    break;
+                const char* row = data + (row_offset - (data_length - tail));
+                if (!std::all_of(row, row + m_row_length, [](char c) { return c == ' '; }))
+                    break;
+                ++res;
+            }
+            return res;
+        }
+
+        /**
+         * Returns the description of the columns. parse_meta must have been
+         * called before.
+         */
+        inline sas_schema xxport_parser::schema() const
+        {
+            sas_schema res;
+            res.names = m_colname_vec;
+            res.formats = m_colfmt_vec;
+            res.labels = m_collabel_vec;
+            res.types.reserve(m_coltype_vec.size());
+            for (auto type : m_coltype_vec)
+                res.types.push_back(type == column_type::column_type_number ? sas_column_type::number : sas_column_type::string);
+            res.row_count = static_cast<std::size_t>(m_row_count);
+            return res;
+        }
+
+        /**
+         * Decodes the selected columns and rows into two columnar buffers.
+         * The rows are read by chunks; each chunk is decoded column by
+         * column, numbers being converted by a single call to ibm_to_ieee.
+         * parse_meta must have been called before.
+         */
+        inline sas_dataset xxport_parser::parse_data(const sas_read_options& options)
+        {
+            const auto selection = select_sas_columns(m_colname_vec, options);
+            std::vector<fstring> number_names;
+            std::vector<fstring> string_names;
+            for (auto col : selection)
+            {
+                if (m_coltype_vec[col] == column_type::column_type_number)
+                    number_names.push_back(fstring(m_colname_vec[col]));
+                else
+                    string_names.push_back(fstring(m_colname_vec[col]));
+            }
+
+            const uint64_t row_end = std::min(static_cast<uint64_t>(options.row_stop), m_row_count);
+            const uint64_t row_begin = std::min(static_cast<uint64_t>(options.row_start), row_end);
+            const std::size_t row_count = static_cast<std::size_t>(row_end - row_begin);
+            xsas_columns columns(number_names.size(), string_names.size(), row_count, options);
+            const xsas_buffers buffers = columns.buffers();
+
+            std::vector<uint64_t> ibm;
+            const uint64_t chunk_row_count = std::max(static_cast<uint64_t>(chunk_length) / std::max(m_row_length, uint64_t(1)), uint64_t(1));
+            for (uint64_t first_row = row_begin; first_row < row_end; first_row += chunk_row_count)
+            {
+                const std::size_t chunk_rows = static_cast<std::size_t>(std::min(chunk_row_count, row_end - first_row));
+                const std::size_t index = static_cast<std::size_t>(first_row - row_begin);
+                const char* chunk = m_input.read(m_data_offset + first_row * m_row_length, chunk_rows * m_row_length);
+                std::size_t number_index = 0;
+                std::size_t string_index = 0;
+                for (auto col : selection)
+                {
+                    const char* field = chunk + m_coloffset_vec[col];
+                    const std::size_t length = static_cast<std::size_t>(m_collength_vec[col]);
+                    if (m_coltype_vec[col] == column_type::column_type_number)
+                    {
+                        ibm.resize(chunk_rows);
+                        for (std::size_t row = 0; row < chunk_rows; ++row, field += m_row_length)
+                        {
+                            uint64_t value = 0;
+                            for (std::size_t i = 0; i < length; ++i)
+                                value = (value << 8) | static_cast<unsigned char>(field[i]);
+                            ibm[row] = value << (8 * (8 - length));
+                        }
+                        const std::size_t start = number_index++ * row_count + index;
+                        ibm_to_ieee(ibm.data(), chunk_rows, buffers.numbers + start, buffers.number_mask + start,
+                                    buffers.missing_codes == nullptr ? nullptr : buffers.missing_codes + start);
+                    }
+                    else
+                    {
+                        decode_sas_strings(field, static_cast<std::size_t>(m_row_length), chunk_rows, length,
+                                           buffers, string_index++ * row_count + index);
+                    }
+                }
+            }
+
+            return make_sas_dataset(std::move(columns), xaxis<fstring>(std::move(number_names)), xaxis<fstring>(std::move(string_names)));
+        }
+    }
+
+    namespace detail
+    {
+        inline sas_dataset read_sas_input(xsas_input& input, const sas_format& format, const sas_read_options& options)
+        {
+            if (format == sas_format::xport)
+            {
+                xxport_parser parser(input);
+                parser.parse_meta();
+                return parser.parse_data(options);
+            }
+            xsas7bdat_parser parser(input);
+            parser.parse_meta();
+            return parser.parse_data(options);
+        }
+
+        inline sas_schema read_sas_schema_input(xsas_input& input, const sas_format& format)
+        {
+            if (format == sas_format::xport)
+            {
+                xxport_parser parser(input);
+                parser.parse_meta();
+                return parser.schema();
+            }
+            xsas7bdat_parser parser(input);
+            parser.parse_meta();
+            return parser.schema();
+        }
+    }
+
+    /**
+     * Reads the content of a SAS file from a stream.
+     * @param is the input stream, opened in binary mode.
+     * @param format the format of the file.
+     * @param options the reading options; the stream is always decoded
+     *        on the calling thread.
+     * @return the numeric and character columns of the file.
+     */
+    inline sas_dataset read_sas(std::istream& is, const sas_format& format, const sas_read_options& options)
+    {
+        detail::xsas_input input(is);
+        return detail::read_sas_input(input, format, options);
+    }
+
+    /**
+     * Reads the content of a SAS file. The file is memory-mapped when
+     * possible, so that pages are decoded in place without being copied.
+     * @param filename the name of the file.
+     * @param format the format of the file.
+     * @param options the reading options.
+     * @return the numeric and character columns of the file.
+     */
+    inline sas_dataset read_sas(const std::string& filename, const sas_format& format, const sas_read_options& options)
+    {
+        detail::xsas_input input(filename);
+        return detail::read_sas_input(input, format, options);
+    }
+
+    /**
+     * Reads the description of the columns of a SAS stream, and its number
+     * of rows, without decoding any row. Only the pages holding the column
+     * metadata are read.
+     * @param is the input stream, opened in binary mode.
+     * @param format the format of the stream.
+     * @return the names, formats, labels and types of the columns.
+     */
+    inline sas_schema read_sas_schema(std::istream& is, const sas_format& format)
+    {
+        detail::xsas_input input(is);
+        return detail::read_sas_schema_input(input, format);
+    }
+
+    /**
+     * Reads the description of the columns of a SAS file, and its number
+     * of rows, without decoding any row. Only the pages holding the column
+     * metadata are read.
+     * @param filename the name of the file.
+     * @param format the format of the file.
+     * @return the names, formats, labels and types of the columns.
+     */
+    inline sas_schema read_sas_schema(const std::string& filename, const sas_format& format)
+    {
+        detail::xsas_input input(filename);
+        return detail::read_sas_schema_input(input, format);
+    }
+
+    /**************
+     * sas_reader *
+     **************/
+
+    /**
+     * @class sas_reader
+     * @brief Sequential reader of a SAS file, by batches of rows.
+     *
+     * The rows selected by the options are decoded batch by batch, the
+     * memory used does not depend on the size of the file. All the batches
+     * have the same dimensions and column axes; the row axis of a batch is
+     * a default axis, and row_index gives the position of the next batch in
+     * the file. Decoding resumes from the page where the previous batch
+     * stopped. The thread count of the options is ignored.
+     *
+     * With dictionary-encoded strings, the dictionary is shared by all the
+     * batches: the codes of a batch index the dictionary of this batch,
+     * which extends the dictionary of the previous batches.
+     */
+    class sas_reader
+    {
+    public:
+
+        explicit sas_reader(std::istream& is, std::size_t batch_size = 65536,
+                            const sas_read_options& options = sas_read_options());
+        explicit sas_reader(const std::string& filename, std::size_t batch_size = 65536,
+                            const sas_read_options& options = sas_read_options());
+
+        sas_reader(const sas_reader&) = delete;
+        sas_reader& operator=(const sas_reader&) = delete;
+
+        std::size_t batch_size() const noexcept;
+        std::size_t row_count() const noexcept;
+        std::size_t row_index() const noexcept;
+
+        bool next(sas_dataset& batch);
+
+    private:
+
+        void init(const sas_read_options& options);
+
+        detail::xsas_input m_input;
+        detail::xsas7bdat_parser m_parser;
+        std::size_t m_batch_size;
+        xaxis<fstring> m_number_axis;
+        xaxis<fstring> m_string_axis;
+        sas_dimension_type m_dimension;
+        uint64_t m_row_begin;
+        uint64_t m_row_end;
+        uint64_t m_row_index;
+        uint64_t m_page;
+        uint64_t m_page_first_row;
+        detail::xsas_dictionary m_dictionary;
+        bool m_missing_codes;
+        bool m_string_dictionary;
+    };
+
+    /*****************************
+     * sas_reader implementation *
+     *****************************/
+
+    /**
+     * Builds a reader of a SAS7BDAT stream.
+     * @param is the input stream, opened in binary mode.
+     * @param batch_size the number of rows of a batch.
+     * @param options the columns and the rows to read.
+     */
+    inline sas_reader::sas_reader(std::istream& is, std::size_t batch_size, const sas_read_options& options)
+        : m_input(is), m_parser(m_input), m_batch_size(batch_size), m_dimension({"column", "row"}),
+          m_row_begin(0), m_row_end(0), m_row_index(0), m_page(0), m_page_first_row(0),
+          m_missing_codes(options.missing_codes), m_string_dictionary(options.string_dictionary)
+    {
+        init(options);
+    }
+
+    /**
+     * Builds a reader of a SAS7BDAT file, memory-mapped when possible.
+     * @param filename the name of the file.
+     * @param batch_size the number of rows of a batch.
+     * @param options the columns and the rows to read.
+     */
+    inline sas_reader::sas_reader(const std::string& filename, std::size_t batch_size, const sas_read_options& options)
+        : m_input(filename), m_parser(m_input), m_batch_size(batch_size), m_dimension({"column", "row"}),
+          m_row_begin(0), m_row_end(0), m_row_index(0), m_page(0), m_page_first_row(0),
+          m_missing_codes(options.missing_codes), m_string_dictionary(options.string_dictionary)
+    {
+        init(options);
+    }
+
+    /**
+     * Returns the number of rows of a batch; the last batch may be shorter.
+     */
+    inline std::size_t sas_reader::batch_size() const noexcept
+    {
+        return m_batch_size;
+    }
+
+    /**
+     * Returns the number of rows selected in the file.
+     */
+    inline std::size_t sas_reader::row_count() const noexcept
+    {
+        return static_cast<std::size_t>(m_row_end - m_row_begin);
+    }
+
+    /**
+     * Returns the index in the file of the first row of the next batch.
+     */
+    inline std::size_t sas_reader::row_index() const noexcept
+    {
+        return static_cast<std::size_t>(m_row_index);
+    }
+
+    /**
+     * Decodes the next batch of rows into batch. When batch already holds
+     * a batch of the same size, typically the previous one, its buffers are
+     * reused and nothing is allocated. The string dictionary of batch is
+     * replaced by the first batch of the reader, and extended by the next
+     * ones.
+     * @param batch the dataset receiving the rows.
+     * @return false if all the rows have been read, batch is then unchanged.
+     */
+    inline bool sas_reader::next(sas_dataset& batch)
+    {
+        if (m_row_index == m_row_end)
+            return false;
+        const uint64_t stop = std::min(m_row_index + m_batch_size, m_row_end);
+        const std::size_t row_count = static_cast<std::size_t>(stop - m_row_index);
+
+        batch.numbers.resize(coordinate<fstring>({{fstring("column"), m_number_axis},
+                                                  {fstring("row"), xaxis_default<std::size_t>(row_count)}}),
+                             m_dimension);
+        auto string_coordinate = coordinate<fstring>({{fstring("column"), m_string_axis},
+                                                      {fstring("row"), xaxis_default<std::size_t>(row_count)}});
+        auto& numbers = batch.numbers.data();
+        detail::xsas_buffers buffers = {numbers.value().data(), numbers.has_value().data(), nullptr, nullptr, nullptr, nullptr};
+        if (m_missing_codes)
+        {
+            batch.missing_codes.resize(numbers.value().shape());
+            buffers.missing_codes = batch.missing_codes.data();
+        }
+        if (m_string_dictionary)
+        {
+            batch.string_codes.resize(std::move(string_coordinate), m_dimension);
+            buffers.string_codes = batch.string_codes.data().value().data();
+            buffers.dictionary = &m_dictionary;
+        }
+        else
+        {
+            batch.strings.resize(std::move(string_coordinate), m_dimension);
+            buffers.strings = batch.strings.data().value().data();
+        }
+
+        m_parser.decode_rows(m_row_index, stop, m_page, m_page_first_row, buffers);
+
+        if (m_string_dictionary)
+        {
+            auto& codes = batch.string_codes.data();
+            codes.has_value() = xt::ones<bool>(codes.value().shape());
+            // batch may come from another reader
+            if (m_row_index == m_row_begin || batch.string_dictionary.size() > m_dictionary.size())
+                batch.string_dictionary.clear();
+            for (std::size_t i = batch.string_dictionary.size(); i < m_dictionary.size(); ++i)
+                batch.string_dictionary.push_back(m_dictionary[i]);
+        }
+        else
+        {
+            auto& strings = batch.strings.data();
+            strings.has_value() = xt::ones<bool>(strings.value().shape());
+        }
+        m_row_index = stop;
+        return true;
+    }
+
+    inline void sas_reader::init(const sas_read_options& options)
+    {
+        if (m_batch_size == 0)
+            throw std::runtime_error("sas batch size must be greater than 0");
+        m_parser.parse_meta();
+        m_parser.select(options);
+        m_number_axis = m_parser.number_axis();
+        m_string_axis = m_parser.string_axis();
+        m_row_begin = m_parser.row_begin();
+        m_row_end = m_parser.row_end();
+        m_row_index = m_row_begin;
     }
-//    inline xf::xvariable<xtl::any, xf::xcoordinate<xf::fstring>> xf::read_sas(const std::ifstream& ifs, const sas_format& format = sas_format::sas7bdata)
-//    {
-//        if (format == sas_format::sas7bdata)
-//        {
-//           detail::xsas7bdat_parser reader(ifs);
-//           return reader.parse();
-//        }
-//        else
-//        {
-
-//        }
-//        return xf::xvariable<xtl::any, xf::xcoordinate<xf::fstring>();
-//    }
 }
 
 #endif
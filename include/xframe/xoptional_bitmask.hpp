@@ -0,0 +1,360 @@
+/***************************************************************************
+* Copyright (c) Johan Mabille, Sylvain Corlay, Wolf Vollprecht and         *
+* Martin Renou                                                             *
+* Copyright (c) QuantStack                                                 *
+*                                                                          *
+* Distributed under the terms of the BSD 3-Clause License.                 *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#ifndef XFRAME_XOPTIONAL_BITMASK_HPP
+#define XFRAME_XOPTIONAL_BITMASK_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "xtl/xdynamic_bitset.hpp"
+#include "xtl/xoptional.hpp"
+
+#include "xtensor/xarray.hpp"
+#include "xtensor/xfunction.hpp"
+#include "xtensor/xnoalias.hpp"
+#include "xtensor/xoptional_assembly.hpp"
+#include "xtensor/xscalar.hpp"
+
+namespace xf
+{
+    /**
+     * Word type of the validity bitmaps.
+     */
+    using xbitmask_block = std::uint64_t;
+
+    /**
+     * Bit-packed storage of the validity flags, one bit per value.
+     */
+    using xbitmask_storage = xtl::xdynamic_bitset<xbitmask_block>;
+
+    /**
+     * N-dimensional container of validity flags backed by an xbitmask_storage.
+     */
+    using xbitmask_array = xt::xarray_container<xbitmask_storage,
+                                                XTENSOR_DEFAULT_LAYOUT,
+                                                xt::svector<std::size_t, 4>>;
+
+    /**
+     * Optional container whose missing values are tracked by a bitmap
+     * instead of an array of bool. It can be used as data container of
+     * xvariable, either directly or by setting XFRAME_USE_BITMASK to 1
+     * before including xframe headers.
+     */
+    template <class T>
+    using xbitmask_optional = xt::xoptional_assembly<xt::xarray<T>, xbitmask_array>;
+
+    void bitmask_and(xbitmask_array& lhs, const xbitmask_array& rhs);
+    void bitmask_or(xbitmask_array& lhs, const xbitmask_array& rhs);
+    std::size_t bitmask_count(const xbitmask_array& mask) noexcept;
+
+    /*******************
+     * bitmask kernels *
+     *******************/
+
+    namespace detail
+    {
+        // The loops are unrolled four words at a time and have no
+        // dependency between iterations, so that compilers turn them
+        // into vector instructions.
+
+        inline void bitmask_and_blocks(xbitmask_block* dst, const xbitmask_block* src, std::size_t n) noexcept
+        {
+            std::size_t i = 0;
+            for (; i + 4 <= n; i += 4)
+            {
+                dst[i] &= src[i];
+                dst[i + 1] &= src[i + 1];
+                dst[i + 2] &= src[i + 2];
+                dst[i + 3] &= src[i + 3];
+            }
+            for (; i < n; ++i)
+            {
+                dst[i] &= src[i];
+            }
+        }
+
+        inline void bitmask_or_blocks(xbitmask_block* dst, const xbitmask_block* src, std::size_t n) noexcept
+        {
+            std::size_t i = 0;
+            for (; i + 4 <= n; i += 4)
+            {
+                dst[i] |= src[i];
+                dst[i + 1] |= src[i + 1];
+                dst[i + 2] |= src[i + 2];
+                dst[i + 3] |= src[i + 3];
+            }
+            for (; i < n; ++i)
+            {
+                dst[i] |= src[i];
+            }
+        }
+
+        inline std::size_t popcount(xbitmask_block w) noexcept
+        {
+#if defined(__GNUC__) || defined(__clang__)
+            return static_cast<std::size_t>(__builtin_popcountll(w));
+#else
+            w = w - ((w >> 1) & 0x5555555555555555ULL);
+            w = (w & 0x3333333333333333ULL) + ((w >> 2) & 0x3333333333333333ULL);
+            w = (w + (w >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+            return static_cast<std::size_t>((w * 0x0101010101010101ULL) >> 56);
+#endif
+        }
+
+        inline std::size_t bitmask_count_blocks(const xbitmask_block* src, std::size_t n) noexcept
+        {
+            std::size_t c0 = 0, c1 = 0, c2 = 0, c3 = 0;
+            std::size_t i = 0;
+            for (; i + 4 <= n; i += 4)
+            {
+                c0 += popcount(src[i]);
+                c1 += popcount(src[i + 1]);
+                c2 += popcount(src[i + 2]);
+                c3 += popcount(src[i + 3]);
+            }
+            for (; i < n; ++i)
+            {
+                c0 += popcount(src[i]);
+            }
+            return c0 + c1 + c2 + c3;
+        }
+
+        // Sets the first n bits and clears the unused bits of the last word.
+        inline void bitmask_fill_blocks(xbitmask_block* dst, std::size_t nb_blocks, std::size_t n) noexcept
+        {
+            std::fill(dst, dst + nb_blocks, std::numeric_limits<xbitmask_block>::max());
+            const std::size_t extra = n % (8 * sizeof(xbitmask_block));
+            if (extra != 0 && nb_blocks != 0)
+            {
+                dst[nb_blocks - 1] = (xbitmask_block(1) << extra) - 1;
+            }
+        }
+
+        template <class S1, class S2>
+        inline bool same_bitmask_shape(const S1& s1, const S2& s2) noexcept
+        {
+            return s1.size() == s2.size() && std::equal(s1.cbegin(), s1.cend(), s2.cbegin());
+        }
+
+        /*********************
+         * xbitmask_gatherer *
+         *********************/
+
+        /**
+         * Collects the validity bitmaps of the operands of an optional
+         * expression. Gathering fails when an operand does not hold a
+         * bitmap of the expected shape, or when it is an optional scalar.
+         */
+        template <class S>
+        class xbitmask_gatherer
+        {
+        public:
+
+            explicit xbitmask_gatherer(const S& shape);
+
+            template <class VE>
+            bool operator()(const xt::xoptional_assembly<VE, xbitmask_array>& e);
+
+            template <class F, class... CT>
+            bool operator()(const xt::xfunction<F, CT...>& f);
+
+            template <class T>
+            bool operator()(const xt::xscalar<T>& e);
+
+            template <class E>
+            bool operator()(const E& e);
+
+            const std::vector<const xbitmask_storage*>& masks() const noexcept;
+
+        private:
+
+            template <class F, class... CT, std::size_t... I>
+            bool gather_arguments(const xt::xfunction<F, CT...>& f, std::index_sequence<I...>);
+
+            const S& m_shape;
+            std::vector<const xbitmask_storage*> m_masks;
+        };
+
+        template <class S>
+        inline xbitmask_gatherer<S>::xbitmask_gatherer(const S& shape)
+            : m_shape(shape)
+        {
+        }
+
+        template <class S>
+        template <class VE>
+        inline bool xbitmask_gatherer<S>::operator()(const xt::xoptional_assembly<VE, xbitmask_array>& e)
+        {
+            if (!same_bitmask_shape(e.has_value().shape(), m_shape))
+            {
+                return false;
+            }
+            m_masks.push_back(&(e.has_value().storage()));
+            return true;
+        }
+
+        template <class S>
+        template <class F, class... CT>
+        inline bool xbitmask_gatherer<S>::operator()(const xt::xfunction<F, CT...>& f)
+        {
+            return gather_arguments(f, std::make_index_sequence<sizeof...(CT)>());
+        }
+
+        template <class S>
+        template <class T>
+        inline bool xbitmask_gatherer<S>::operator()(const xt::xscalar<T>&)
+        {
+            return !xtl::is_xoptional<std::decay_t<T>>::value;
+        }
+
+        template <class S>
+        template <class E>
+        inline bool xbitmask_gatherer<S>::operator()(const E&)
+        {
+            return false;
+        }
+
+        template <class S>
+        inline auto xbitmask_gatherer<S>::masks() const noexcept -> const std::vector<const xbitmask_storage*>&
+        {
+            return m_masks;
+        }
+
+        template <class S>
+        template <class F, class... CT, std::size_t... I>
+        inline bool xbitmask_gatherer<S>::gather_arguments(const xt::xfunction<F, CT...>& f, std::index_sequence<I...>)
+        {
+            bool res[] = { true, (*this)(std::get<I>(f.arguments()))... };
+            return std::all_of(std::begin(res), std::end(res), [](bool b) { return b; });
+        }
+
+        /***********************
+         * assign_bitmask_data *
+         ***********************/
+
+        /**
+         * Assigns an optional expression to an optional container. Returns
+         * false when the fast path does not apply, in which case nothing
+         * has been assigned.
+         */
+        template <class D, class E>
+        inline bool assign_bitmask_data(D&, const E&)
+        {
+            return false;
+        }
+
+        template <class VE, class E>
+        inline bool assign_bitmask_data_impl(xt::xoptional_assembly<VE, xbitmask_array>& dst, const E& e)
+        {
+            xbitmask_array& dst_mask = dst.has_value();
+            xbitmask_gatherer<typename xbitmask_array::shape_type> gatherer(dst_mask.shape());
+            if (!gatherer(e))
+            {
+                return false;
+            }
+
+            xt::noalias(dst.value()) = e.value();
+
+            // The validity of an element of an optional function is the
+            // conjunction of the validities of its operands, which is
+            // computed word by word here.
+            xbitmask_storage& dst_storage = dst_mask.storage();
+            xbitmask_block* dst_blocks = dst_storage.data();
+            const std::size_t nb_blocks = dst_storage.block_count();
+            const auto& masks = gatherer.masks();
+            const bool in_place = std::find(masks.cbegin(), masks.cend(), &dst_storage) != masks.cend();
+            bool initialized = in_place;
+            for (const xbitmask_storage* m : masks)
+            {
+                if (m == &dst_storage)
+                {
+                    continue;
+                }
+                if (initialized)
+                {
+                    bitmask_and_blocks(dst_blocks, m->data(), nb_blocks);
+                }
+                else
+                {
+                    std::copy(m->data(), m->data() + nb_blocks, dst_blocks);
+                    initialized = true;
+                }
+            }
+            if (!initialized)
+            {
+                bitmask_fill_blocks(dst_blocks, nb_blocks, dst_storage.size());
+            }
+            return true;
+        }
+
+        template <class VE, class F, class... CT>
+        inline bool assign_bitmask_data(xt::xoptional_assembly<VE, xbitmask_array>& dst,
+                                        const xt::xfunction<F, CT...>& e)
+        {
+            return assign_bitmask_data_impl(dst, e);
+        }
+
+        template <class VE, class VE2>
+        inline bool assign_bitmask_data(xt::xoptional_assembly<VE, xbitmask_array>& dst,
+                                        const xt::xoptional_assembly<VE2, xbitmask_array>& e)
+        {
+            return assign_bitmask_data_impl(dst, e);
+        }
+    }
+
+    /**********************************
+     * bitmask kernels implementation *
+     **********************************/
+
+    /**
+     * Sets each flag of \c lhs to the conjunction of itself and the
+     * corresponding flag of \c rhs.
+     * @throws std::runtime_error if the shapes differ.
+     */
+    inline void bitmask_and(xbitmask_array& lhs, const xbitmask_array& rhs)
+    {
+        if (!detail::same_bitmask_shape(lhs.shape(), rhs.shape()))
+        {
+            throw std::runtime_error("bitmask_and: shapes mismatch");
+        }
+        detail::bitmask_and_blocks(lhs.storage().data(), rhs.storage().data(), lhs.storage().block_count());
+    }
+
+    /**
+     * Sets each flag of \c lhs to the disjunction of itself and the
+     * corresponding flag of \c rhs.
+     * @throws std::runtime_error if the shapes differ.
+     */
+    inline void bitmask_or(xbitmask_array& lhs, const xbitmask_array& rhs)
+    {
+        if (!detail::same_bitmask_shape(lhs.shape(), rhs.shape()))
+        {
+            throw std::runtime_error("bitmask_or: shapes mismatch");
+        }
+        detail::bitmask_or_blocks(lhs.storage().data(), rhs.storage().data(), lhs.storage().block_count());
+    }
+
+    /**
+     * Returns the number of valid values flagged in \c mask.
+     */
+    inline std::size_t bitmask_count(const xbitmask_array& mask) noexcept
+    {
+        return detail::bitmask_count_blocks(mask.storage().data(), mask.storage().block_count());
+    }
+}
+
+#endif
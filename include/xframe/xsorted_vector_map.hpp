@@ -0,0 +1,255 @@
+/***************************************************************************
+* Copyright (c) Johan Mabille, Sylvain Corlay, Wolf Vollprecht and         *
+* Martin Renou                                                             *
+* Copyright (c) QuantStack                                                 *
+*                                                                          *
+* Distributed under the terms of the BSD 3-Clause License.                 *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#ifndef XFRAME_XSORTED_VECTOR_MAP_HPP
+#define XFRAME_XSORTED_VECTOR_MAP_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace xf
+{
+    /**********************
+     * xsorted_vector_map *
+     **********************/
+
+    /**
+     * @class xsorted_vector_map
+     * @brief Associative container storing its elements in a sorted
+     * contiguous array.
+     *
+     * The xsorted_vector_map class provides the subset of the std::map
+     * interface required by xaxis. Elements are kept sorted by key in a
+     * single vector, and lookups are performed with a branch-free binary
+     * search. Inserting a key in the middle of the container is linear;
+     * the container is meant to be built at once with assign.
+     *
+     * @tparam K the type of keys.
+     * @tparam T the type of mapped values.
+     */
+    template <class K, class T>
+    class xsorted_vector_map
+    {
+    public:
+
+        using key_type = K;
+        using mapped_type = T;
+        using value_type = std::pair<key_type, mapped_type>;
+        using container_type = std::vector<value_type>;
+        using reference = const value_type&;
+        using const_reference = const value_type&;
+        using pointer = const value_type*;
+        using const_pointer = const value_type*;
+        using size_type = typename container_type::size_type;
+        using difference_type = typename container_type::difference_type;
+        using iterator = typename container_type::const_iterator;
+        using const_iterator = typename container_type::const_iterator;
+
+        bool empty() const noexcept;
+        size_type size() const noexcept;
+
+        template <class LL>
+        void assign(const LL& labels);
+        void clear() noexcept;
+
+        size_type count(const key_type& key) const;
+        const mapped_type& at(const key_type& key) const;
+        mapped_type& operator[](const key_type& key);
+
+        const_iterator find(const key_type& key) const;
+        const_iterator lower_bound(const key_type& key) const;
+
+        const_iterator begin() const noexcept;
+        const_iterator end() const noexcept;
+        const_iterator cbegin() const noexcept;
+        const_iterator cend() const noexcept;
+
+    private:
+
+        container_type m_data;
+    };
+
+    /*************************************
+     * xsorted_vector_map implementation *
+     *************************************/
+
+    template <class K, class T>
+    inline bool xsorted_vector_map<K, T>::empty() const noexcept
+    {
+        return m_data.empty();
+    }
+
+    template <class K, class T>
+    inline auto xsorted_vector_map<K, T>::size() const noexcept -> size_type
+    {
+        return m_data.size();
+    }
+
+    /**
+     * Replaces the content of the map with the pairs label - position
+     * of the specified list. When a label appears several times, its
+     * last position is kept. If the list is sorted, the map is built
+     * with a single allocation and without any comparison sort.
+     * @param labels the list of labels.
+     */
+    template <class K, class T>
+    template <class LL>
+    inline void xsorted_vector_map<K, T>::assign(const LL& labels)
+    {
+        m_data.clear();
+        m_data.reserve(labels.size());
+        bool sorted = true;
+        for (size_type i = 0; i < labels.size(); ++i)
+        {
+            if (!m_data.empty() && !(m_data.back().first < labels[i]))
+            {
+                if (m_data.back().first == labels[i])
+                {
+                    m_data.back().second = T(i);
+                    continue;
+                }
+                sorted = false;
+            }
+            m_data.emplace_back(labels[i], T(i));
+        }
+        if (!sorted)
+        {
+            auto comp = [](const value_type& lhs, const value_type& rhs) { return lhs.first < rhs.first; };
+            std::stable_sort(m_data.begin(), m_data.end(), comp);
+            // Keeps the last occurrence of each key, as std::map::operator[] would.
+            size_type w = 0;
+            for (size_type r = 0; r < m_data.size(); ++r)
+            {
+                if (w != 0 && m_data[w - 1].first == m_data[r].first)
+                {
+                    m_data[w - 1].second = m_data[r].second;
+                }
+                else
+                {
+                    if (w != r)
+                    {
+                        m_data[w] = std::move(m_data[r]);
+                    }
+                    ++w;
+                }
+            }
+            m_data.erase(m_data.begin() + static_cast<difference_type>(w), m_data.end());
+        }
+    }
+
+    template <class K, class T>
+    inline void xsorted_vector_map<K, T>::clear() noexcept
+    {
+        m_data.clear();
+    }
+
+    template <class K, class T>
+    inline auto xsorted_vector_map<K, T>::count(const key_type& key) const -> size_type
+    {
+        return find(key) != cend() ? size_type(1) : size_type(0);
+    }
+
+    /**
+     * Returns the value mapped to the specified key.
+     * @throws std::out_of_range if the key is not found.
+     */
+    template <class K, class T>
+    inline auto xsorted_vector_map<K, T>::at(const key_type& key) const -> const mapped_type&
+    {
+        auto it = find(key);
+        if (it == cend())
+        {
+            throw std::out_of_range("xsorted_vector_map::at");
+        }
+        return it->second;
+    }
+
+    /**
+     * Returns the value mapped to the specified key, inserting a default
+     * constructed value if the key is not found. Appending a key greater
+     * than all the keys of the map is amortized constant.
+     */
+    template <class K, class T>
+    inline auto xsorted_vector_map<K, T>::operator[](const key_type& key) -> mapped_type&
+    {
+        if (m_data.empty() || m_data.back().first < key)
+        {
+            m_data.emplace_back(key, mapped_type());
+            return m_data.back().second;
+        }
+        auto pos = m_data.begin() + (lower_bound(key) - m_data.cbegin());
+        if (pos->first == key)
+        {
+            return pos->second;
+        }
+        return m_data.emplace(pos, key, mapped_type())->second;
+    }
+
+    template <class K, class T>
+    inline auto xsorted_vector_map<K, T>::find(const key_type& key) const -> const_iterator
+    {
+        auto it = lower_bound(key);
+        return (it != cend() && it->first == key) ? it : cend();
+    }
+
+    /**
+     * Returns an iterator to the first element whose key is not less
+     * than the specified key. The search halves the range at each step
+     * without branching on the result of the comparison, so that the
+     * compiler can emit conditional moves.
+     */
+    template <class K, class T>
+    inline auto xsorted_vector_map<K, T>::lower_bound(const key_type& key) const -> const_iterator
+    {
+        size_type n = m_data.size();
+        if (n == 0)
+        {
+            return cend();
+        }
+        const value_type* base = m_data.data();
+        while (n > 1)
+        {
+            size_type half = n / 2;
+            base = (base[half - 1].first < key) ? base + half : base;
+            n -= half;
+        }
+        size_type index = static_cast<size_type>(base - m_data.data()) + size_type(base->first < key);
+        return cbegin() + static_cast<difference_type>(index);
+    }
+
+    template <class K, class T>
+    inline auto xsorted_vector_map<K, T>::begin() const noexcept -> const_iterator
+    {
+        return cbegin();
+    }
+
+    template <class K, class T>
+    inline auto xsorted_vector_map<K, T>::end() const noexcept -> const_iterator
+    {
+        return cend();
+    }
+
+    template <class K, class T>
+    inline auto xsorted_vector_map<K, T>::cbegin() const noexcept -> const_iterator
+    {
+        return m_data.cbegin();
+    }
+
+    template <class K, class T>
+    inline auto xsorted_vector_map<K, T>::cend() const noexcept -> const_iterator
+    {
+        return m_data.cend();
+    }
+}
+
+#endif
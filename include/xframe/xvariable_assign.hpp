@@ -14,6 +14,7 @@
 #include "xtensor/xassign.hpp"
 #include "xcoordinate.hpp"
 #include "xframe_expression.hpp"
+#include "xoptional_bitmask.hpp"
 
 namespace xt
 {
@@ -181,9 +182,13 @@ namespace xt
                                                                                        const xexpression<E2>& e2,
                                                                                        bool trivial)
     {
-        xexpression_assigner<xoptional_expression_tag>::assign_data(e1.derived_cast().data(),
-                                                                    e2.derived_cast().data(),
-                                                                    trivial);
+        auto& d1 = e1.derived_cast().data();
+        if (!trivial || !xf::detail::assign_bitmask_data(d1, e2.derived_cast().data()))
+        {
+            xexpression_assigner<xoptional_expression_tag>::assign_data(d1,
+                                                                        e2.derived_cast().data(),
+                                                                        trivial);
+        }
     }
 
     template <class E1, class E2>
@@ -53,7 +53,7 @@ namespace xt
         using temporary_coordinate_type = xf::xcoordinate<typename base_type::key_type,
                                                           typename base_type::label_list,
                                                           typename base_type::size_type>;
-        using temporary_data_type = xoptional_assembly<xarray<typename optional_type::value_type>, xarray<bool>>;
+        using temporary_data_type = XFRAME_DEFAULT_DATA_CONTAINER(typename optional_type::value_type);
         using temporary_type = xf::xvariable_container<temporary_coordinate_type, temporary_data_type>;
     };
 }
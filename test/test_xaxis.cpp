@@ -9,6 +9,8 @@
 ****************************************************************************/
 
 #include <cstddef>
+#include <string>
+#include <type_traits>
 #include <vector>
 #include "gtest/gtest.h"
 #include "xframe/xaxis_base.hpp"
@@ -22,6 +24,8 @@ namespace xf
     using caxis_type = xaxis<char>;
     using iaxis_type = xaxis<int>;
     using daxis_type = xaxis<double>;
+    using vaxis_type = xaxis<fstring, std::size_t, sorted_vector_tag>;
+    using faxis_type = xaxis<fstring, std::size_t, flat_hash_map_tag>;
 
     TEST(xaxis, constructors)
     {
@@ -260,6 +264,49 @@ namespace xf
         EXPECT_EQ(res3["e"], 5u);
     }
 
+    TEST(xaxis, join_unsorted_large)
+    {
+        std::size_t n = 2000;
+        std::vector<int> l1(n), l2(n);
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            l1[i] = static_cast<int>((i * 7919) % n);
+            l2[i] = static_cast<int>(n / 2 + (i * 104729) % n);
+        }
+        iaxis_type a1(l1);
+        iaxis_type a2(l2);
+
+        iaxis_type res = a1;
+        EXPECT_FALSE(merge_axes(res, a2));
+        EXPECT_FALSE(res.is_sorted());
+        EXPECT_EQ(res.size(), 3 * n / 2);
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            EXPECT_EQ(res[l1[i]], i);
+        }
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            EXPECT_TRUE(res.contains(l2[i]));
+        }
+
+        iaxis_type res2 = a1;
+        EXPECT_FALSE(intersect_axes(res2, a2));
+        EXPECT_EQ(res2.size(), n / 2);
+        for (std::size_t i = 0; i < res2.size(); ++i)
+        {
+            EXPECT_TRUE(res2.labels()[i] >= static_cast<int>(n / 2));
+        }
+
+        iaxis_type res3 = a1;
+        EXPECT_TRUE(intersect_axes(res3, res));
+        EXPECT_EQ(res3, a1);
+
+        iaxis_type a3 = { 4, 1 };
+        iaxis_type a4 = { 7, 2, 7, 5 };
+        EXPECT_FALSE(merge_axes(a3, a4));
+        EXPECT_EQ(a3, iaxis_type({ 4, 1, 7, 2, 5 }));
+    }
+
     TEST(xaxis, intersect)
     {
         axis_type a1 = { "a", "b", "d", "e" };
@@ -296,4 +343,129 @@ namespace xf
         EXPECT_EQ(a["a"], 0u);
         EXPECT_EQ(a["b"], 1u);
     }
+
+    TEST(xaxis, sorted_vector_tag)
+    {
+        vaxis_type a = { "a", "b", "d", "e" };
+        EXPECT_TRUE(a.is_sorted());
+        EXPECT_TRUE(a.contains("d"));
+        EXPECT_FALSE(a.contains("c"));
+        EXPECT_EQ(a["a"], 0u);
+        EXPECT_EQ(a["e"], 3u);
+        EXPECT_THROW(a["c"], std::out_of_range);
+        EXPECT_EQ(a.find("b")->second, 1u);
+        EXPECT_EQ(a.find("f"), a.end());
+
+        vaxis_type b = { "e", "a", "c" };
+        EXPECT_FALSE(b.is_sorted());
+        EXPECT_EQ(b["e"], 0u);
+        EXPECT_EQ(b["a"], 1u);
+        EXPECT_EQ(b["c"], 2u);
+
+        vaxis_type c = { "b", "c", "d" };
+        vaxis_type tmp = a;
+        EXPECT_FALSE(merge_axes(tmp, c));
+        EXPECT_EQ(tmp, vaxis_type({ "a", "b", "c", "d", "e" }));
+        EXPECT_EQ(tmp["c"], 2u);
+        EXPECT_EQ(tmp["e"], 4u);
+
+        tmp = a;
+        EXPECT_FALSE(intersect_axes(tmp, c));
+        EXPECT_EQ(tmp, vaxis_type({ "b", "d" }));
+        EXPECT_EQ(tmp["d"], 1u);
+        EXPECT_FALSE(tmp.contains("a"));
+
+        vaxis_type d = { "f", "a", "h", "a", "f" };
+        tmp = b;
+        EXPECT_FALSE(merge_axes(tmp, d));
+        EXPECT_EQ(tmp, vaxis_type({ "e", "a", "c", "f", "h" }));
+        EXPECT_EQ(tmp["h"], 4u);
+    }
+
+    TEST(xaxis, flat_hash_map_tag)
+    {
+        faxis_type a = { "e", "a", "d", "b" };
+        EXPECT_FALSE(a.is_sorted());
+        EXPECT_TRUE(a.contains("d"));
+        EXPECT_FALSE(a.contains("c"));
+        EXPECT_EQ(a["e"], 0u);
+        EXPECT_EQ(a["b"], 3u);
+        EXPECT_THROW(a["c"], std::out_of_range);
+        EXPECT_EQ(a.find("a")->second, 1u);
+        EXPECT_EQ(a.find("f"), a.end());
+
+        faxis_type c = { "b", "c", "d" };
+        faxis_type tmp = a;
+        EXPECT_FALSE(merge_axes(tmp, c));
+        EXPECT_EQ(tmp.size(), 5u);
+        EXPECT_TRUE(tmp.contains("c"));
+        EXPECT_EQ(tmp.labels()[tmp["c"]], "c");
+
+        std::vector<fstring> labels(1000);
+        for (std::size_t i = 0; i < labels.size(); ++i)
+        {
+            labels[i] = fstring(std::to_string(labels.size() - i));
+        }
+        faxis_type big(labels);
+        for (std::size_t i = 0; i < labels.size(); ++i)
+        {
+            EXPECT_EQ(big[labels[i]], i);
+        }
+        EXPECT_FALSE(big.contains("0"));
+    }
+
+    TEST(xaxis, lazy_index)
+    {
+        iaxis_type a = { 1, 3, 3, 7 };
+        EXPECT_TRUE(a.is_sorted());
+        EXPECT_EQ(a[3], 2u);
+        EXPECT_EQ(a.find(7)->second, 3u);
+        EXPECT_THROW(a[4], std::out_of_range);
+
+        iaxis_type b = { 5, 2, 8 };
+        iaxis_type b2 = b;
+        EXPECT_EQ(b2[8], 2u);
+        EXPECT_EQ(b[2], 1u);
+        iaxis_type b3 = b;
+        EXPECT_EQ(b3[5], 0u);
+        iaxis_type b4(std::move(b3));
+        EXPECT_EQ(b4[2], 1u);
+        EXPECT_TRUE(std::is_nothrow_move_constructible<iaxis_type>::value);
+        EXPECT_TRUE(std::is_nothrow_move_assignable<iaxis_type>::value);
+
+        iaxis_type c = { 8, 5, 9 };
+        EXPECT_TRUE(b.contains(2));
+        EXPECT_FALSE(intersect_axes(b, c));
+        EXPECT_FALSE(b.contains(2));
+        EXPECT_EQ(b[8], 1u);
+    }
+
+    TEST(xaxis, index_of)
+    {
+        std::vector<std::size_t> pos;
+        iaxis_type a = { 1, 3, 3, 7, 9 };
+        a.index_of(std::vector<int>({ 1, 3, 9 }), pos);
+        EXPECT_EQ(std::vector<std::size_t>({ 0, 2, 4 }), pos);
+        a.index_of(std::vector<int>({ 9, 7, 1 }), pos);
+        EXPECT_EQ(std::vector<std::size_t>({ 4, 3, 0 }), pos);
+        EXPECT_THROW(a.index_of(std::vector<int>({ 1, 4 }), pos), std::out_of_range);
+
+        axis_type b = { "d", "a", "c" };
+        b.index_of(label_type({ "a", "c", "d", "a" }), pos);
+        EXPECT_EQ(std::vector<std::size_t>({ 1, 2, 0, 1 }), pos);
+        EXPECT_THROW(b.index_of(label_type({ "b" }), pos), std::out_of_range);
+
+        std::vector<fstring> labels(100);
+        for (std::size_t i = 0; i < labels.size(); ++i)
+        {
+            labels[i] = fstring(std::to_string(labels.size() - i));
+        }
+        faxis_type c(labels);
+        c.index_of(labels, pos);
+        EXPECT_EQ(labels.size(), pos.size());
+        for (std::size_t i = 0; i < labels.size(); ++i)
+        {
+            EXPECT_EQ(pos[i], i);
+        }
+    }
 }
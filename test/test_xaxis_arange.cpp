@@ -0,0 +1,216 @@
+/***************************************************************************
+* Copyright (c) Johan Mabille, Sylvain Corlay, Wolf Vollprecht and         *
+* Martin Renou                                                             *
+* Copyright (c) QuantStack                                                 *
+*                                                                          *
+* Distributed under the terms of the BSD 3-Clause License.                 *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include <cstddef>
+#include <vector>
+#include "gtest/gtest.h"
+
+#include "xframe/xframe_config.hpp"
+#include "xframe/xaxis_arange.hpp"
+#include "xframe/xaxis_variant.hpp"
+
+namespace xf
+{
+    using axis_type = xaxis<int>;
+    using axis_arange_type = xaxis_arange<int>;
+    using axis_arange_double_type = xaxis_arange<double>;
+    using axis_variant_type = xaxis_variant<XFRAME_DEFAULT_LABEL_LIST, std::size_t>;
+
+    TEST(xaxis_arange, arange_axis)
+    {
+        auto a = arange_axis(2, 11, 3);
+        EXPECT_EQ(3u, a.size());
+        EXPECT_EQ(2, a.start());
+        EXPECT_EQ(3, a.step());
+        EXPECT_EQ(2, a.labels()[0]);
+        EXPECT_EQ(5, a.labels()[1]);
+        EXPECT_EQ(8, a.labels()[2]);
+
+        auto a2 = arange_axis(10, 0, -4);
+        EXPECT_EQ(3u, a2.size());
+        EXPECT_EQ(2, a2.labels()[2]);
+        EXPECT_FALSE(a2.is_sorted());
+
+        auto a3 = arange_axis(0.5, 2., 0.5);
+        EXPECT_EQ(3u, a3.size());
+        EXPECT_EQ(1.5, a3.labels()[2]);
+
+        auto a4 = arange_axis(4, 2);
+        EXPECT_TRUE(a4.empty());
+    }
+
+    TEST(xaxis_arange, contains)
+    {
+        axis_arange_type a(-4, 3, 5);
+        EXPECT_TRUE(a.contains(-4));
+        EXPECT_TRUE(a.contains(2));
+        EXPECT_TRUE(a.contains(8));
+        EXPECT_FALSE(a.contains(0));
+        EXPECT_FALSE(a.contains(11));
+        EXPECT_FALSE(a.contains(-7));
+
+        xaxis_arange<std::size_t> au(3, 2, 4);
+        EXPECT_TRUE(au.contains(9));
+        EXPECT_FALSE(au.contains(1));
+        EXPECT_FALSE(au.contains(4));
+
+        axis_arange_double_type ad(0., 0.1, 10);
+        EXPECT_TRUE(ad.contains(ad.labels()[7]));
+        EXPECT_FALSE(ad.contains(0.75));
+        EXPECT_FALSE(ad.contains(-0.1));
+    }
+
+    TEST(xaxis_arange, access)
+    {
+        axis_arange_type a(-4, 3, 5);
+        EXPECT_EQ(0u, a[-4]);
+        EXPECT_EQ(2u, a[2]);
+        EXPECT_EQ(4u, a[8]);
+        EXPECT_THROW(a[3], std::out_of_range);
+        EXPECT_THROW(a[11], std::out_of_range);
+
+        axis_arange_type a2(10, -4, 3);
+        EXPECT_EQ(1u, a2[6]);
+        EXPECT_THROW(a2[14], std::out_of_range);
+    }
+
+    TEST(xaxis_arange, iterator)
+    {
+        axis_arange_type a(1, 2, 3);
+
+        auto it = a.begin();
+        EXPECT_TRUE(it == a.cbegin());
+        EXPECT_TRUE(it < a.end());
+        EXPECT_EQ(it->first, 1);
+        EXPECT_EQ(it->second, 0u);
+        ++it;
+        EXPECT_EQ(it->first, 3);
+        EXPECT_EQ(it->second, 1u);
+        it += 1;
+        EXPECT_EQ(it->first, 5);
+        ++it;
+        EXPECT_EQ(it, a.end());
+        EXPECT_EQ(3, a.end() - a.begin());
+
+        EXPECT_EQ(a.find(3)->second, 1u);
+        EXPECT_EQ(a.find(4), a.end());
+    }
+
+    TEST(xaxis_arange, merge)
+    {
+        axis_arange_type a1(0, 2, 4);
+        axis_arange_type a2(4, 2, 5);
+        axis_arange_type a3(40, 2, 2);
+        axis_arange_type a4(1, 2, 2);
+        EXPECT_TRUE(a1.can_merge(a2));
+        EXPECT_FALSE(a1.can_merge(a3));
+        EXPECT_FALSE(a1.can_merge(a4));
+
+        axis_arange_type res = a1;
+        bool t1 = res.merge(a2);
+        EXPECT_FALSE(t1);
+        EXPECT_EQ(0, res.start());
+        EXPECT_EQ(7u, res.size());
+        EXPECT_EQ(5u, res[10]);
+
+        axis_arange_type res2;
+        bool t2 = res2.merge(a2);
+        EXPECT_TRUE(t2);
+        EXPECT_EQ(a2, res2);
+
+        EXPECT_THROW(res2.merge(a3), std::runtime_error);
+    }
+
+    TEST(xaxis_arange, intersect)
+    {
+        axis_arange_type a1(0, 2, 10);
+        axis_arange_type a2(6, 2, 10);
+        axis_arange_type a3(1, 2, 10);
+        EXPECT_TRUE(a1.can_intersect(a2));
+        EXPECT_FALSE(a1.can_intersect(a3));
+
+        axis_arange_type res = a1;
+        bool t1 = res.intersect(a2);
+        EXPECT_FALSE(t1);
+        EXPECT_EQ(6, res.start());
+        EXPECT_EQ(7u, res.size());
+        EXPECT_EQ(6u, res[18]);
+
+        bool t2 = res.intersect(a1);
+        EXPECT_TRUE(t2);
+
+        axis_arange_double_type ad1(0.5, 0.25, 8);
+        axis_arange_double_type ad2(0.5, 0.25, 3);
+        EXPECT_FALSE(ad1.intersect(ad2));
+        EXPECT_EQ(ad2, ad1);
+    }
+
+    TEST(xaxis_arange, lazy_labels)
+    {
+        axis_arange_type a(2, 3, 3);
+        EXPECT_EQ(8, a.label(2));
+        EXPECT_EQ(1u, a[5]);
+        EXPECT_EQ(std::vector<int>({2, 5, 8}), a.labels());
+
+        axis_arange_type a2(a);
+        EXPECT_EQ(a.labels(), a2.labels());
+        EXPECT_EQ(a, a2);
+
+        a.merge(axis_arange_type(11, 3, 2));
+        EXPECT_EQ(std::vector<int>({2, 5, 8, 11, 14}), a.labels());
+        a.intersect(axis_arange_type(5, 3, 2));
+        EXPECT_EQ(std::vector<int>({5, 8}), a.labels());
+        EXPECT_EQ(axis_arange_type(5, 3, 2), a);
+        EXPECT_NE(a, a2);
+
+        axis_arange_type a3(4, 0, 3);
+        EXPECT_TRUE(a3.contains(4));
+        EXPECT_FALSE(a3.contains(5));
+        EXPECT_EQ(0u, a3[4]);
+
+        axis_arange_double_type ad(0.5, 0.1, 10);
+        EXPECT_EQ(9u, ad[0.5 + 9 * 0.1]);
+        EXPECT_FALSE(ad.contains(0.55));
+        EXPECT_FALSE(ad.contains(1.5));
+    }
+
+    TEST(xaxis_arange, merge_xaxis)
+    {
+        axis_type a1 = { 1, 2, 3 };
+        axis_arange_type a2(0, 2, 4);
+        axis_type res;
+        bool t = merge_axes(res, a1, a2);
+        EXPECT_FALSE(t);
+        EXPECT_EQ(6u, res.size());
+        EXPECT_EQ(res[6], 5u);
+    }
+
+    TEST(xaxis_arange, variant_merge)
+    {
+        axis_variant_type a1 = axis_variant_type(axis_arange_type(0, 1, 5));
+        axis_variant_type a2 = axis_variant_type(axis_arange_type(3, 1, 5));
+        axis_variant_type res = a1;
+        bool t1 = res.merge(a2);
+        EXPECT_FALSE(t1);
+        EXPECT_EQ(axis_variant_type(axis_arange_type(0, 1, 8)), res);
+
+        axis_variant_type res2 = a1;
+        bool t2 = res2.intersect(a2);
+        EXPECT_FALSE(t2);
+        EXPECT_EQ(axis_variant_type(axis_arange_type(3, 1, 2)), res2);
+
+        axis_variant_type a3 = axis_variant_type(axis({ 10, 12 }));
+        axis_variant_type res3 = a1;
+        bool t3 = res3.merge(a3);
+        EXPECT_FALSE(t3);
+        EXPECT_EQ(7u, res3.size());
+        EXPECT_EQ(6u, res3[12]);
+    }
+}
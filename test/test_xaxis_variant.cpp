@@ -67,4 +67,75 @@ namespace xf
         EXPECT_EQ(2u, a2);
         EXPECT_THROW(a[3], std::out_of_range);
     }
+
+    TEST(xaxis_variant, merge_default)
+    {
+        auto a = axis_variant_type(axis(3));
+        bool t1 = a.merge(axis_variant_type(axis(5)), axis_variant_type(axis(4)));
+        EXPECT_FALSE(t1);
+        EXPECT_EQ(axis_variant_type(axis(5)), a);
+
+        bool t2 = a.merge(axis_variant_type(axis({ 1, 2, 3 })));
+        EXPECT_FALSE(t2);
+        EXPECT_EQ(axis_variant_type(axis(5)), a);
+
+        bool t3 = a.merge(axis_variant_type(axis(5)));
+        EXPECT_TRUE(t3);
+
+        bool t4 = a.merge(axis_variant_type(axis({ 2, 7 })));
+        EXPECT_FALSE(t4);
+        EXPECT_EQ(6u, a.size());
+        EXPECT_EQ(5u, a[7]);
+
+        auto b = axis_variant_type(axis(3));
+        bool t5 = b.merge(axis_variant_type(axis({ 0, 0, 2 })));
+        EXPECT_FALSE(t5);
+        EXPECT_EQ(4u, b.size());
+        EXPECT_EQ(3u, b[2]);
+    }
+
+    TEST(xaxis_variant, intersect_default)
+    {
+        auto a = axis_variant_type(axis(5));
+        bool t1 = a.intersect(axis_variant_type(axis(7)));
+        EXPECT_TRUE(t1);
+        EXPECT_EQ(axis_variant_type(axis(5)), a);
+
+        bool t2 = a.intersect(axis_variant_type(axis(4)));
+        EXPECT_FALSE(t2);
+        EXPECT_EQ(axis_variant_type(axis(4)), a);
+
+        bool t3 = a.intersect(axis_variant_type(axis({ 0, 1, 2, 9 })));
+        EXPECT_FALSE(t3);
+        EXPECT_EQ(axis_variant_type(axis(3)), a);
+
+        bool t4 = a.intersect(axis_variant_type(axis({ -1, 1, 2 })));
+        EXPECT_FALSE(t4);
+        EXPECT_EQ(2u, a.size());
+        EXPECT_EQ(0u, a[1]);
+        EXPECT_FALSE(a.contains(0));
+
+        auto b = axis_variant_type(axis(3));
+        bool t5 = b.intersect(axis_variant_type(axis({ 0, 0, 2 })));
+        EXPECT_FALSE(t5);
+        EXPECT_EQ(axis_variant_type(axis({ 0, 2 })), b);
+    }
+
+    TEST(xaxis_variant, index_of)
+    {
+        using key_type = axis_variant_type::key_type;
+        std::vector<key_type> keys = { key_type(7), key_type(2), key_type(5) };
+        std::vector<std::size_t> pos;
+
+        auto a = axis_variant_type(axis({ 5, 2, 7 }));
+        a.index_of(keys, pos);
+        EXPECT_EQ(std::vector<std::size_t>({ 2, 1, 0 }), pos);
+
+        auto b = axis_variant_type(axis(8));
+        b.index_of(keys, pos);
+        EXPECT_EQ(std::vector<std::size_t>({ 7, 2, 5 }), pos);
+
+        keys.push_back(key_type(9));
+        EXPECT_THROW(b.index_of(keys, pos), std::out_of_range);
+    }
 }
@@ -56,6 +56,21 @@ namespace xf
         EXPECT_EQ(res3["e"], 5u);
     }
 
+    TEST(xdimension, broadcast_disjoint)
+    {
+        dimension_type d1 = { "a", "b" };
+        dimension_type d2 = { "x", "c" };
+
+        dimension_type res;
+        bool t = broadcast_dimensions(res, d1, d2);
+        EXPECT_FALSE(t);
+        EXPECT_EQ(res.size(), 4u);
+        EXPECT_EQ(res["a"], 0u);
+        EXPECT_EQ(res["b"], 1u);
+        EXPECT_EQ(res["x"], 2u);
+        EXPECT_EQ(res["c"], 3u);
+    }
+
     TEST(xdimension, builder)
     {
         dimension_type d1 = { "a", "b", "c" };
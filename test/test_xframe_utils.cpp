@@ -64,5 +64,43 @@ namespace xf
         EXPECT_FALSE(res3);
     }
 
+    TEST(xframe_utils, merge_to_duplicates)
+    {
+        std::vector<int> v1 = { 2, 2, 3 };
+        std::vector<int> v2 = { 2, 2, 3 };
+        bool res1 = merge_to(v1, v2);
+        EXPECT_EQ(v1, v2);
+        EXPECT_TRUE(res1);
+
+        std::vector<int> v3 = { 1, 2, 3, 3 };
+        std::vector<int> v4 = { 2, 2, 2, 3, 4 };
+        std::vector<int> vres = { 1, 2, 2, 2, 3, 3, 4 };
+        bool res2 = merge_to(v3, v4);
+        EXPECT_EQ(v3, vres);
+        EXPECT_FALSE(res2);
+    }
+
+    TEST(xframe_utils, intersect_to_duplicates)
+    {
+        std::vector<int> v1 = { 1, 1, 3 };
+        std::vector<int> v2 = { 1, 3 };
+        std::vector<int> vres = { 1, 3 };
+        bool res1 = intersect_to(v1, v2);
+        EXPECT_EQ(v1, vres);
+        EXPECT_FALSE(res1);
+
+        std::vector<int> v3 = { 1, 2, 2, 2, 3, 3 };
+        std::vector<int> v4 = { 2, 2, 3, 3, 3 };
+        std::vector<int> v5 = { 2, 2, 2, 3 };
+        std::vector<int> vres2 = { 2, 2, 3 };
+        bool res2 = intersect_to(v3, v4, v5);
+        EXPECT_EQ(v3, vres2);
+        EXPECT_FALSE(res2);
+
+        std::vector<int> v6 = { 2, 2, 3 };
+        bool res3 = intersect_to(v6, v6);
+        EXPECT_EQ(v6, std::vector<int>({ 2, 2, 3 }));
+        EXPECT_TRUE(res3);
+    }
 }
 
@@ -0,0 +1,180 @@
+/***************************************************************************
+* Copyright (c) Johan Mabille, Sylvain Corlay, Wolf Vollprecht and         *
+* Martin Renou                                                             *
+* Copyright (c) QuantStack                                                 *
+*                                                                          *
+* Distributed under the terms of the BSD 3-Clause License.                 *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include <regex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "test_fixture.hpp"
+#include "xframe/xio.hpp"
+
+namespace xf
+{
+    using repr_index_type = std::vector<std::size_t>;
+
+    /**
+     * Variable recording the positions of the elements accessed through
+     * element and select.
+     */
+    class xrepr_counter
+    {
+    public:
+
+        using data_type = variable_type::data_type;
+        using value_type = variable_type::value_type;
+        using const_reference = variable_type::const_reference;
+        using shape_type = variable_type::shape_type;
+        template <std::size_t N = dynamic()>
+        using index_type = repr_index_type;
+        template <std::size_t N = dynamic()>
+        using selector_sequence_type = variable_type::selector_sequence_type<N>;
+
+        explicit xrepr_counter(const variable_type& v)
+            : m_v(v)
+        {
+        }
+
+        std::size_t dimension() const { return m_v.dimension(); }
+        const shape_type& shape() const { return m_v.shape(); }
+        decltype(auto) dimension_mapping() const { return m_v.dimension_mapping(); }
+        decltype(auto) coordinates() const { return m_v.coordinates(); }
+
+        const_reference element(const index_type<>& index) const
+        {
+            accesses.push_back(index);
+            return m_v.data().element(index.cbegin(), index.cend());
+        }
+
+        const_reference select(selector_sequence_type<>&& selector) const
+        {
+            repr_index_type index;
+            for (const auto& sel : selector)
+                index.push_back(m_v.coordinates()[sel.first][sel.second]);
+            accesses.push_back(index);
+            return m_v.select(std::move(selector));
+        }
+
+        mutable std::vector<repr_index_type> accesses;
+
+    private:
+
+        const variable_type& m_v;
+    };
+
+    // Prints the values in the order they are given
+    struct xrepr_printer
+    {
+        template <class T>
+        void update(const T& value)
+        {
+            values.push_back(value.value());
+        }
+
+        void print_next(std::ostream& out)
+        {
+            out << values[next++];
+        }
+
+        std::vector<double> values;
+        std::size_t next = 0;
+    };
+
+    // x: { 0, ..., 19 }, y: { 0, ..., 29 }, z: { 0, ..., 39 }
+    // data(x, y, z) = 1200 * x + 40 * y + z
+    inline variable_type make_repr_variable()
+    {
+        data_type d = data_type::from_shape({20, 30, 40});
+        for (std::size_t x = 0; x < 20; ++x)
+        {
+            for (std::size_t y = 0; y < 30; ++y)
+            {
+                for (std::size_t z = 0; z < 40; ++z)
+                {
+                    d(x, y, z) = static_cast<double>(1200 * x + 40 * y + z);
+                }
+            }
+        }
+        auto c = coordinate<fstring>({
+            {fstring("x"), axis(20)},
+            {fstring("y"), axis(30)},
+            {fstring("z"), axis(40)}
+        });
+        return variable_type(std::move(d), std::move(c), dimension_type({"x", "y", "z"}));
+    }
+
+    // The displayed positions in row-major order
+    inline std::vector<repr_index_type> make_repr_positions()
+    {
+        std::vector<repr_index_type> res;
+        for (std::size_t x : {0, 1, 2, 17, 18, 19})
+        {
+            for (std::size_t y : {0, 1, 2, 27, 28, 29})
+            {
+                for (std::size_t z : {0, 1, 2, 37, 38, 39})
+                {
+                    res.push_back({x, y, z});
+                }
+            }
+        }
+        return res;
+    }
+
+    // Checks that each cell of the table holds the value of its labels
+    inline void check_repr_table(const std::string& table, std::size_t cell_count)
+    {
+        const std::regex cell("title='\\(x: (\\d+), y: (\\d+), z: (\\d+)\\)'><pre>(\\d+)</pre>");
+        std::size_t count = 0;
+        for (std::sregex_iterator it(table.cbegin(), table.cend(), cell), end; it != end; ++it, ++count)
+        {
+            const std::size_t x = std::stoul((*it)[1]);
+            const std::size_t y = std::stoul((*it)[2]);
+            const std::size_t z = std::stoul((*it)[3]);
+            EXPECT_EQ(std::stoul((*it)[4]), 1200 * x + 40 * y + z);
+        }
+        EXPECT_EQ(count, cell_count);
+    }
+
+    TEST(xio, repr_element_count)
+    {
+        const variable_type v = make_repr_variable();
+        xrepr_counter counter(v);
+        xrepr_printer printer;
+        const std::size_t edge_items = 3;
+        detail::update_repr_printer(printer, counter, edge_items);
+
+        // (2 * edge_items)^3 elements out of 24000
+        EXPECT_EQ(counter.accesses.size(), 216u);
+        EXPECT_EQ(counter.accesses, make_repr_positions());
+
+        std::stringstream out;
+        compute_nd_table(out, printer, counter, edge_items);
+        EXPECT_EQ(printer.next, 216u);
+        check_repr_table(out.str(), 216u);
+    }
+
+    TEST(xio, repr_select_count)
+    {
+        const variable_type v = make_repr_variable();
+        xrepr_counter counter(v);
+        detail::xselect_repr<xrepr_counter> repr(counter);
+        EXPECT_EQ(repr.shape(), (std::vector<std::size_t>{20, 30, 40}));
+        xrepr_printer printer;
+        const std::size_t edge_items = 3;
+        detail::update_repr_printer(printer, repr, edge_items);
+
+        EXPECT_EQ(counter.accesses, make_repr_positions());
+
+        std::stringstream out;
+        compute_nd_table(out, printer, repr, edge_items);
+        check_repr_table(out.str(), 216u);
+    }
+}
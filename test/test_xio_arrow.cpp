@@ -0,0 +1,255 @@
+/***************************************************************************
+* Copyright (c) Johan Mabille, Sylvain Corlay, Wolf Vollprecht and         *
+* Martin Renou                                                             *
+* Copyright (c) QuantStack                                                 *
+*                                                                          *
+* Distributed under the terms of the BSD 3-Clause License.                 *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "test_fixture.hpp"
+#include "xframe/xio_arrow.hpp"
+
+namespace xf
+{
+    using float_data_type = xt::xoptional_assembly<xt::xarray<float>, xt::xarray<bool>>;
+    using float_variable_type = xvariable_container<coordinate_type, float_data_type>;
+
+    // column: { "x", "y" }
+    // row: { 0, ..., n - 1 }
+    // data = {{ 0.5, 1.5, ... },
+    //         { N/A, 2.5, ... }}
+    inline float_variable_type make_arrow_float_variable(std::size_t n)
+    {
+        float_data_type d = float_data_type::from_shape({2, n});
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            d(0, i) = static_cast<float>(i) + 0.5f;
+            d(1, i) = static_cast<float>(i) + 1.5f;
+        }
+        d(1, 0).has_value() = false;
+        auto c = coordinate<fstring>({
+            {fstring("column"), saxis_type({"x", "y"})},
+            {fstring("row"), axis(n)}
+        });
+        return float_variable_type(std::move(d), std::move(c), dimension_type({"column", "row"}));
+    }
+
+    inline std::string read_arrow_bytes(const char* filename)
+    {
+        std::ifstream in(filename, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    // Written by pyarrow 26.0.0, in two record batches of two rows:
+    // pa.table({"index": ["a", "b", "c", "d"],
+    //           "x": pa.array([0.5, None, 2.5, 3.5], pa.float64()),
+    //           "y": pa.array([1, 2, None, 4], pa.int32())})
+    const unsigned char reference_arrow_file[] = {
+        0x41, 0x52, 0x52, 0x4f, 0x57, 0x31, 0x00, 0x00, 0xff, 0xff, 0xff, 0xff, 0xd8, 0x00, 0x00, 0x00,
+        0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0a, 0x00, 0x0c, 0x00, 0x06, 0x00, 0x05, 0x00, 0x08, 0x00,
+        0x0a, 0x00, 0x00, 0x00, 0x00, 0x01, 0x04, 0x00, 0x0c, 0x00, 0x00, 0x00, 0x08, 0x00, 0x08, 0x00,
+        0x00, 0x00, 0x04, 0x00, 0x08, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00,
+        0x7c, 0x00, 0x00, 0x00, 0x3c, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00, 0xa0, 0xff, 0xff, 0xff,
+        0x00, 0x00, 0x01, 0x02, 0x10, 0x00, 0x00, 0x00, 0x1c, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x79, 0x00, 0x00, 0x00, 0x08, 0x00, 0x0c, 0x00,
+        0x08, 0x00, 0x07, 0x00, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x20, 0x00, 0x00, 0x00,
+        0xd4, 0xff, 0xff, 0xff, 0x00, 0x00, 0x01, 0x03, 0x10, 0x00, 0x00, 0x00, 0x18, 0x00, 0x00, 0x00,
+        0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x78, 0x00, 0x06, 0x00,
+        0x08, 0x00, 0x06, 0x00, 0x06, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x00, 0x10, 0x00, 0x14, 0x00,
+        0x08, 0x00, 0x06, 0x00, 0x07, 0x00, 0x0c, 0x00, 0x00, 0x00, 0x10, 0x00, 0x10, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x01, 0x05, 0x10, 0x00, 0x00, 0x00, 0x1c, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x05, 0x00, 0x00, 0x00, 0x69, 0x6e, 0x64, 0x65, 0x78, 0x00, 0x00, 0x00,
+        0x04, 0x00, 0x04, 0x00, 0x04, 0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0xff, 0xf8, 0x00, 0x00, 0x00,
+        0x14, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0c, 0x00, 0x16, 0x00, 0x06, 0x00, 0x05, 0x00,
+        0x08, 0x00, 0x0c, 0x00, 0x0c, 0x00, 0x00, 0x00, 0x00, 0x03, 0x04, 0x00, 0x18, 0x00, 0x00, 0x00,
+        0x50, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0a, 0x00, 0x18, 0x00, 0x0c, 0x00,
+        0x04, 0x00, 0x08, 0x00, 0x0a, 0x00, 0x00, 0x00, 0x8c, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x00,
+        0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x07, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0c, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x18, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x20, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x20, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00,
+        0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x61, 0x62, 0x63, 0x64, 0x00, 0x00, 0x00, 0x00,
+        0x0d, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xe0, 0x3f,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x04, 0x40,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0c, 0x40, 0x01, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0xff, 0xf8, 0x00, 0x00, 0x00,
+        0x14, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0c, 0x00, 0x16, 0x00, 0x06, 0x00, 0x05, 0x00,
+        0x08, 0x00, 0x0c, 0x00, 0x0c, 0x00, 0x00, 0x00, 0x00, 0x03, 0x04, 0x00, 0x18, 0x00, 0x00, 0x00,
+        0x38, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0a, 0x00, 0x18, 0x00, 0x0c, 0x00,
+        0x04, 0x00, 0x08, 0x00, 0x0a, 0x00, 0x00, 0x00, 0x8c, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x00,
+        0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x07, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0c, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x18, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x18, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x28, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x30, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00,
+        0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x63, 0x64, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x04, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0c, 0x40,
+        0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00,
+        0xff, 0xff, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x00, 0x0c, 0x00, 0x14, 0x00,
+        0x06, 0x00, 0x08, 0x00, 0x0c, 0x00, 0x10, 0x00, 0x0c, 0x00, 0x00, 0x00, 0x00, 0x00, 0x04, 0x00,
+        0x4c, 0x00, 0x00, 0x00, 0x3c, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00,
+        0xe8, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x50, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x38, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x38, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x08, 0x00, 0x08, 0x00, 0x00, 0x00, 0x04, 0x00, 0x08, 0x00, 0x00, 0x00,
+        0x04, 0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00, 0x7c, 0x00, 0x00, 0x00, 0x3c, 0x00, 0x00, 0x00,
+        0x04, 0x00, 0x00, 0x00, 0xa0, 0xff, 0xff, 0xff, 0x00, 0x00, 0x01, 0x02, 0x10, 0x00, 0x00, 0x00,
+        0x1c, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00,
+        0x79, 0x00, 0x00, 0x00, 0x08, 0x00, 0x0c, 0x00, 0x08, 0x00, 0x07, 0x00, 0x08, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x01, 0x20, 0x00, 0x00, 0x00, 0xd4, 0xff, 0xff, 0xff, 0x00, 0x00, 0x01, 0x03,
+        0x10, 0x00, 0x00, 0x00, 0x18, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x01, 0x00, 0x00, 0x00, 0x78, 0x00, 0x06, 0x00, 0x08, 0x00, 0x06, 0x00, 0x06, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x02, 0x00, 0x10, 0x00, 0x14, 0x00, 0x08, 0x00, 0x06, 0x00, 0x07, 0x00, 0x0c, 0x00,
+        0x00, 0x00, 0x10, 0x00, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x05, 0x10, 0x00, 0x00, 0x00,
+        0x1c, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x05, 0x00, 0x00, 0x00,
+        0x69, 0x6e, 0x64, 0x65, 0x78, 0x00, 0x00, 0x00, 0x04, 0x00, 0x04, 0x00, 0x04, 0x00, 0x00, 0x00,
+        0x18, 0x01, 0x00, 0x00, 0x41, 0x52, 0x52, 0x4f, 0x57, 0x31
+    };
+
+    TEST(xio_arrow, round_trip_index)
+    {
+        const char* filename = "test_xio_arrow_index.arrow";
+        auto v = make_test_variable();
+        arrow_options options;
+        options.column_dimension = "abscissa";
+        options.row_dimension = "ordinate";
+        write_arrow(filename, v, options);
+        {
+            auto res = read_arrow<double>(filename, options);
+            const auto& rv = res.variable();
+            // 3 doubles per column need no padding
+            EXPECT_TRUE(res.is_mapped());
+            EXPECT_EQ(rv.coordinates()["abscissa"], v.coordinates()["abscissa"]);
+            EXPECT_EQ(rv.coordinates()["ordinate"], v.coordinates()["ordinate"]);
+            EXPECT_EQ(rv.dimension_labels(), v.dimension_labels());
+            for (auto a : {"a", "c", "d"})
+            {
+                for (int o : {1, 2, 4})
+                {
+                    EXPECT_EQ(rv.locate(a, o).has_value(), v.locate(a, o).has_value());
+                    if (v.locate(a, o).has_value())
+                    {
+                        EXPECT_EQ(rv.locate(a, o).value(), v.locate(a, o).value());
+                    }
+                }
+            }
+        }
+        std::remove(filename);
+    }
+
+    TEST(xio_arrow, round_trip_padding)
+    {
+        const char* filename = "test_xio_arrow_padding.arrow";
+        arrow_options options;
+        options.index_column = "";
+        for (std::size_t n : {std::size_t(3), std::size_t(4)})
+        {
+            auto v = make_arrow_float_variable(n);
+            write_arrow(filename, v, options);
+            {
+                auto res = read_arrow<float>(filename, options);
+                const auto& rv = res.variable();
+                // an odd number of floats is padded, the columns are copied
+                EXPECT_EQ(res.is_mapped(), n % 2 == 0);
+                EXPECT_EQ(rv.coordinates()["row"].size(), n);
+                for (std::size_t i = 0; i < n; ++i)
+                {
+                    EXPECT_EQ(rv.locate("x", i), v.locate("x", i));
+                    EXPECT_EQ(rv.locate("y", i).has_value(), i != 0);
+                    if (i != 0)
+                    {
+                        EXPECT_EQ(rv.locate("y", i).value(), v.locate("y", i).value());
+                    }
+                }
+            }
+            {
+                auto res = read_arrow<double>(filename, options);
+                EXPECT_FALSE(res.is_mapped());
+                EXPECT_EQ(res.variable().locate("x", std::size_t(n - 1)).value(), static_cast<double>(n) - 0.5);
+                EXPECT_FALSE(res.variable().locate("y", std::size_t(0)).has_value());
+            }
+        }
+        std::remove(filename);
+    }
+
+    TEST(xio_arrow, round_trip_dynamic)
+    {
+        const char* filename = "test_xio_arrow_dynamic.arrow";
+        const char* dynamic_filename = "test_xio_arrow_dynamic2.arrow";
+        auto v = make_test_variable();
+        arrow_options options;
+        options.column_dimension = "abscissa";
+        options.row_dimension = "ordinate";
+        write_arrow(filename, v, options);
+        write_arrow(dynamic_filename, make_dynamic<double>(v), options);
+        EXPECT_EQ(read_arrow_bytes(dynamic_filename), read_arrow_bytes(filename));
+        {
+            auto res = read_arrow<double>(dynamic_filename, options);
+            const auto& rv = res.variable();
+            EXPECT_EQ(rv.coordinates()["abscissa"], v.coordinates()["abscissa"]);
+            EXPECT_EQ(rv.coordinates()["ordinate"], v.coordinates()["ordinate"]);
+            for (auto a : {"a", "c", "d"})
+            {
+                for (int o : {1, 2, 4})
+                {
+                    EXPECT_EQ(rv.locate(a, o).has_value(), v.locate(a, o).has_value());
+                    if (v.locate(a, o).has_value())
+                    {
+                        EXPECT_EQ(rv.locate(a, o).value(), v.locate(a, o).value());
+                    }
+                }
+            }
+        }
+        std::remove(filename);
+        std::remove(dynamic_filename);
+    }
+
+    TEST(xio_arrow, reference_file)
+    {
+        const char* filename = "test_xio_arrow_reference.arrow";
+        {
+            std::ofstream out(filename, std::ios::binary);
+            out.write(reinterpret_cast<const char*>(reference_arrow_file), sizeof(reference_arrow_file));
+        }
+        {
+            auto res = read_arrow<double>(filename);
+            const auto& rv = res.variable();
+            // two record batches are copied
+            EXPECT_FALSE(res.is_mapped());
+            EXPECT_EQ(rv.coordinates()["column"], coordinate_type::axis_type(saxis_type({"x", "y"})));
+            EXPECT_EQ(rv.coordinates()["row"], coordinate_type::axis_type(saxis_type({"a", "b", "c", "d"})));
+            EXPECT_EQ(rv.locate("x", "a").value(), 0.5);
+            EXPECT_FALSE(rv.locate("x", "b").has_value());
+            EXPECT_EQ(rv.locate("x", "c").value(), 2.5);
+            EXPECT_EQ(rv.locate("x", "d").value(), 3.5);
+            EXPECT_EQ(rv.locate("y", "a").value(), 1.);
+            EXPECT_EQ(rv.locate("y", "b").value(), 2.);
+            EXPECT_FALSE(rv.locate("y", "c").has_value());
+            EXPECT_EQ(rv.locate("y", "d").value(), 4.);
+        }
+        std::remove(filename);
+    }
+}
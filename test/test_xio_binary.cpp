@@ -0,0 +1,105 @@
+/***************************************************************************
+* Copyright (c) Johan Mabille, Sylvain Corlay, Wolf Vollprecht and         *
+* Martin Renou                                                             *
+* Copyright (c) QuantStack                                                 *
+*                                                                          *
+* Distributed under the terms of the BSD 3-Clause License.                 *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include <cstdio>
+#include <fstream>
+
+#include "gtest/gtest.h"
+#include "test_fixture.hpp"
+#include "xframe/xio_binary.hpp"
+
+namespace xf
+{
+    // Overwrites the 4 bytes at offset in a file
+    inline void patch_binary_file(const char* filename, std::size_t offset, uint32_t value)
+    {
+        std::fstream f(filename, std::ios::in | std::ios::out | std::ios::binary);
+        f.seekp(static_cast<std::streamoff>(offset));
+        f.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    TEST(xio_binary, round_trip)
+    {
+        const char* filename = "test_xio_binary.xfv";
+        // string, int and default axes, two missing values
+        variable_type v(make_test_data2(), make_test_coordinate4(), dimension_type({"abscissa", "ordinate", "altitude"}));
+        save(filename, v);
+        {
+            auto res = load_mmap<double>(filename);
+            const auto& rv = res.variable();
+            EXPECT_EQ(rv.coordinates(), v.coordinates());
+            EXPECT_EQ(rv.dimension_mapping(), v.dimension_mapping());
+            for (auto a : {"a", "d", "e"})
+            {
+                for (int o : {1, 4, 5})
+                {
+                    for (int al : {0, 1, 2})
+                    {
+                        EXPECT_EQ(rv.locate(a, o, al).has_value(), v.locate(a, o, al).has_value());
+                        if (v.locate(a, o, al).has_value())
+                        {
+                            EXPECT_EQ(rv.locate(a, o, al).value(), v.locate(a, o, al).value());
+                        }
+                    }
+                }
+            }
+            EXPECT_FALSE(rv.locate("a", 1, 2).has_value());
+            EXPECT_FALSE(rv.locate("d", 4, 0).has_value());
+        }
+        std::remove(filename);
+    }
+
+    TEST(xio_binary, explicit_integer_axis)
+    {
+        const char* filename = "test_xio_binary_explicit.xfv";
+        // labels 0 to n - 1 in an xaxis are not turned into a default axis
+        coordinate_type c = coordinate<fstring>({
+            {fstring("abscissa"), make_test_saxis2()},
+            {fstring("ordinate"), make_test_iaxis2()},
+            {fstring("altitude"), iaxis_type({0, 1, 2})}
+        });
+        variable_type v(make_test_data2(), c, dimension_type({"abscissa", "ordinate", "altitude"}));
+        save(filename, v);
+        {
+            auto res = load_mmap<double>(filename);
+            const auto& rv = res.variable();
+            EXPECT_EQ(rv.coordinates(), v.coordinates());
+            EXPECT_NE(xtl::get_if<iaxis_type>(&rv.coordinates()["altitude"].storage()), nullptr);
+        }
+
+        variable_type dv(make_test_data2(), make_test_coordinate4(), dimension_type({"abscissa", "ordinate", "altitude"}));
+        save(filename, dv);
+        {
+            auto res = load_mmap<double>(filename);
+            EXPECT_NE(xtl::get_if<daxis_type>(&res.variable().coordinates()["altitude"].storage()), nullptr);
+        }
+        std::remove(filename);
+    }
+
+    TEST(xio_binary, corrupted_header)
+    {
+        const char* filename = "test_xio_binary_header.xfv";
+        auto v = make_test_variable();
+        save(filename, v);
+        EXPECT_THROW(load_mmap<float>(filename), std::runtime_error);
+        EXPECT_THROW(load_mmap<int>(filename), std::runtime_error);
+
+        // byte order mark, after the magic and the version
+        patch_binary_file(filename, 12, 0x04030201);
+        EXPECT_THROW(load_mmap<double>(filename), std::runtime_error);
+        patch_binary_file(filename, 12, 0x01020304);
+        EXPECT_NO_THROW(load_mmap<double>(filename));
+
+        // value type code
+        patch_binary_file(filename, 16, 0x0108);
+        EXPECT_THROW(load_mmap<double>(filename), std::runtime_error);
+        std::remove(filename);
+    }
+}
@@ -0,0 +1,135 @@
+/***************************************************************************
+* Copyright (c) Johan Mabille, Sylvain Corlay, Wolf Vollprecht and         *
+* Martin Renou                                                             *
+* Copyright (c) QuantStack                                                 *
+*                                                                          *
+* Distributed under the terms of the BSD 3-Clause License.                 *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include <cstdio>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "test_fixture.hpp"
+#include "xframe/xio_chunked.hpp"
+
+namespace xf
+{
+    // Saves make_test_variable in blocks of 2 x 2: "0.0", "0.1", "1.0", "1.1"
+    inline std::string make_test_chunked(const std::string& directory)
+    {
+        save_chunked(directory, make_test_variable(), {2, 2});
+        return directory;
+    }
+
+    inline void remove_test_chunked(const std::string& directory)
+    {
+        for (auto name : {"0.0", "0.1", "1.0", "1.1", xchunked_metadata})
+            std::remove((directory + "/" + name).c_str());
+        std::remove(directory.c_str());
+    }
+
+    TEST(xio_chunked, sub_box)
+    {
+        const std::string directory = make_test_chunked("test_xio_chunked_box");
+        auto v = make_test_variable();
+        {
+            auto cv = open_chunked<double>(directory);
+            EXPECT_EQ(cv.coordinates(), v.coordinates());
+            EXPECT_EQ(cv.dimension_mapping(), v.dimension_mapping());
+            EXPECT_EQ(cv.shape(), (std::vector<std::size_t>{3, 3}));
+
+            // element of the last, truncated block
+            EXPECT_EQ(cv.locate("d", 4).value(), v.locate("d", 4).value());
+            EXPECT_FALSE(cv.locate("c", 1).has_value());
+            EXPECT_EQ(cv.select({{"abscissa", "c"}, {"ordinate", 2}}).value(), 5.);
+            EXPECT_FALSE(cv.select({{"abscissa", "a"}, {"ordinate", 4}}).has_value());
+
+            // { "c", "d" } x { 2, 4 } spans the four blocks
+            auto view = cv.load({{"abscissa", range("c", "d")}, {"ordinate", range(2, 4)}});
+            EXPECT_EQ(view.coordinates()["abscissa"].size(), 2u);
+            EXPECT_EQ(view.coordinates()["ordinate"].size(), 2u);
+            for (auto a : {"c", "d"})
+            {
+                for (int o : {2, 4})
+                {
+                    EXPECT_EQ(view.locate(a, o), v.locate(a, o));
+                }
+            }
+            EXPECT_EQ(cv.load(), v);
+        }
+        remove_test_chunked(directory);
+    }
+
+    TEST(xio_chunked, eviction)
+    {
+        const std::string directory = make_test_chunked("test_xio_chunked_eviction");
+        {
+            auto cv = open_chunked<double>(directory, 1);
+            EXPECT_EQ(cv.locate("a", 1).value(), 1.);
+            EXPECT_EQ(cv.locate("d", 4).value(), 9.);
+
+            // "1.1" is cached, "0.0" has been evicted and must be read again
+            std::remove((directory + "/0.0").c_str());
+            EXPECT_EQ(cv.locate("d", 4).value(), 9.);
+            EXPECT_THROW(cv.locate("a", 1), std::runtime_error);
+            EXPECT_EQ(cv.locate("c", 4).value(), 6.);
+        }
+        remove_test_chunked(directory);
+    }
+
+    TEST(xio_chunked, default_axis)
+    {
+        const std::string directory = "test_xio_chunked_default";
+        // abscissa: { "a", "c", "d" }, ordinate: default axis { 0, 1, 2 }
+        auto c = coordinate<fstring>({
+            {fstring("abscissa"), make_test_saxis()},
+            {fstring("ordinate"), make_test_daxis()}
+        });
+        variable_type v(make_test_data(), std::move(c), dimension_type({"abscissa", "ordinate"}));
+        save_chunked(directory, v, {2, 2});
+        {
+            auto cv = open_chunked<double>(directory);
+            EXPECT_EQ(cv.coordinates(), v.coordinates());
+            EXPECT_EQ(cv.load(), v);
+            EXPECT_EQ(cv.load().coordinates(), cv.coordinates());
+
+            // a box that does not start at 0 has an explicit axis
+            auto shifted = cv.load({{"ordinate", range(1, 2)}});
+            EXPECT_EQ(shifted.coordinates()["ordinate"], coordinate_type::axis_type(iaxis_type({1, 2})));
+            for (auto a : {"a", "c", "d"})
+            {
+                for (int o : {1, 2})
+                {
+                    EXPECT_EQ(shifted.locate(a, o), v.locate(a, o));
+                }
+            }
+
+            // { "d", "a" } is a keep slice, { 0, 2 } a stepped range
+            auto view = cv.load({{"abscissa", xf::keep("d", "a")}, {"ordinate", range(0, 2, 2)}});
+            EXPECT_EQ(view.coordinates()["abscissa"].size(), 2u);
+            EXPECT_EQ(view.coordinates()["abscissa"][fstring("d")], 0u);
+            EXPECT_EQ(view.coordinates()["abscissa"][fstring("a")], 1u);
+            EXPECT_EQ(view.coordinates()["ordinate"].size(), 2u);
+            for (auto a : {"a", "d"})
+            {
+                for (int o : {0, 2})
+                {
+                    EXPECT_EQ(view.locate(a, o), v.locate(a, o));
+                }
+            }
+
+            // "c" is squeezed, { 2, 0, 1 } is a keep slice
+            auto squeezed = cv.load({{"abscissa", "c"}, {"ordinate", xf::keep(2, 0, 1)}});
+            EXPECT_EQ(squeezed.dimension(), 1u);
+            EXPECT_EQ(squeezed.coordinates()["ordinate"][2], 0u);
+            for (int o : {0, 1, 2})
+            {
+                EXPECT_EQ(squeezed.locate(o), v.locate("c", o));
+            }
+        }
+        remove_test_chunked(directory);
+    }
+}
@@ -0,0 +1,112 @@
+/***************************************************************************
+* Copyright (c) Johan Mabille, Sylvain Corlay, Wolf Vollprecht and         *
+* Martin Renou                                                             *
+* Copyright (c) QuantStack                                                 *
+*                                                                          *
+* Distributed under the terms of the BSD 3-Clause License.                 *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include <sstream>
+
+#include "gtest/gtest.h"
+#include "xframe/xio_csv.hpp"
+
+namespace xf
+{
+    inline csv_dataset read_csv_string(const std::string& text, const csv_read_options& options = csv_read_options())
+    {
+        std::istringstream is(text);
+        return read_csv(is, options);
+    }
+
+    TEST(xio_csv, quoted_fields)
+    {
+        auto res = read_csv_string("name,value\n\"a,b\",1\n\"say \"\"hi\"\"\",2\n\"line\nbreak\",3\n");
+        EXPECT_EQ(res.strings.coordinates()["row"].size(), 3u);
+        EXPECT_EQ(res.strings.locate("name", std::size_t(0)).value(), "a,b");
+        EXPECT_EQ(res.strings.locate("name", std::size_t(1)).value(), "say \"hi\"");
+        EXPECT_EQ(res.strings.locate("name", std::size_t(2)).value(), "line\nbreak");
+        EXPECT_EQ(res.numbers.locate("value", std::size_t(2)).value(), 3.);
+
+        EXPECT_THROW(read_csv_string("x\n\"ab\"xy\n"), std::runtime_error);
+        EXPECT_THROW(read_csv_string("x,y\n\"ab\" ,1\n"), std::runtime_error);
+        EXPECT_THROW(read_csv_string("x\nab\"c\n"), std::runtime_error);
+        EXPECT_THROW(read_csv_string("x\n\"ab\n"), std::runtime_error);
+    }
+
+    TEST(xio_csv, line_breaks)
+    {
+        auto res = read_csv_string("x,y,z\r\n1,a,\"q\"\r\n2,,\"r\"\r\n");
+        EXPECT_EQ(res.numbers.coordinates()["row"].size(), 2u);
+        EXPECT_EQ(res.numbers.locate("x", std::size_t(1)).value(), 2.);
+        EXPECT_EQ(res.strings.locate("y", std::size_t(0)).value(), "a");
+        EXPECT_EQ(res.strings.locate("z", std::size_t(0)).value(), "q");
+        EXPECT_EQ(res.strings.locate("z", std::size_t(1)).value(), "r");
+    }
+
+    TEST(xio_csv, missing_values)
+    {
+        auto res = read_csv_string("x,y\n1,a\n,\n3,c\n");
+        EXPECT_TRUE(res.numbers.locate("x", std::size_t(0)).has_value());
+        EXPECT_FALSE(res.numbers.locate("x", std::size_t(1)).has_value());
+        EXPECT_FALSE(res.strings.locate("y", std::size_t(1)).has_value());
+        EXPECT_EQ(res.strings.locate("y", std::size_t(2)).value(), "c");
+    }
+
+    TEST(xio_csv, numbers)
+    {
+        auto res = read_csv_string("a,b,c,d,e\n1.5,-2e3,nan, 1,0x10\n.25,+7,1,2,3\n");
+        const auto& numbers = res.numbers.coordinates()["column"];
+        EXPECT_EQ(numbers.size(), 2u);
+        EXPECT_EQ(res.numbers.locate("a", std::size_t(0)).value(), 1.5);
+        EXPECT_EQ(res.numbers.locate("a", std::size_t(1)).value(), 0.25);
+        EXPECT_EQ(res.numbers.locate("b", std::size_t(0)).value(), -2000.);
+        EXPECT_EQ(res.numbers.locate("b", std::size_t(1)).value(), 7.);
+        // nan, spaces and hexadecimal numbers are not numbers
+        EXPECT_EQ(res.strings.locate("c", std::size_t(0)).value(), "nan");
+        EXPECT_EQ(res.strings.locate("d", std::size_t(0)).value(), " 1");
+        EXPECT_EQ(res.strings.locate("e", std::size_t(0)).value(), "0x10");
+
+        csv_read_options options;
+        options.column_types["d"] = csv_column_type::number;
+        EXPECT_THROW(read_csv_string("a,b,c,d,e\n1.5,-2e3,nan, 1,0x10\n", options), std::runtime_error);
+    }
+
+    TEST(xio_csv, chunks)
+    {
+        // quoted line breaks and a text value in the last row, split
+        // between several chunks
+        std::ostringstream os;
+        os << "id,a,b,c\n";
+        const int n = 1000;
+        for (int i = 0; i < n; ++i)
+        {
+            os << i << ',' << i * 0.5 << ',';
+            if (i == n - 1)
+                os << "x";
+            else
+                os << i;
+            os << ",\"c\n" << i << "\"\n";
+        }
+        const std::string text = os.str();
+
+        csv_read_options options;
+        options.index_column = "id";
+        auto res = read_csv_string(text, options);
+        options.thread_count = 4;
+        auto par = read_csv_string(text, options);
+
+        EXPECT_EQ(par.numbers.coordinates()["column"].size(), 1u);
+        EXPECT_TRUE(par.numbers.coordinates()["column"].contains(fstring("a")));
+        EXPECT_TRUE(par.strings.coordinates()["column"].contains(fstring("b")));
+        EXPECT_EQ(par.numbers.coordinates()["row"].size(), std::size_t(n));
+        EXPECT_EQ(par.numbers.locate("a", 10).value(), 5.);
+        EXPECT_EQ(par.strings.locate("b", 10).value(), "10");
+        EXPECT_EQ(par.strings.locate("b", n - 1).value(), "x");
+        EXPECT_EQ(par.strings.locate("c", 500).value(), "c\n500");
+        EXPECT_EQ(par.numbers, res.numbers);
+        EXPECT_EQ(par.strings, res.strings);
+    }
+}
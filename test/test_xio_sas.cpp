@@ -0,0 +1,1024 @@
+/***************************************************************************
+* Copyright (c) Johan Mabille, Sylvain Corlay, Wolf Vollprecht and         *
+* Martin Renou                                                             *
+* Copyright (c) QuantStack                                                 *
+*                                                                          *
+* Distributed under the terms of the BSD 3-Clause License.                 *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "xframe/xio_sas.hpp"
+
+namespace xf
+{
+    using sas_bytes = std::vector<unsigned char>;
+
+    inline std::string decompress_rle(const sas_bytes& input, std::size_t length)
+    {
+        std::string res(length, '?');
+        detail::decompress_sas_rle(reinterpret_cast<const char*>(input.data()), input.size(), &res[0], length);
+        return res;
+    }
+
+    inline std::string decompress_rdc(const sas_bytes& input, std::size_t length)
+    {
+        std::string res(length, '?');
+        detail::decompress_sas_rdc(reinterpret_cast<const char*>(input.data()), input.size(), &res[0], length);
+        return res;
+    }
+
+    // Byte order, integer size and compression of a sas7bdat file built
+    // by make_sas7bdat_file
+    struct sas7bdat_layout
+    {
+        bool big_endian;
+        bool u64;
+        bool compressed;
+    };
+
+    const std::size_t sas_page_size = 1024;
+    const std::size_t sas_row_count = 40;
+    const std::size_t sas_row_length = 29;
+
+    // name, format, label, type, offset and length of the columns
+    struct sas_fixture_column
+    {
+        const char* name;
+        const char* format;
+        const char* label;
+        int type;
+        std::size_t offset;
+        std::size_t length;
+    };
+
+    const sas_fixture_column sas_fixture_columns[] = {
+        {"id", "BEST12", "Identifier", 1, 0, 8},
+        {"score", "8.2", "Score", 1, 8, 4},
+        {"flag", "", "", 1, 12, 3},
+        {"name", "$CHAR", "Name", 2, 15, 8},
+        {"city", "", "City of birth", 2, 23, 6}
+    };
+
+    // id: row
+    // score: row / 4 - 3, missing values ., ._, .A and .Z every 5 rows
+    // flag: row % 3, missing every 7 rows
+    // name: the second half of the rows meets the names in another order
+    // city: empty every 4 rows
+    inline double sas_fixture_score(std::size_t row)
+    {
+        return static_cast<double>(row) / 4 - 3;
+    }
+
+    inline char sas_fixture_score_code(std::size_t row)
+    {
+        return row % 5 == 3 ? "._AZ"[row / 5 % 4] : '\0';
+    }
+
+    inline char sas_fixture_flag_code(std::size_t row)
+    {
+        return row % 7 == 6 ? '.' : '\0';
+    }
+
+    inline std::string sas_fixture_name(std::size_t row)
+    {
+        const char* first[] = {"ann", "bob", "", "dora"};
+        const char* second[] = {"zed", "dora", "", "bob", "ann"};
+        return row < sas_row_count / 2 ? first[row % 4] : second[row % 5];
+    }
+
+    inline std::string sas_fixture_city(std::size_t row)
+    {
+        const char* cities[] = {"paris", "", "rome", "oslo"};
+        return cities[row % 4];
+    }
+
+    // Writes an integer of size bytes in the byte order of the layout
+    inline void put_sas_int(std::string& data, std::size_t pos, std::size_t size, uint64_t value, const sas7bdat_layout& layout)
+    {
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            const std::size_t shift = 8 * (layout.big_endian ? size - 1 - i : i);
+            data[pos + i] = static_cast<char>((value >> shift) & 0xFF);
+        }
+    }
+
+    // The code of a missing value is stored, complemented, in bits 40 to 47
+    // of a NaN
+    inline uint64_t sas_missing_bits(char code)
+    {
+        const uint64_t tag = code == '_' ? 0 : (code == '.' ? 1 : static_cast<uint64_t>(code - 'A' + 2));
+        return 0xFFFF000000000000ull | ((~tag & 0xFF) << 40);
+    }
+
+    // Number truncated to its length most significant bytes
+    inline std::string make_sas_number(double value, char code, std::size_t length, const sas7bdat_layout& layout)
+    {
+        uint64_t bits = 0;
+        std::memcpy(&bits, &value, sizeof(double));
+        if (code != '\0')
+            bits = sas_missing_bits(code);
+        std::string res(8, '\0');
+        put_sas_int(res, 0, 8, bits, layout);
+        return layout.big_endian ? res.substr(0, length) : res.substr(8 - length);
+    }
+
+    inline std::string make_sas_row(std::size_t row, const sas7bdat_layout& layout)
+    {
+        auto text = [](const std::string& value, std::size_t length) { return value + std::string(length - value.size(), ' '); };
+        return make_sas_number(static_cast<double>(row), '\0', 8, layout)
+            + make_sas_number(sas_fixture_score(row), sas_fixture_score_code(row), 4, layout)
+            + make_sas_number(static_cast<double>(row % 3), sas_fixture_flag_code(row), 3, layout)
+            + text(sas_fixture_name(row), 8)
+            + text(sas_fixture_city(row), 6);
+    }
+
+    // Runs of 3 bytes or more are inserted, other bytes are copied by
+    // literals of at most 16 bytes
+    inline std::string compress_sas_rle(const std::string& row)
+    {
+        std::string res;
+        std::string literal;
+        auto flush = [&res, &literal]()
+        {
+            if (!literal.empty())
+            {
+                res += static_cast<char>(0x80 | (literal.size() - 1));
+                res += literal;
+                literal.clear();
+            }
+        };
+        for (std::size_t i = 0; i < row.size();)
+        {
+            std::size_t run = 1;
+            while (i + run < row.size() && run < 17 && row[i + run] == row[i])
+                ++run;
+            if (run >= 3)
+            {
+                flush();
+                if (row[i] == ' ')
+                    res += static_cast<char>(0xE0 | (run - 2));
+                else if (row[i] == '\0')
+                    res += static_cast<char>(0xF0 | (run - 2));
+                else
+                    res += {static_cast<char>(0xC0 | (run - 3)), row[i]};
+                i += run;
+            }
+            else
+            {
+                literal += row[i++];
+                if (literal.size() == 16)
+                    flush();
+            }
+        }
+        flush();
+        return res;
+    }
+
+    // A subheader, with the compression and the type of its pointer
+    struct sas_subheader
+    {
+        std::string data;
+        int compression;
+        int type;
+    };
+
+    inline std::string make_sas_subheader(uint32_t signature, std::size_t length, const sas7bdat_layout& layout)
+    {
+        std::string res(length, '\0');
+        put_sas_int(res, 0, layout.u64 ? 8 : 4, signature, layout);
+        return res;
+    }
+
+    // Subheaders are stored from the end of the page, rows after the
+    // subheader pointers
+    inline std::string make_sas_page(uint16_t type, const std::vector<sas_subheader>& subheaders,
+                                     const std::vector<std::string>& rows, const sas7bdat_layout& layout)
+    {
+        const std::size_t int_length = layout.u64 ? 8 : 4;
+        const std::size_t bit_offset = layout.u64 ? 32 : 16;
+        const std::size_t pointer_length = layout.u64 ? 24 : 12;
+        std::string res(sas_page_size, '\0');
+        put_sas_int(res, bit_offset, 2, type, layout);
+        put_sas_int(res, bit_offset + 2, 2, rows.size(), layout);
+        put_sas_int(res, bit_offset + 4, 2, subheaders.size(), layout);
+        std::size_t end = res.size();
+        for (std::size_t i = 0; i < subheaders.size(); ++i)
+        {
+            const auto& subheader = subheaders[i];
+            end -= subheader.data.size();
+            res.replace(end, subheader.data.size(), subheader.data);
+            const std::size_t pointer = bit_offset + 8 + i * pointer_length;
+            put_sas_int(res, pointer, int_length, end, layout);
+            put_sas_int(res, pointer + int_length, int_length, subheader.data.size(), layout);
+            res[pointer + 2 * int_length] = static_cast<char>(subheader.compression);
+            res[pointer + 2 * int_length + 1] = static_cast<char>(subheader.type);
+        }
+        std::size_t offset = bit_offset + 8 + subheaders.size() * pointer_length;
+        offset += offset % 8;
+        for (const auto& row : rows)
+        {
+            res.replace(offset, row.size(), row);
+            offset += row.size();
+        }
+        return res;
+    }
+
+    // Metadata pages:
+    // - page 0: row size, column size and column text subheaders
+    // - page 1: column name and column attributes subheaders, a format and
+    //   label subheader per column
+    // Uncompressed files store rows in a mix page of 3 rows, then in data
+    // pages of 9, 0, 8, 11 and 9 rows. Compressed files store rows as
+    // subheaders of meta pages of 12, 0, 14 and 14 rows; every 5 rows, a row
+    // is stored as is.
+    inline std::string make_sas7bdat_file(const sas7bdat_layout& layout)
+    {
+        const std::size_t int_length = layout.u64 ? 8 : 4;
+        const std::size_t column_count = sizeof(sas_fixture_columns) / sizeof(sas_fixture_column);
+
+        std::string text = make_sas_subheader(0xFFFFFFFD, int_length, layout);
+        text += layout.compressed ? "    SASYZCRL" : "    ";
+        // offset and length of a string in the column text
+        auto add_text = [&text, int_length](const std::string& value)
+        {
+            const std::size_t offset = value.empty() ? 0 : text.size() - int_length;
+            text += value;
+            return std::make_pair(offset, value.size());
+        };
+
+        std::string rowsize = make_sas_subheader(0xF7F7F7F7, 16 * int_length, layout);
+        put_sas_int(rowsize, 5 * int_length, int_length, sas_row_length, layout);
+        put_sas_int(rowsize, 6 * int_length, int_length, sas_row_count, layout);
+        put_sas_int(rowsize, 15 * int_length, int_length, 3, layout);
+        std::string colsize = make_sas_subheader(0xF6F6F6F6, 3 * int_length, layout);
+        put_sas_int(colsize, int_length, int_length, column_count, layout);
+
+        const std::size_t header_length = layout.u64 ? 28 : 20;
+        const std::size_t entry_offset = layout.u64 ? 16 : 12;
+        const std::size_t attr_length = layout.u64 ? 16 : 12;
+        std::string colname = make_sas_subheader(0xFFFFFFFF, header_length + 8 * column_count, layout);
+        std::string colattr = make_sas_subheader(0xFFFFFFFC, header_length + attr_length * column_count, layout);
+        std::vector<sas_subheader> column_subheaders;
+        for (std::size_t col = 0; col < column_count; ++col)
+        {
+            const auto& column = sas_fixture_columns[col];
+            const auto name = add_text(column.name);
+            put_sas_int(colname, entry_offset + 8 * col + 2, 2, name.first, layout);
+            put_sas_int(colname, entry_offset + 8 * col + 4, 2, name.second, layout);
+            const std::size_t attr = entry_offset + attr_length * col;
+            put_sas_int(colattr, attr, int_length, column.offset, layout);
+            put_sas_int(colattr, attr + int_length, 4, column.length, layout);
+            colattr[attr + int_length + 6] = static_cast<char>(column.type);
+
+            std::string collabel = make_sas_subheader(0xFFFFFBFE, layout.u64 ? 58 : 46, layout);
+            const auto format = add_text(column.format);
+            const auto label = add_text(column.label);
+            put_sas_int(collabel, (layout.u64 ? 46 : 34) + 2, 2, format.first, layout);
+            put_sas_int(collabel, (layout.u64 ? 46 : 34) + 4, 2, format.second, layout);
+            put_sas_int(collabel, (layout.u64 ? 52 : 40) + 2, 2, label.first, layout);
+            put_sas_int(collabel, (layout.u64 ? 52 : 40) + 4, 2, label.second, layout);
+            column_subheaders.push_back({collabel, 0, 0});
+        }
+        column_subheaders.insert(column_subheaders.begin(), {{colname, 0, 0}, {colattr, 0, 0}});
+
+        std::vector<std::string> pages;
+        pages.push_back(make_sas_page(0x0000, {{rowsize, 0, 0}, {colsize, 0, 0}, {text, 0, 0}}, {}, layout));
+        pages.push_back(make_sas_page(0x0000, column_subheaders, {}, layout));
+        std::size_t row = 0;
+        if (layout.compressed)
+        {
+            for (std::size_t count : {12, 0, 14, 14})
+            {
+                std::vector<sas_subheader> rows;
+                for (std::size_t i = 0; i < count; ++i, ++row)
+                {
+                    const std::string data = make_sas_row(row, layout);
+                    const std::string compressed = compress_sas_rle(data);
+                    if (row % 5 != 4 && compressed.size() < data.size())
+                        rows.push_back({compressed, 4, 1});
+                    else
+                        rows.push_back({data, 0, 1});
+                }
+                pages.push_back(make_sas_page(0x0000, rows, {}, layout));
+            }
+        }
+        else
+        {
+            for (std::size_t count : {3, 9, 0, 8, 11, 9})
+            {
+                std::vector<std::string> rows;
+                for (std::size_t i = 0; i < count; ++i, ++row)
+                    rows.push_back(make_sas_row(row, layout));
+                if (pages.size() == 2)
+                    pages.push_back(make_sas_page(0x0200, {{make_sas_subheader(0xFFFFFFFE, 2 * int_length, layout), 0, 0}}, rows, layout));
+                else
+                    pages.push_back(make_sas_page(0x0100, {}, rows, layout));
+            }
+        }
+
+        const unsigned char magic[32] = {
+            0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+            0x00, 0x00, 0x00, 0x00, 0xc2, 0xea, 0x81, 0x60,
+            0xb3, 0x14, 0x11, 0xcf, 0xbd, 0x92, 0x08, 0x00,
+            0x09, 0xc7, 0x31, 0x8c, 0x18, 0x1f, 0x10, 0x11
+        };
+        std::string res(1024, '\0');
+        std::memcpy(&res[0], magic, sizeof(magic));
+        res[32] = res[35] = static_cast<char>(layout.u64 ? 0x33 : 0x22);
+        res[37] = static_cast<char>(layout.big_endian ? 0x00 : 0x01);
+        const std::size_t size_offset = (layout.u64 ? 4 : 0) + 196;
+        put_sas_int(res, size_offset, 4, res.size(), layout);
+        put_sas_int(res, size_offset + 4, 4, sas_page_size, layout);
+        put_sas_int(res, size_offset + 8, int_length, pages.size(), layout);
+        for (const auto& page : pages)
+            res += page;
+        return res;
+    }
+
+    inline sas_dataset read_sas_string(const std::string& data, const sas_read_options& options = sas_read_options())
+    {
+        std::istringstream is(data, std::ios::in | std::ios::binary);
+        return read_sas(is, sas_format::sas7bdat, options);
+    }
+
+    inline void write_sas_file(const char* filename, const std::string& data)
+    {
+        std::ofstream out(filename, std::ios::out | std::ios::binary);
+        out.write(data.data(), static_cast<std::streamsize>(data.size()));
+    }
+
+    // Checks the decoded rows of the fixture, the first of which is the
+    // row first of the file
+    inline void check_sas_fixture(const sas_dataset& res, std::size_t first)
+    {
+        const std::size_t row_count = res.numbers.coordinates()["row"].size();
+        for (std::size_t i = 0; i < row_count; ++i)
+        {
+            const std::size_t row = first + i;
+            EXPECT_EQ(res.numbers.locate("id", i).value(), static_cast<double>(row));
+            EXPECT_EQ(res.numbers.locate("score", i).has_value(), sas_fixture_score_code(row) == '\0');
+            if (sas_fixture_score_code(row) == '\0')
+            {
+                EXPECT_EQ(res.numbers.locate("score", i).value(), sas_fixture_score(row));
+            }
+            EXPECT_EQ(res.numbers.locate("flag", i).has_value(), sas_fixture_flag_code(row) == '\0');
+            if (sas_fixture_flag_code(row) == '\0')
+            {
+                EXPECT_EQ(res.numbers.locate("flag", i).value(), static_cast<double>(row % 3));
+            }
+            EXPECT_EQ(res.strings.locate("name", i).value(), sas_fixture_name(row));
+            EXPECT_EQ(res.strings.locate("city", i).value(), sas_fixture_city(row));
+        }
+    }
+
+    // Missing numbers are NaN, only the values that are not missing are
+    // compared
+    inline void expect_same_sas_numbers(const sas_number_variable& lhs, const sas_number_variable& rhs)
+    {
+        EXPECT_EQ(lhs.coordinates(), rhs.coordinates());
+        const auto& lhs_data = lhs.data();
+        const auto& rhs_data = rhs.data();
+        ASSERT_EQ(lhs_data.has_value(), rhs_data.has_value());
+        for (std::size_t i = 0; i < lhs_data.value().size(); ++i)
+        {
+            if (lhs_data.has_value().data()[i])
+            {
+                EXPECT_EQ(lhs_data.value().data()[i], rhs_data.value().data()[i]);
+            }
+        }
+    }
+
+    // 80-byte record of a transport file, padded with blanks
+    inline std::string xport_record(const std::string& text)
+    {
+        return text + std::string(80 - text.size(), ' ');
+    }
+
+    inline std::string xport_header(const std::string& name, const std::string& numbers)
+    {
+        return xport_record("HEADER RECORD*******" + name + std::string(8 - name.size(), ' ') + "HEADER RECORD!!!!!!!" + numbers);
+    }
+
+    // Namestr of 140 bytes, integers are big endian. The name of 32
+    // characters is only stored in version 8.
+    inline std::string xport_namestr(int type, int length, int number, const std::string& name,
+                                     const std::string& label, const std::string& format, int position,
+                                     const std::string& long_name = "")
+    {
+        std::string res(140, '\0');
+        auto put_int = [&res](std::size_t pos, std::size_t size, int value)
+        {
+            for (std::size_t i = 0; i < size; ++i)
+                res[pos + size - 1 - i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+        };
+        auto put_text = [&res](std::size_t pos, std::size_t size, const std::string& text)
+        {
+            res.replace(pos, size, text.substr(0, size) + std::string(size - std::min(size, text.size()), ' '));
+        };
+        put_int(0, 2, type);
+        put_int(4, 2, length);
+        put_int(6, 2, number);
+        put_text(8, 8, name);
+        put_text(16, 40, label);
+        put_text(56, 8, format);
+        put_int(84, 4, position);
+        if (!long_name.empty())
+            put_text(88, 32, long_name);
+        return res;
+    }
+
+    inline std::string xport_number(uint64_t ibm)
+    {
+        std::string res(8, '\0');
+        for (std::size_t i = 0; i < 8; ++i)
+            res[i] = static_cast<char>((ibm >> (56 - 8 * i)) & 0xFF);
+        return res;
+    }
+
+    const std::string xport_long_label = "Value measured at the start of the experiment, in cm";
+
+    // Entry of a label record: the column number and the lengths of the
+    // texts, followed by the texts. In version 9, the texts are the name,
+    // the label, the format and the informat.
+    inline std::string xport_label_entry(int number, const std::string& name, const std::string& label,
+                                         const std::string& format, bool v9)
+    {
+        std::string res;
+        auto put_int = [&res](std::size_t value)
+        {
+            res += {static_cast<char>((value >> 8) & 0xFF), static_cast<char>(value & 0xFF)};
+        };
+        put_int(static_cast<std::size_t>(number));
+        put_int(name.size());
+        if (v9)
+        {
+            put_int(format.size());
+            put_int(0);
+        }
+        put_int(label.size());
+        return res + name + label + (v9 ? format : "");
+    }
+
+    // columns: X, number of 8 bytes, and NAME, 4 characters
+    // rows: { 1.0, "ab" }, { -118.625, "cdef" }, { .A, "g" }
+    // In versions 8 and 9, X is named measurement_value and its label of
+    // more than 40 characters is stored in a label record; in version 9,
+    // the format of NAME is longer than 8 characters.
+    inline std::string make_xport_file(const std::string& variable_count, int version = 5)
+    {
+        const bool v8 = version != 5;
+        std::string res = xport_header(v8 ? "LIBV8" : "LIBRARY", std::string(30, '0'));
+        res += xport_record("SAS     SAS     SASLIB  9.4     Linux");
+        res += xport_record("17OCT26:10:00:00");
+        res += xport_header(v8 ? "MEMBV8" : "MEMBER", "000000000000000001600000000140");
+        res += xport_header(v8 ? "DSCPTV8" : "DSCRPTR", std::string(30, '0'));
+        res += xport_record("SAS     TEST    SASDATA 9.4     Linux");
+        res += xport_record("17OCT26:10:00:00");
+        res += xport_header(v8 ? "NAMSTV8" : "NAMESTR", "000000" + variable_count + std::string(24 - variable_count.size(), '0'));
+        std::string namestrs;
+        if (v8)
+        {
+            namestrs = xport_namestr(1, 8, 1, "measurem", xport_long_label, "", 0, "measurement_value")
+                     + xport_namestr(2, 4, 2, "NAME", "", "$CHARLON", 8, "NAME");
+        }
+        else
+        {
+            namestrs = xport_namestr(1, 8, 1, "X", "Value", "", 0)
+                     + xport_namestr(2, 4, 2, "NAME", "", "$CHAR", 8);
+        }
+        res += namestrs + std::string(320 - namestrs.size(), ' ');
+        if (v8)
+        {
+            res += xport_header(version == 9 ? "LABELV9" : "LABELV8", "00002");
+            std::string labels = xport_label_entry(1, "measurement_value", xport_long_label, "", version == 9);
+            if (version == 9)
+                labels += xport_label_entry(2, "NAME", "", "$CHARLONGFMT", true);
+            res += labels + std::string(80 - labels.size() % 80, ' ');
+        }
+        res += xport_header(v8 ? "OBSV8" : "OBS", std::string(30, '0'));
+        std::string rows = xport_number(0x4110000000000000ull) + "ab  "
+                         + xport_number(0xC276A00000000000ull) + "cdef"
+                         + xport_number(0x4100000000000000ull) + "g   ";
+        res += xport_record(rows);
+        return res;
+    }
+
+    TEST(xio_sas, rle_short_commands)
+    {
+        // copy 3, 4 times 'x', 2 blanks, 2 zeros, 3 '@'
+        const sas_bytes input = {0x82, 'a', 'b', 'c', 0xC1, 'x', 0xE0, 0xF0, 0xD1};
+        EXPECT_EQ(decompress_rle(input, 14), std::string("abcxxxx  \0\0@@@", 14));
+    }
+
+    TEST(xio_sas, rle_long_commands)
+    {
+        // copy 64, 20 times 'z', 17 blanks, 17 zeros
+        sas_bytes input = {0x00, 0x00};
+        std::string expected;
+        for (int i = 0; i < 64; ++i)
+        {
+            input.push_back(static_cast<unsigned char>('a' + i % 26));
+            expected.push_back(static_cast<char>('a' + i % 26));
+        }
+        input.insert(input.end(), {0x40, 0x02, 'z', 0x60, 0x00, 0x70, 0x00});
+        expected += std::string(20, 'z') + std::string(17, ' ') + std::string(17, '\0');
+        EXPECT_EQ(decompress_rle(input, expected.size()), expected);
+    }
+
+    TEST(xio_sas, rle_errors)
+    {
+        // truncated copy and missing argument
+        EXPECT_THROW(decompress_rle({0x82, 'a'}, 3), std::runtime_error);
+        EXPECT_THROW(decompress_rle({0xC1}, 4), std::runtime_error);
+        // unknown command
+        EXPECT_THROW(decompress_rle({0x10, 0x00}, 4), std::runtime_error);
+        // run past the end of the row, row too short
+        EXPECT_THROW(decompress_rle({0xC1, 'x'}, 3), std::runtime_error);
+        EXPECT_THROW(decompress_rle({0xC1, 'x'}, 5), std::runtime_error);
+    }
+
+    TEST(xio_sas, rdc_short_commands)
+    {
+        // control word 0001 1000 ..: 3 literals, short pattern of 3 bytes
+        // at offset 3, 5 times 'x'
+        const sas_bytes input = {0x18, 0x00, 'a', 'b', 'c', 0x30, 0x00, 0x02, 'x'};
+        EXPECT_EQ(decompress_rdc(input, 11), "abcabcxxxxx");
+    }
+
+    TEST(xio_sas, rdc_long_commands)
+    {
+        // control word 0001 1100 ..: 3 literals, short pattern of 15 bytes
+        // overlapping its source, 35 times 'y', long pattern of 16 bytes at
+        // offset 51
+        const sas_bytes input = {0x1C, 0x00, 'a', 'b', 'c', 0xF0, 0x00, 0x10, 0x01, 'y', 0x20, 0x03, 0x00};
+        const std::string expected = "abcabcabcabcabcabc" + std::string(35, 'y') + "cabcabcabcabcabc";
+        EXPECT_EQ(decompress_rdc(input, expected.size()), expected);
+    }
+
+    TEST(xio_sas, rdc_errors)
+    {
+        // back reference before the beginning of the row
+        EXPECT_THROW(decompress_rdc({0x40, 0x00, 'a', 0x30, 0x00}, 4), std::runtime_error);
+        // truncated control word and missing argument
+        EXPECT_THROW(decompress_rdc({0x80}, 3), std::runtime_error);
+        EXPECT_THROW(decompress_rdc({0x80, 0x00, 0x02}, 5), std::runtime_error);
+        // row too short
+        EXPECT_THROW(decompress_rdc({0x00, 0x00, 'a', 'b'}, 3), std::runtime_error);
+    }
+
+    TEST(xio_sas, decode_numbers)
+    {
+        const uint16_t one = 1;
+        const bool native_little_endian = *reinterpret_cast<const char*>(&one) == 1;
+        const char codes[] = {'.', '_', 'A', 'Z'};
+        for (bool big_endian : {false, true})
+        {
+            const sas7bdat_layout layout = {big_endian, false, false};
+            for (std::size_t length = 3; length <= 8; ++length)
+            {
+                // the last value has the least significant bit kept
+                const double values[] = {1.5, -118.625, 1 + std::ldexp(1., -static_cast<int>(8 * length - 12))};
+                // fields separated by 2 bytes
+                std::string data;
+                for (double value : values)
+                    data += make_sas_number(value, '\0', length, layout) + "xx";
+                for (char code : codes)
+                    data += make_sas_number(0., code, length, layout) + "xx";
+
+                double res[7];
+                bool mask[7];
+                char res_codes[7];
+                detail::decode_sas_numbers(data.data(), length + 2, 7, length, !big_endian, big_endian == native_little_endian,
+                                           res, mask, res_codes);
+                for (std::size_t i = 0; i < 3; ++i)
+                {
+                    EXPECT_TRUE(mask[i]);
+                    EXPECT_EQ(res[i], values[i]);
+                    EXPECT_EQ(res_codes[i], '\0');
+                }
+                for (std::size_t i = 0; i < 4; ++i)
+                {
+                    EXPECT_FALSE(mask[3 + i]);
+                    EXPECT_TRUE(std::isnan(res[3 + i]));
+                    EXPECT_EQ(res_codes[3 + i], codes[i]);
+                }
+
+                // the codes are optional
+                detail::decode_sas_numbers(data.data(), length + 2, 7, length, !big_endian, big_endian == native_little_endian,
+                                           res, mask, nullptr);
+                EXPECT_EQ(res[1], -118.625);
+                EXPECT_FALSE(mask[6]);
+            }
+        }
+        double value;
+        bool mask;
+        EXPECT_THROW(detail::decode_sas_numbers("123456789", 9, 1, 9, true, false, &value, &mask, nullptr), std::runtime_error);
+    }
+
+    TEST(xio_sas, sas7bdat_file)
+    {
+        const sas7bdat_layout layouts[] = {
+            {false, false, false}, {true, false, false}, {false, true, false},
+            {true, true, false}, {false, false, true}, {true, true, true}
+        };
+        for (const auto& layout : layouts)
+        {
+            const std::string data = make_sas7bdat_file(layout);
+            auto res = read_sas_string(data);
+            const auto& numbers = res.numbers.coordinates()["column"];
+            const auto& strings = res.strings.coordinates()["column"];
+            ASSERT_EQ(numbers.size(), 3u);
+            EXPECT_EQ(numbers[fstring("id")], 0u);
+            EXPECT_EQ(numbers[fstring("score")], 1u);
+            EXPECT_EQ(numbers[fstring("flag")], 2u);
+            ASSERT_EQ(strings.size(), 2u);
+            EXPECT_EQ(strings[fstring("name")], 0u);
+            EXPECT_EQ(strings[fstring("city")], 1u);
+            ASSERT_EQ(res.numbers.coordinates()["row"].size(), sas_row_count);
+            check_sas_fixture(res, 0);
+        }
+
+        // memory-mapped file
+        const char* filename = "test_xio_sas.sas7bdat";
+        write_sas_file(filename, make_sas7bdat_file({true, false, false}));
+        {
+            auto res = read_sas(filename);
+            ASSERT_EQ(res.numbers.coordinates()["row"].size(), sas_row_count);
+            check_sas_fixture(res, 0);
+        }
+        std::remove(filename);
+
+        std::string data = make_sas7bdat_file({false, false, false});
+        data[13] = 'x';
+        EXPECT_THROW(read_sas_string(data), std::runtime_error);
+    }
+
+    TEST(xio_sas, sas7bdat_schema)
+    {
+        for (bool big_endian : {false, true})
+        {
+            for (bool u64 : {false, true})
+            {
+                const std::string data = make_sas7bdat_file({big_endian, u64, false});
+                // the schema stops after the metadata pages, the rows may be
+                // truncated or garbage
+                const std::size_t meta_end = 1024 + 2 * sas_page_size;
+                const std::string truncated = data.substr(0, meta_end + sas_page_size / 2);
+                std::string garbage = data;
+                std::fill(garbage.begin() + meta_end, garbage.end(), '\xAB');
+                for (const auto& file : {data, truncated, garbage})
+                {
+                    std::istringstream is(file, std::ios::in | std::ios::binary);
+                    const sas_schema schema = read_sas_schema(is);
+                    EXPECT_EQ(schema.row_count, sas_row_count);
+                    ASSERT_EQ(schema.names.size(), 5u);
+                    ASSERT_EQ(schema.formats.size(), 5u);
+                    ASSERT_EQ(schema.labels.size(), 5u);
+                    ASSERT_EQ(schema.types.size(), 5u);
+                    for (std::size_t col = 0; col < 5; ++col)
+                    {
+                        const auto& column = sas_fixture_columns[col];
+                        EXPECT_EQ(schema.names[col], column.name);
+                        EXPECT_EQ(schema.formats[col], column.format);
+                        EXPECT_EQ(schema.labels[col], column.label);
+                        EXPECT_EQ(schema.types[col], column.type == 1 ? sas_column_type::number : sas_column_type::string);
+                    }
+                }
+                EXPECT_THROW(read_sas_string(truncated), std::runtime_error);
+            }
+        }
+
+        const char* filename = "test_xio_sas_schema.sas7bdat";
+        const std::string data = make_sas7bdat_file({false, true, true});
+        write_sas_file(filename, data.substr(0, 1024 + 2 * sas_page_size + 100));
+        const sas_schema schema = read_sas_schema(filename);
+        EXPECT_EQ(schema.row_count, sas_row_count);
+        EXPECT_EQ(schema.names, (std::vector<std::string>{"id", "score", "flag", "name", "city"}));
+        EXPECT_EQ(schema.types, (std::vector<sas_column_type>{sas_column_type::number, sas_column_type::number, sas_column_type::number,
+                                                              sas_column_type::string, sas_column_type::string}));
+        std::remove(filename);
+    }
+
+    TEST(xio_sas, sas7bdat_threads)
+    {
+        // mix page and empty data page, empty page of row subheaders
+        const char* filename = "test_xio_sas_threads.sas7bdat";
+        for (bool compressed : {false, true})
+        {
+            write_sas_file(filename, make_sas7bdat_file({false, false, compressed}));
+            sas_read_options options;
+            options.missing_codes = true;
+            auto res = read_sas(filename, sas_format::sas7bdat, options);
+            for (std::size_t thread_count : {2, 4, 16, 0})
+            {
+                options.thread_count = thread_count;
+                auto par = read_sas(filename, sas_format::sas7bdat, options);
+                expect_same_sas_numbers(par.numbers, res.numbers);
+                EXPECT_EQ(par.missing_codes, res.missing_codes);
+                EXPECT_EQ(par.strings, res.strings);
+            }
+            check_sas_fixture(res, 0);
+        }
+        std::remove(filename);
+    }
+
+    TEST(xio_sas, sas7bdat_selection)
+    {
+        const std::string data = make_sas7bdat_file({true, false, false});
+        sas_read_options options;
+        options.columns = {"city", "flag", "id"};
+        auto res = read_sas_string(data, options);
+        const auto& numbers = res.numbers.coordinates()["column"];
+        ASSERT_EQ(numbers.size(), 2u);
+        EXPECT_EQ(numbers[fstring("flag")], 0u);
+        EXPECT_EQ(numbers[fstring("id")], 1u);
+        ASSERT_EQ(res.strings.coordinates()["column"].size(), 1u);
+        for (std::size_t row = 0; row < sas_row_count; ++row)
+        {
+            EXPECT_EQ(res.numbers.locate("id", row).value(), static_cast<double>(row));
+            EXPECT_EQ(res.numbers.locate("flag", row).has_value(), sas_fixture_flag_code(row) == '\0');
+            EXPECT_EQ(res.strings.locate("city", row).value(), sas_fixture_city(row));
+        }
+
+        sas_read_options index_options;
+        index_options.column_indices = {4, 2, 0};
+        auto index_res = read_sas_string(data, index_options);
+        expect_same_sas_numbers(index_res.numbers, res.numbers);
+        EXPECT_EQ(index_res.strings, res.strings);
+
+        // row_stop is clamped to the number of rows
+        options = sas_read_options();
+        options.row_start = 5;
+        options.row_stop = 1000;
+        res = read_sas_string(data, options);
+        EXPECT_EQ(res.numbers.coordinates()["row"].size(), sas_row_count - 5);
+        check_sas_fixture(res, 5);
+        options.row_start = 45;
+        EXPECT_EQ(read_sas_string(data, options).numbers.coordinates()["row"].size(), 0u);
+
+        // ranges starting and ending within a page, on one or several threads
+        const char* filename = "test_xio_sas_selection.sas7bdat";
+        for (bool compressed : {false, true})
+        {
+            write_sas_file(filename, make_sas7bdat_file({false, false, compressed}));
+            for (std::size_t thread_count : {1, 4})
+            {
+                options.thread_count = thread_count;
+                options.row_start = 4;
+                options.row_stop = 27;
+                res = read_sas(filename, sas_format::sas7bdat, options);
+                EXPECT_EQ(res.numbers.coordinates()["row"].size(), 23u);
+                check_sas_fixture(res, 4);
+                options.row_start = 13;
+                options.row_stop = 14;
+                res = read_sas(filename, sas_format::sas7bdat, options);
+                EXPECT_EQ(res.numbers.coordinates()["row"].size(), 1u);
+                check_sas_fixture(res, 13);
+            }
+        }
+        std::remove(filename);
+
+        options = sas_read_options();
+        options.columns = {"id", "town"};
+        EXPECT_THROW(read_sas_string(data, options), std::runtime_error);
+        options.columns = {"id", "id"};
+        EXPECT_THROW(read_sas_string(data, options), std::runtime_error);
+        options.column_indices = {0};
+        EXPECT_THROW(read_sas_string(data, options), std::runtime_error);
+        options.columns.clear();
+        options.column_indices = {5};
+        EXPECT_THROW(read_sas_string(data, options), std::runtime_error);
+    }
+
+    TEST(xio_sas, sas7bdat_reader)
+    {
+        const std::string data = make_sas7bdat_file({false, true, false});
+        sas_read_options options;
+        options.missing_codes = true;
+        options.string_dictionary = true;
+        const auto res = read_sas_string(data, options);
+        const char* numbers[] = {"id", "score", "flag"};
+
+        // batches smaller and larger than a page
+        for (std::size_t batch_size : {4, 15})
+        {
+            std::istringstream is(data, std::ios::in | std::ios::binary);
+            sas_reader reader(is, batch_size, options);
+            EXPECT_EQ(reader.row_count(), sas_row_count);
+            sas_dataset batch;
+            std::size_t row = 0;
+            while (reader.next(batch))
+            {
+                const std::size_t count = batch.numbers.coordinates()["row"].size();
+                EXPECT_EQ(count, std::min(batch_size, sas_row_count - row));
+                ASSERT_TRUE(batch.string_dictionary.size() <= res.string_dictionary.size());
+                EXPECT_TRUE(std::equal(batch.string_dictionary.cbegin(), batch.string_dictionary.cend(), res.string_dictionary.cbegin()));
+                for (std::size_t i = 0; i < count; ++i, ++row)
+                {
+                    for (std::size_t col = 0; col < 3; ++col)
+                    {
+                        EXPECT_EQ(batch.numbers.locate(numbers[col], i).has_value(), res.numbers.locate(numbers[col], row).has_value());
+                        if (res.numbers.locate(numbers[col], row).has_value())
+                        {
+                            EXPECT_EQ(batch.numbers.locate(numbers[col], i).value(), res.numbers.locate(numbers[col], row).value());
+                        }
+                        EXPECT_EQ(batch.missing_codes(col, i), res.missing_codes(col, row));
+                    }
+                    const int name = batch.string_codes.locate("name", i).value();
+                    EXPECT_EQ(name, res.string_codes.locate("name", row).value());
+                    EXPECT_EQ(batch.string_dictionary[static_cast<std::size_t>(name)], sas_fixture_name(row));
+                    EXPECT_EQ(batch.string_codes.locate("city", i).value(), res.string_codes.locate("city", row).value());
+                }
+                EXPECT_EQ(reader.row_index(), row);
+            }
+            EXPECT_EQ(row, sas_row_count);
+            EXPECT_FALSE(reader.next(batch));
+        }
+
+        // strings, from a memory-mapped file
+        const char* filename = "test_xio_sas_reader.sas7bdat";
+        write_sas_file(filename, data);
+        {
+            sas_reader reader(filename, 7);
+            sas_dataset batch;
+            std::size_t row = 0;
+            while (reader.next(batch))
+            {
+                check_sas_fixture(batch, row);
+                row += batch.numbers.coordinates()["row"].size();
+            }
+            EXPECT_EQ(row, sas_row_count);
+        }
+        std::remove(filename);
+
+        // a batch of another reader, whose dictionary is shorter, then longer
+        sas_read_options city_options;
+        city_options.columns = {"city"};
+        city_options.string_dictionary = true;
+        sas_read_options name_options = city_options;
+        name_options.columns = {"name"};
+        std::istringstream city_is(data, std::ios::in | std::ios::binary);
+        std::istringstream name_is(data, std::ios::in | std::ios::binary);
+        std::istringstream other_city_is(data, std::ios::in | std::ios::binary);
+        sas_reader city_reader(city_is, 100, city_options);
+        sas_reader name_reader(name_is, 100, name_options);
+        sas_reader other_city_reader(other_city_is, 100, city_options);
+        sas_dataset batch;
+        ASSERT_TRUE(city_reader.next(batch));
+        EXPECT_EQ(batch.string_dictionary.size(), 4u);
+        ASSERT_TRUE(name_reader.next(batch));
+        EXPECT_EQ(batch.string_dictionary.size(), 5u);
+        for (std::size_t row = 0; row < sas_row_count; ++row)
+        {
+            const int code = batch.string_codes.locate("name", row).value();
+            EXPECT_EQ(batch.string_dictionary[static_cast<std::size_t>(code)], sas_fixture_name(row));
+        }
+        ASSERT_TRUE(other_city_reader.next(batch));
+        EXPECT_EQ(batch.string_dictionary, (std::vector<std::string>{"paris", "", "rome", "oslo"}));
+    }
+
+    TEST(xio_sas, sas7bdat_dictionary)
+    {
+        // the threads decoding the second half of the rows meet the names
+        // in another order than the first thread
+        const char* filename = "test_xio_sas_dictionary.sas7bdat";
+        for (bool compressed : {false, true})
+        {
+            write_sas_file(filename, make_sas7bdat_file({false, false, compressed}));
+            sas_read_options options;
+            options.string_dictionary = true;
+            auto res = read_sas(filename, sas_format::sas7bdat, options);
+            EXPECT_EQ(res.strings.data().value().size(), 0u);
+            // ann, bob, dora, zed, paris, rome, oslo and the empty string
+            const auto& dictionary = res.string_dictionary;
+            EXPECT_EQ(dictionary.size(), 8u);
+            EXPECT_NE(std::find(dictionary.cbegin(), dictionary.cend(), ""), dictionary.cend());
+            for (std::size_t row = 0; row < sas_row_count; ++row)
+            {
+                const int name = res.string_codes.locate("name", row).value();
+                const int city = res.string_codes.locate("city", row).value();
+                EXPECT_EQ(dictionary[static_cast<std::size_t>(name)], sas_fixture_name(row));
+                EXPECT_EQ(dictionary[static_cast<std::size_t>(city)], sas_fixture_city(row));
+            }
+
+            for (std::size_t thread_count : {2, 4})
+            {
+                options.thread_count = thread_count;
+                auto par = read_sas(filename, sas_format::sas7bdat, options);
+                EXPECT_EQ(par.string_dictionary, res.string_dictionary);
+                EXPECT_EQ(par.string_codes, res.string_codes);
+            }
+        }
+        std::remove(filename);
+    }
+
+    TEST(xio_sas, dictionary_merge)
+    {
+        detail::xsas_dictionary dictionary;
+        EXPECT_EQ(dictionary.insert("x", 1), 0);
+        EXPECT_EQ(dictionary.insert("y  ", 3), 1);
+        detail::xsas_dictionary other;
+        EXPECT_EQ(other.insert("   ", 3), 0);
+        EXPECT_EQ(other.insert("y", 1), 1);
+        EXPECT_EQ(other.insert("z ", 2), 2);
+        EXPECT_EQ(other.insert("", 0), 0);
+        EXPECT_EQ(dictionary.merge(other), (std::vector<int>{2, 1, 3}));
+        EXPECT_EQ(dictionary.values(), (std::vector<std::string>{"x", "y", "", "z"}));
+    }
+
+    TEST(xio_sas, ibm_to_ieee)
+    {
+        // 1.0, -118.625, 0, missing values . and .A
+        const uint64_t ibm[5] = {0x4110000000000000ull, 0xC276A00000000000ull, 0, 0x2E00000000000000ull, 0x4100000000000000ull};
+        double ieee[5];
+        bool mask[5];
+        char codes[5];
+        detail::ibm_to_ieee(ibm, 5, ieee, mask, codes);
+        EXPECT_EQ(ieee[0], 1.);
+        EXPECT_EQ(ieee[1], -118.625);
+        EXPECT_EQ(ieee[2], 0.);
+        EXPECT_TRUE(mask[0] && mask[1] && mask[2]);
+        EXPECT_EQ(codes[2], '\0');
+        EXPECT_TRUE(std::isnan(ieee[3]));
+        EXPECT_FALSE(mask[3]);
+        EXPECT_EQ(codes[3], '.');
+        EXPECT_TRUE(std::isnan(ieee[4]));
+        EXPECT_FALSE(mask[4]);
+        EXPECT_EQ(codes[4], 'A');
+
+        // the codes are optional
+        detail::ibm_to_ieee(ibm, 5, ieee, mask, nullptr);
+        EXPECT_EQ(ieee[1], -118.625);
+        EXPECT_FALSE(mask[4]);
+    }
+
+    TEST(xio_sas, xport_file)
+    {
+        std::istringstream schema_stream(make_xport_file("0002"), std::ios::in | std::ios::binary);
+        auto schema = read_sas_schema(schema_stream, sas_format::xport);
+        EXPECT_EQ(schema.names, (std::vector<std::string>{"X", "NAME"}));
+        EXPECT_EQ(schema.labels, (std::vector<std::string>{"Value", ""}));
+        EXPECT_EQ(schema.formats, (std::vector<std::string>{"", "$CHAR"}));
+        EXPECT_EQ(schema.types, (std::vector<sas_column_type>{sas_column_type::number, sas_column_type::string}));
+        // the blank padding of the last record is not a row
+        EXPECT_EQ(schema.row_count, 3u);
+
+        std::istringstream is(make_xport_file("0002"), std::ios::in | std::ios::binary);
+        sas_read_options options;
+        options.missing_codes = true;
+        auto res = read_sas(is, sas_format::xport, options);
+        EXPECT_EQ(res.numbers.locate("X", std::size_t(0)).value(), 1.);
+        EXPECT_EQ(res.numbers.locate("X", std::size_t(1)).value(), -118.625);
+        EXPECT_FALSE(res.numbers.locate("X", std::size_t(2)).has_value());
+        EXPECT_EQ(res.missing_codes(0, 2), 'A');
+        EXPECT_EQ(res.strings.locate("NAME", std::size_t(0)).value(), "ab");
+        EXPECT_EQ(res.strings.locate("NAME", std::size_t(1)).value(), "cdef");
+        EXPECT_EQ(res.strings.locate("NAME", std::size_t(2)).value(), "g");
+    }
+
+    TEST(xio_sas, xport_variable_count)
+    {
+        // the namestr header does not match the namestr records
+        for (auto count : {"0001", "0003", "00x2"})
+        {
+            std::istringstream is(make_xport_file(count), std::ios::in | std::ios::binary);
+            EXPECT_THROW(read_sas_schema(is, sas_format::xport), std::runtime_error);
+        }
+    }
+
+    TEST(xio_sas, xport_v8_file)
+    {
+        for (int version : {8, 9})
+        {
+            std::istringstream schema_stream(make_xport_file("000002", version), std::ios::in | std::ios::binary);
+            auto schema = read_sas_schema(schema_stream, sas_format::xport);
+            EXPECT_EQ(schema.names, (std::vector<std::string>{"measurement_value", "NAME"}));
+            EXPECT_EQ(schema.labels, (std::vector<std::string>{xport_long_label, ""}));
+            EXPECT_EQ(schema.formats, (std::vector<std::string>{"", version == 9 ? "$CHARLONGFMT" : "$CHARLON"}));
+            EXPECT_EQ(schema.types, (std::vector<sas_column_type>{sas_column_type::number, sas_column_type::string}));
+            EXPECT_EQ(schema.row_count, 3u);
+
+            std::istringstream is(make_xport_file("000002", version), std::ios::in | std::ios::binary);
+            sas_read_options options;
+            options.columns = {"NAME", "measurement_value"};
+            auto res = read_sas(is, sas_format::xport, options);
+            EXPECT_EQ(res.numbers.locate("measurement_value", std::size_t(1)).value(), -118.625);
+            EXPECT_FALSE(res.numbers.locate("measurement_value", std::size_t(2)).has_value());
+            EXPECT_EQ(res.strings.locate("NAME", std::size_t(1)).value(), "cdef");
+
+            std::istringstream wrong_count(make_xport_file("000003", version), std::ios::in | std::ios::binary);
+            EXPECT_THROW(read_sas_schema(wrong_count, sas_format::xport), std::runtime_error);
+        }
+    }
+}
@@ -0,0 +1,83 @@
+/***************************************************************************
+* Copyright (c) Johan Mabille, Sylvain Corlay, Wolf Vollprecht and         *
+* Martin Renou                                                             *
+* Copyright (c) QuantStack                                                 *
+*                                                                          *
+* Distributed under the terms of the BSD 3-Clause License.                 *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include "gtest/gtest.h"
+#include "xframe/xoptional_bitmask.hpp"
+#include "test_fixture.hpp"
+
+namespace xf
+{
+    using bitmask_data_type = xbitmask_optional<double>;
+    using bitmask_variable_type = xvariable_container<coordinate_type, bitmask_data_type>;
+
+    // data = {{ 1. ,  2., N/A },
+    //         { N/A,  5.,  6. },
+    //         { 7. ,  8.,  9. }}
+    inline bitmask_data_type make_test_bitmask_data()
+    {
+        bitmask_data_type d = {{ 1., 2., 3.},
+                               { 4., 5., 6.},
+                               { 7., 8., 9.}};
+        d(0, 2).has_value() = false;
+        d(1, 0).has_value() = false;
+        return d;
+    }
+
+    inline bitmask_variable_type make_test_bitmask_variable()
+    {
+        return bitmask_variable_type(make_test_bitmask_data(), make_test_coordinate(), dimension_type({"abscissa", "ordinate"}));
+    }
+
+    TEST(xoptional_bitmask, kernels)
+    {
+        bitmask_data_type d1 = make_test_bitmask_data();
+        bitmask_data_type d2 = make_test_bitmask_data();
+        d2(2, 2).has_value() = false;
+        d2(0, 2).has_value() = true;
+
+        xbitmask_array m = d1.has_value();
+        EXPECT_EQ(bitmask_count(m), 7u);
+
+        bitmask_and(m, d2.has_value());
+        EXPECT_EQ(bitmask_count(m), 6u);
+        EXPECT_FALSE(m(0, 2));
+        EXPECT_FALSE(m(2, 2));
+
+        bitmask_or(m, d2.has_value());
+        EXPECT_EQ(bitmask_count(m), 7u);
+        EXPECT_TRUE(m(0, 2));
+
+        xbitmask_array m2 = xbitmask_array::from_shape({ 2, 2 });
+        EXPECT_THROW(bitmask_and(m, m2), std::runtime_error);
+    }
+
+    TEST(xoptional_bitmask, assign)
+    {
+        bitmask_variable_type a = make_test_bitmask_variable();
+        bitmask_variable_type b = make_test_bitmask_variable();
+        b.data()(2, 2).has_value() = false;
+
+        bitmask_variable_type res = a + b;
+        EXPECT_EQ(res.data()(0, 0), a.data()(0, 0) + b.data()(0, 0));
+        EXPECT_EQ(res.data()(1, 1), a.data()(1, 1) + b.data()(1, 1));
+        EXPECT_FALSE(res.data()(0, 2).has_value());
+        EXPECT_FALSE(res.data()(1, 0).has_value());
+        EXPECT_FALSE(res.data()(2, 2).has_value());
+        EXPECT_EQ(bitmask_count(res.data().has_value()), 6u);
+
+        res = res * 2.;
+        EXPECT_EQ(res.data()(0, 0), 2. * (a.data()(0, 0) + b.data()(0, 0)));
+        EXPECT_EQ(bitmask_count(res.data().has_value()), 6u);
+
+        res = a + res;
+        EXPECT_FALSE(res.data()(2, 2).has_value());
+        EXPECT_EQ(bitmask_count(res.data().has_value()), 6u);
+    }
+}